@@ -7,6 +7,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
+
+#include "../graphStats.h"
 
 
 struct hashTable;
@@ -26,6 +29,8 @@ typedef struct nodeHashTable {
   double key_double;
   int    value;
   u_int  graph_predecessor;
+  unsigned long hash;           // of key, cached by the table when the node is inserted
+  bool   key_in_arena;          // key is in the table's key arena, not freed with the node
   struct nodeHashTable *next;
   struct nodeHashTable *prev;
 } nodeHashTable;
@@ -42,7 +47,7 @@ nodeHashTable* nodeHashTable_string(char *key, int value)
     exit(EXIT_FAILURE);
   }
 
-  new->key = (char*)malloc(sizeof(*key) * strlen(key));
+  new->key = (char*)malloc(sizeof(*key) * (strlen(key) + 1));
   if (new->key == NULL) {
     perror("malloc");
     fprintf(stderr, "failed to allocate memory");
@@ -52,8 +57,11 @@ nodeHashTable* nodeHashTable_string(char *key, int value)
   new->key_int = 0;
   new->key_double = 0.0;
   new->value = value;
+  new->hash = 0;
+  new->key_in_arena = false;
   new->next = new->prev = NULL;
-  memcpy(new->key, key, sizeof(*key) * strlen(key));
+  GRAPH_STAT_ADD(allocations, 2);
+  memcpy(new->key, key, sizeof(*key) * (strlen(key) + 1));
 
   return new;
 }
@@ -64,6 +72,23 @@ nodeHashTable* nodeHashTable_string(char *key, int value)
  */
 hashTable* hashTableBuild();
 
+/* Flags of hashTableBuildWith, combine with | */
+#define HASH_TABLE_INCREMENTAL 0x1u   // resize a few slots per operation rather than all at once
+#define HASH_TABLE_KEY_ARENA   0x2u   // hashTableInsert copies keys into an arena, freed as a whole
+
+/* Create a new, empty, hash table with the options given by flags.
+ * HASH_TABLE_INCREMENTAL: no operation pays for re-hashing the whole table;
+ *   while the table grows or shrinks, each operation moves a few slots (at
+ *   most 8, and that of its key), and the old array is empty before the next
+ *   resize. Searches move
+ *   slots too, so they write to the table (see hashTableSearch).
+ * HASH_TABLE_KEY_ARENA: keys of hashTableInsert take no malloc of their own,
+ *   and are all released by hashTableFree / hashTableEmpty at once.
+ * @return returns a pointer to the hash table on the heap
+ * @NOTE hashTableEmpty keeps the flags
+ */
+hashTable* hashTableBuildWith(unsigned int flags);
+
 /* Given your hash table, it will empty all its contents.
  * The table will return to default size.
  */
@@ -76,12 +101,14 @@ int hashTableIsEmpty(hashTable *table);
 
 /* Free all memory allocated for the hash table, including all nodes
  * @NOTE if you wish to preserve the nodes, call free(table) instead
+ *       (only for tables from hashTableBuild that are not being resized)
  * @NOTE frees nodes assuming memory was allocated seperately to both key and to struct
  */
 void hashTableFree(hashTable *table);
 
 /* Free memory allocated to a single node.
- * @NOTE assumes memory was allocated seperately to both key and to struct only
+ * @NOTE assumes memory was allocated seperately to both key and to struct only,
+ *       or that the key is in a table's key arena (node->key_in_arena)
  */
 void hashTableFreeNode(nodeHashTable *node);
 
@@ -109,6 +136,9 @@ void hashTableInsert(hashTable **table, char *key, int value);
  * @param table pointer to the hash table
  * @param key the key of the element to find
  * @return pointer to the found node or NULL.
+ * @NOTE with HASH_TABLE_INCREMENTAL the search moves slots of a resize in
+ *   progress, so it writes to the table: concurrent searches need the same
+ *   exclusive lock as inserts and deletes. So does hashTableSearchNode.
  */
 nodeHashTable* hashTableSearch(hashTable *table, char *key);
 
@@ -171,6 +201,7 @@ char* keyConvertFromInt(void* key)
 {
   int key_size_needed = snprintf(NULL, 0, "%d", *(int*)key) + 1;
   char *hashable_key = (char*)malloc(key_size_needed);
+  GRAPH_STAT_ADD(allocations, 1);
   snprintf(hashable_key, key_size_needed, "%d", *(int*)key);
   return hashable_key;
 }
@@ -198,7 +229,10 @@ nodeHashTable* nodeHashTable_int(int key, int value, u_int graph_predecessor)
   new->key_double = 0.0;
   new->value = value;
   new->graph_predecessor = graph_predecessor;
+  new->hash = 0;
+  new->key_in_arena = false;
   new->next = new->prev = NULL;
+  GRAPH_STAT_ADD(allocations, 2);
 
   char *hashable_key = keyConvertFromInt(&key);
   memcpy(new->key, hashable_key, key_size_needed);
@@ -218,6 +252,7 @@ char* keyConvertFromDouble(void* key)
 {
   int key_size_needed = snprintf(NULL, 0, "%.8f", *(double*)key) + 1;
   char *hashable_key = (char*)malloc(key_size_needed);
+  GRAPH_STAT_ADD(allocations, 1);
   snprintf(hashable_key, key_size_needed, "%.8f", *(double*)key);
   return hashable_key;
 }
@@ -244,7 +279,11 @@ nodeHashTable* nodeHashTable_double(double key, int value)
   new->key_double = key;
   new->key_int = 0;
   new->value = value;
+  new->graph_predecessor = 0;
+  new->hash = 0;
+  new->key_in_arena = false;
   new->next = new->prev = NULL;
+  GRAPH_STAT_ADD(allocations, 2);
 
   char *hashable_key = keyConvertFromDouble(&key);
   memcpy(new->key, hashable_key, key_size_needed);
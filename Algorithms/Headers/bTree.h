@@ -0,0 +1,130 @@
+/** Makes available a counted B+ tree: a sorted multiset of Integer (int) keys,
+ ** each with an int value, held in wide nodes of many keys.
+ ** Besides search, insert and delete, it answers rank and select queries in
+ ** O(lg n), builds in O(n) from a sorted array, and scans ranges in key order.
+ ** Companion to the AVL tree of avlTree.h, which allocates one node per key.
+ **/
+
+#ifndef B_TREE_INT
+#define B_TREE_INT
+
+#include <stddef.h>
+
+
+struct BTreeNode;
+
+/* The tree is kept on the heap behind an opaque pointer. */
+struct BTree;
+typedef struct BTree BTree;
+
+
+/* Position in the tree for in order scans.
+ * It can be initialized on the stack by BTreeSeek or BTreeSeekRank.
+ * Any insert or delete invalidates all iterators of the tree. */
+struct BTreeIterator {
+  struct BTreeNode *leaf;
+  int pos;
+};
+
+typedef struct BTreeIterator BTreeIterator;
+
+
+#define BTREE_MIN_ORDER      4
+#define BTREE_MAX_ORDER      64
+#define BTREE_DEFAULT_ORDER  32
+
+
+/* Create a new, empty, tree.
+ * @param order: most keys a node holds, clamped to [BTREE_MIN_ORDER, BTREE_MAX_ORDER],
+ *               or 0 for BTREE_DEFAULT_ORDER. 16 to 64 keys per node fill one to
+ *               four cache lines, so a lookup touches a few lines per level of a
+ *               tree of only log_order(n) levels.
+ * @return pointer to the tree on the heap */
+BTree* BTreeBuild(unsigned int order);
+
+
+/* Create a tree holding the n keys of a sorted array, in O(n) time.
+ * Nodes are filled evenly and close to full, tighter than inserts leave them.
+ * @param keys:   n keys in non decreasing order
+ * @param values: n values, values[i] for keys[i]; or NULL to store i for keys[i]
+ * @param n:      number of keys
+ * @param order:  as for BTreeBuild
+ * @return pointer to the tree on the heap */
+BTree* BTreeBuildSorted(const int *keys, const int *values, size_t n, unsigned int order);
+
+
+/* Free the tree and all of its nodes. */
+void BTreeFree(BTree *tree);
+
+
+/* @return the number of keys in the tree */
+size_t BTreeSize(BTree *tree);
+
+
+/* Search the tree for a key.
+ * If duplicate keys exist, finds the first in order (the first inserted).
+ * @param tree:  pointer to the tree
+ * @param key:   the key to find in the tree
+ * @param value: set to the value of key if found (may be NULL)
+ * @return 1 if key is in the tree, 0 otherwise */
+int BTreeSearch(BTree *tree, int key, int *value);
+
+
+/* Insert a key into the tree. Duplicate keys are kept, after the equal keys
+ * already in the tree.
+ * @param tree:  pointer to the tree
+ * @param key:   the key to insert
+ * @param value: the value stored with key */
+void BTreeInsert(BTree *tree, int key, int value);
+
+
+/* Delete the first key equal to key from the tree.
+ * @param tree:  pointer to the tree
+ * @param key:   the key to delete
+ * @param value: set to the value of the deleted key (may be NULL)
+ * @return 1 if a key was deleted, 0 if key is not in the tree */
+int BTreeDelete(BTree *tree, int key, int *value);
+
+
+/* Rank of a key: number of keys in the tree smaller than key.
+ * Key need not be in the tree; BTreeRank(hi) - BTreeRank(lo) counts the keys in [lo, hi).
+ * @param tree: pointer to the tree
+ * @param key:  the key to rank
+ * @return number of keys < key */
+size_t BTreeRank(BTree *tree, int key);
+
+
+/* Select the key of a given rank: the (rank+1)-th smallest key.
+ * @param tree:  pointer to the tree
+ * @param rank:  0 for the smallest key, BTreeSize(tree)-1 for the largest
+ * @param key:   set to the key found (may be NULL)
+ * @param value: set to its value (may be NULL)
+ * @return 1 if rank < BTreeSize(tree), 0 otherwise */
+int BTreeSelect(BTree *tree, size_t rank, int *key, int *value);
+
+
+/* Position an iterator at the first key >= key (BTreeSeek(tree, INT_MIN, it) for the
+ * smallest key of the tree).
+ * @param tree: pointer to the tree
+ * @param key:  lower bound of the scan
+ * @param it:   the iterator to position */
+void BTreeSeek(BTree *tree, int key, BTreeIterator *it);
+
+
+/* Position an iterator at the key of a given rank.
+ * @param tree: pointer to the tree
+ * @param rank: rank of the first key of the scan
+ * @param it:   the iterator to position */
+void BTreeSeekRank(BTree *tree, size_t rank, BTreeIterator *it);
+
+
+/* Read the key at the iterator and advance it to the next key in order.
+ * Usage:  for (BTreeSeek(tree, lo, &it); BTreeIteratorNext(&it, &key, &value) && key < hi; )
+ * @param it:    an iterator positioned by BTreeSeek or BTreeSeekRank
+ * @param key:   set to the key (may be NULL)
+ * @param value: set to its value (may be NULL)
+ * @return 1 if a key was read, 0 if the iterator is past the largest key */
+int BTreeIteratorNext(BTreeIterator *it, int *key, int *value);
+
+
+#endif
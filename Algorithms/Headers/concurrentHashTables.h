@@ -0,0 +1,79 @@
+/** Makes available my implementation of a hash table with string keys that
+ ** many threads may use at once, without a lock of their own.
+ ** The table is split into shards, each a chaining hash table guarded by its
+ ** own reader-writer lock and resized on its own: threads only wait for one
+ ** another when they work on the same shard, and then only if one writes.
+ **/
+
+#ifndef CONCURRENT_HASH_TABLE_H
+#define CONCURRENT_HASH_TABLE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+
+struct concurrentHashTable;
+typedef struct concurrentHashTable concurrentHashTable;
+
+
+/* Create a new, empty, hash table.
+ * @param shards number of independently locked parts, rounded up to a power
+ *        of two; 0 for four per online processor
+ * @return returns a pointer to the hash table on the heap
+ */
+concurrentHashTable* concurrentHashTableBuild(unsigned int shards);
+
+/* Free all memory allocated for the hash table
+ * @NOTE no other thread may be using the table
+ */
+void concurrentHashTableFree(concurrentHashTable *table);
+
+/* @return the number of elements in the table
+ * @NOTE a snapshot: other threads may be changing the table meanwhile
+ */
+size_t concurrentHashTableSize(concurrentHashTable *table);
+
+/* Hash table insert
+ * @param table pointer to the hash table
+ * @param key the key of the element to insert, copied into the table
+ * @param value the value of the element to insert
+ * @return 1 if key was new, 0 if an existing element was overwritten
+ */
+int concurrentHashTableInsert(concurrentHashTable *table, const char *key, int value);
+
+/* Hash table search for membership.
+ * @param table pointer to the hash table
+ * @param key the key of the element to find
+ * @param value set to the element's value if found (may be NULL)
+ * @return 1 if key is in table, 0 otherwise
+ * @NOTE the value is copied out: no pointer into the table is handed out, as
+ *       another thread could delete the element the moment the lock is released
+ */
+int concurrentHashTableSearch(concurrentHashTable *table, const char *key, int *value);
+
+/* Hash table delete
+ * @param table pointer to the hash table
+ * @param key the key of the element to delete
+ * @return returns 1 if delete was made, otherwise 0
+ */
+int concurrentHashTableDelete(concurrentHashTable *table, const char *key);
+
+/* Atomic insert-or-update: read, compute and write the value of key as one
+ * step no other thread can come between (counters, running minimums, ...).
+ * @param table pointer to the hash table
+ * @param key the key of the element to update or insert
+ * @param update function computing the new value
+ *   @param value the current value, undefined if found is false
+ *   @param found whether key was in the table
+ *   @param arg the argument given to concurrentHashTableUpsert
+ *   @return the value to store
+ * @param arg passed on to update
+ * @param result set to the value stored (may be NULL)
+ * @return 1 if key was new, 0 if an existing element was updated
+ * @CAUTION update runs with the shard locked: it must not use the table
+ */
+int concurrentHashTableUpsert(concurrentHashTable *table, const char *key,
+			      int (*update)(int value, bool found, void *arg), void *arg, int *result);
+
+
+#endif
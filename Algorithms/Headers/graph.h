@@ -6,13 +6,15 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "Graphs/hashTables.h"
+#include "graphStats.h"
 
 
 /* Feel free to modify this struct here as you please.
  * Leave alone the id property as it is used by the graph.
- * Leave alone the next pointer as well.
+ * Leave alone the next and prev pointers as well.
  * @CAUTION functions below that free memory assumes this
  *          struct can be freed in a single call to free().
  *          Otherwies, further modify below initializer.
@@ -20,8 +22,8 @@
 typedef struct graph_vertex {
   unsigned int id;
   int value;
-  int heap_pos;
   struct graph_vertex *next;
+  struct graph_vertex *prev;
 } graph_vertex;
 
 
@@ -39,6 +41,30 @@ typedef struct adjacencyListNode_t {
 } adjacencyListNode_t;
 
 
+/* Memory pool from which a graph built with graphBuildWithArena takes its
+ * adjacency list nodes (and, through graphArenaVertexNew, its vertices).
+ * Memory is handed out from large chunks; nodes of removed edges are kept in
+ * a free list for reuse. All of it is released at once by graphFree, along
+ * with the member vertices that came from malloc (graphVertexNew).
+ * The user is shielded from the need to use these structs.
+ */
+typedef struct graph_arena_chunk_t {
+  struct graph_arena_chunk_t *next;
+  size_t    size;              // in bytes, of data
+  size_t    used;              // in bytes, of data
+  uint64_t  data[];            // uint64_t for alignment
+} graph_arena_chunk_t;
+
+typedef struct graph_arena_t {
+  graph_arena_chunk_t *chunks;     // head is the chunk currently handed out from
+  adjacencyListNode_t *free_edges; // recycled nodes, linked through next
+  graph_arena_chunk_t **sorted;    // the chunks by address, to find the one a vertex is in
+  size_t               num_chunks;
+  uint64_t            *heap_ids;   // bit per id of the member vertices not in a chunk
+  size_t               heap_words;
+} graph_arena_t;
+
+
 /* This struct represents the graph.
  * Maintains the needed properties to manage memory
  * allocation.
@@ -50,10 +76,155 @@ typedef struct graph_t {
   bool          pseudoGraph;
   bool          weighted;
   graph_vertex* vertex_head;
+  graph_vertex** vertex_index; // listSize entries: the member vertex with each id, or NULL
+  unsigned int*  degree_out;   // listSize entries: number of nodes in list[id]
+  unsigned int*  degree_in;    // listSize entries: number of nodes, in all lists, leading to id
+  adjacencyListNode_t** reverse; // NULL unless graphEnableReverse: listSize lists of in-edges
+  graph_arena_t* arena;        // NULL unless built with graphBuildWithArena
+  uint64_t*      matrix;       // NULL unless graphEnableMatrix: listSize rows of matrix_words
+  size_t         matrix_words; //   words, bit j of row i set if an edge i -> j exists
   adjacencyListNode_t* list[];
 } graph_t;
 
 
+/* This struct represents an immutable snapshot of a graph in compressed
+ * sparse row (CSR) form, see graphFreeze. The out-edges of the vertex with
+ * id i are the positions [offsets[i], offsets[i+1]) of targets and weights.
+ * Ids that are not members of the graph simply have no edges.
+ * The snapshot does not reference the graph it was built from: the graph
+ * may be mutated or freed while the snapshot lives on.
+ * A snapshot opened with graphMapBinary has its arrays in a read-only file
+ * mapping (mapping is NULL otherwise); it must not be written to.
+ */
+typedef struct graph_csr_t {
+  unsigned int  numVertex;
+  unsigned int  listSize;
+  uint64_t      numEdge;
+  bool          weighted;
+  uint32_t     *vertex_ids;    // member ids, in the order of graph's vertex_head
+  uint64_t     *offsets;       // listSize + 1 entries
+  uint32_t     *targets;       // numEdge entries: id of edge's destination
+  int32_t      *weights;       // numEdge entries: weight of edge
+  void         *mapping;       // file mapping the arrays point into, see graphMapBinary
+  size_t        mapping_size;
+} graph_csr_t;
+
+
+/* This struct holds the result of a traversal or shortest path search in
+ * arrays indexed directly by vertex id, see breadthFirstSearchDense.
+ * dist is the depth (BFS/DFS) or distance (shortest paths) of the vertex,
+ * INT_MAX if it was not reached; pred is the id of its predecessor, -1 if
+ * it is a root or was not reached; visited is a bitset of reached vertices.
+ * Use graphDenseToHashTable if the hash table form is needed.
+ */
+typedef struct graph_dense_t {
+  unsigned int  size;          // number of entries: graph's listSize at time of search
+  int          *dist;
+  int          *pred;
+  uint64_t     *visited;       // (size + 63) / 64 words
+} graph_dense_t;
+
+
+/* Test whether a vertex id was reached by the search that produced result
+ * @return true if reached, false otherwise (also if id is out of range)
+ */
+static inline
+bool graphDenseVisited(const graph_dense_t *result, unsigned int id)
+{
+  return id < result->size && (result->visited[id >> 6] >> (id & 63)) & 1;
+}
+
+static inline
+void graphDenseMarkVisited(graph_dense_t *result, unsigned int id)
+{
+  result->visited[id >> 6] |= UINT64_C(1) << (id & 63);
+}
+
+
+/* This struct represents a single path, the answer to a point-to-point query
+ * such as shortestPath_dijkstraTarget. vertices holds the ids along the path,
+ * from source to target. If target is not reachable, dist is INT_MAX, length
+ * is 0 and vertices is NULL. Free with graphPathFree.
+ */
+typedef struct graph_path_t {
+  int           dist;
+  unsigned int  length;
+  unsigned int *vertices;
+} graph_path_t;
+
+
+/* This struct holds the landmark tables used by shortestPath_ALT. For each of
+ * the count landmarks, forward[l * size + v] is the distance from landmark l to
+ * vertex v and backward[l * size + v] the distance from v to landmark l
+ * (INT_MAX where there is no path). Build with graphLandmarksBuild, or load
+ * tables saved earlier with graphLandmarksLoad; free with graphLandmarksFree.
+ */
+typedef struct graph_landmarks_t {
+  unsigned int  count;
+  unsigned int  size;          // entries per landmark: graph's listSize
+  unsigned int *ids;           // vertex id of each landmark
+  int          *forward;
+  int          *backward;
+} graph_landmarks_t;
+
+
+/* This struct keeps the shortest paths from one source up to date while the
+ * edges of graph change, see graphDynamicSSSPBuild. paths holds the distance
+ * and predecessor of every vertex, as dijkstraDense returns them; it may be
+ * read at any time. The other members are workspace: the user is shielded
+ * from the need to use them.
+ */
+struct indexedHeap;
+
+typedef struct graph_dynamic_sssp_t {
+  graph_t            *graph;
+  unsigned int        source;
+  graph_dense_t      *paths;
+  struct indexedHeap *heap;
+  unsigned int       *subtree;      // listSize: vertices whose distance is being recomputed
+  bool               *in_subtree;   // listSize
+} graph_dynamic_sssp_t;
+
+
+/* This struct holds a topological order of a DAG split into levels, see
+ * graphCSRTopologicalLevels. Level l is order[offsets[l] .. offsets[l+1]):
+ * the vertices whose in-edges all come from levels before l. No edge joins
+ * two vertices of one level. offsets has numLevels + 1 entries. count is the
+ * number of ids in order; less than the graph's numVertex if it has a cycle.
+ */
+typedef struct graph_levels_t {
+  unsigned int  count;
+  unsigned int  numLevels;
+  uint32_t     *order;
+  uint32_t     *offsets;
+} graph_levels_t;
+
+
+/* This struct holds a renumbering of a graph's vertices, see graphReorder.
+ * The member vertices get the new ids 0 .. count-1: new_to_old[n] is the old
+ * id of the vertex with new id n, and old_to_new[o] the new id of the vertex
+ * with old id o (UINT32_MAX for ids of no member). size is the old listSize.
+ */
+typedef struct graph_permutation_t {
+  unsigned int  size;
+  unsigned int  count;
+  uint32_t     *old_to_new;    // size entries
+  uint32_t     *new_to_old;    // count entries
+} graph_permutation_t;
+
+
+/* Vertex orderings of graphReorder */
+#define GRAPH_REORDER_RCM     0   // reverse Cuthill-McKee: the ends of each edge close together
+#define GRAPH_REORDER_DEGREE  1   // by decreasing degree: hubs first
+#define GRAPH_REORDER_BFS     2   // in the order a BFS from a root discovers them
+
+
+/* Flags of graphBuildFromEdgeList, combine with | */
+#define GRAPH_EDGES_MULTIGRAPH  0x1u   // keep parallel edges: graph is a MultiGraph
+#define GRAPH_EDGES_PSEUDOGRAPH 0x2u   // allow self loops: graph is a PseudoGraph (and MultiGraph)
+#define GRAPH_EDGES_UNDIRECTED  0x4u   // each pair is an undirected edge
+
+
 /* Sample function to instantiate a vertex for the graph
  * @return pointer to a node on the heap
  */
@@ -67,8 +238,8 @@ graph_vertex* graphVertexNew(int id, int value)
   }
   new->id = id;
   new->value = value;
-  new->heap_pos = 0;
   new->next = NULL;
+  new->prev = NULL;
 
   return new;
 }
@@ -79,10 +250,20 @@ graph_vertex* graphVertexNew(int id, int value)
 /*            details below       */
 
 graph_t* graphBuild         (bool, bool);
+graph_t* graphBuildWithArena(bool, bool);
+graph_t* graphBuildWithMatrix(bool, bool);
+graph_t* graphBuildFromEdgeList(const uint32_t*, const uint32_t*, const int*, size_t, unsigned int);
+graph_t* graphLoadEdgeList   (const char*, unsigned int);
+int      graphReadEdgeList   (const char*,
+                              void (*batch)(const uint32_t*, const uint32_t*, const int*, size_t, void*), void*);
+int      graphConvertEdgeList(const char*, const char*, unsigned int);
+graph_vertex* graphArenaVertexNew(graph_t*, int, int);
 graph_t* graphBuildTranspose(graph_t*);
 int  graphAddVertex     (graph_t**, graph_vertex*);
 void graphRemoveVertexU (graph_t*,  graph_vertex*);
 void graphRemoveVertexD (graph_t*,  graph_vertex*);
+void graphEnableReverse (graph_t*);
+void graphEnableMatrix  (graph_t*);
 
 /*            Adding Edges        */
 void graphAddEdgeU      (graph_t*, graph_vertex*, graph_vertex*);
@@ -95,41 +276,105 @@ void graphRemoveEdgeU      (graph_t*, graph_vertex*, graph_vertex*);
 void graphRemoveEdgeD      (graph_t*, graph_vertex*, graph_vertex*);
 void graphRemoveEdgeWeightU(graph_t*, graph_vertex*, graph_vertex*, int);
 void graphRemoveEdgeWeightD(graph_t*, graph_vertex*, graph_vertex*, int);
+bool graphSetEdgeWeightD   (graph_t*, graph_vertex*, graph_vertex*, int, int);
 
 /*            Analysis            */
 bool graphExistsVertex   (graph_t*, graph_vertex*);
+graph_vertex* graphVertexById(graph_t*, unsigned int);
 bool graphExistsEdge     (graph_t*, graph_vertex*, graph_vertex*);
 int  graphExistsCycle    (graph_t*);
 void graphCycleEnum      (graph_t*);
+size_t graphCycleEnumerate(graph_t*, unsigned int, size_t,
+                           int (*sink)(const unsigned int*, unsigned int, void*), void*);
 int  graphVertexDegreeU  (graph_t*, graph_vertex*);
 int  graphVertexDegreeOut(graph_t*, graph_vertex*);
 int  graphVertexDegreeIn (graph_t*, graph_vertex*);
 bool vertexReachable     (graph_t*, graph_vertex*, graph_vertex*);
+void vertexReachableMulti(graph_t*, graph_vertex**, unsigned int, graph_vertex*, bool*);
 
 /*            Advanced Analysis   */
 void       printStronglyConnectedComponents    (graph_t*);
 hashTable* stronglyConnectedComponents         (graph_t*);
+int*       stronglyConnectedComponentsTarjan   (graph_t*, unsigned int*);
 void       singleSourceShortestPath_print      (hashTable*, int);
 hashTable* singleSourceShortestPath_DAG        (graph_t*, graph_vertex*);
 hashTable* singleSourceShortestPath_dijkstra   (graph_t*, graph_vertex*);
 hashTable* singleSourceShortestPath_bellmanFord(graph_t*, graph_vertex*);
+graph_path_t* shortestPath_dijkstraTarget      (graph_t*, graph_vertex*, graph_vertex*);
+graph_path_t* shortestPath_bidirectional       (graph_t*, graph_t*, graph_vertex*, graph_vertex*);
+graph_path_t* shortestPath_ALT                  (graph_t*, graph_landmarks_t*, graph_vertex*, graph_vertex*);
+void          graphPathPrint                   (graph_path_t*);
+void          graphPathFree                    (graph_path_t*);
+graph_dynamic_sssp_t* graphDynamicSSSPBuild     (graph_t*, graph_vertex*);
+void          graphDynamicSSSPFree             (graph_dynamic_sssp_t*);
+void          graphDynamicSSSPAddEdge          (graph_dynamic_sssp_t*, graph_vertex*, graph_vertex*, int);
+void          graphDynamicSSSPRemoveEdge       (graph_dynamic_sssp_t*, graph_vertex*, graph_vertex*, int);
+void          graphDynamicSSSPSetWeight        (graph_dynamic_sssp_t*, graph_vertex*, graph_vertex*, int, int);
+graph_landmarks_t* graphLandmarksBuild         (graph_t*, graph_t*, unsigned int);
+int                graphLandmarksSave          (graph_landmarks_t*, const char*);
+graph_landmarks_t* graphLandmarksLoad          (const char*);
+void               graphLandmarksFree          (graph_landmarks_t*);
 
 /*            Traversal           */
 hashTable* breadthFirstSearch(graph_t*, graph_vertex*);
 void graphShortestPathEnum   (hashTable*, int);
 void breadthFirstApply       (graph_t*, graph_vertex*,
                               void (*apply)(graph_vertex*, int, void*), void*);
+void breadthFirstApplyMulti  (graph_t*, graph_vertex**, unsigned int,
+                              void (*apply)(graph_vertex*, unsigned int, int, void*), void*);
   // example functions to use in place of apply():
   void printVertex     (graph_vertex*, int, void*);
   void scaleVertexValue(graph_vertex*, int, void*);
 
 hashTable*    depthFirstSearch(graph_t*);
 graph_vertex* topologicalSort (graph_t*);
+unsigned int  graphTopologicalOrder(graph_t*, uint32_t*);
+
+/*            Dense Results       */
+graph_dense_t* graphDenseBuild          (unsigned int);
+void           graphDenseFree           (graph_dense_t*);
+hashTable*     graphDenseToHashTable    (graph_dense_t*, graph_t*);
+graph_dense_t* breadthFirstSearchDense  (graph_t*, graph_vertex*);
+graph_dense_t* depthFirstSearchDense    (graph_t*);
+graph_dense_t* dijkstraDense            (graph_t*, graph_vertex*);
+graph_dense_t* bellmanFordDense         (graph_t*, graph_vertex*);
+
+/*            CSR Snapshots       */
+graph_csr_t* graphFreeze        (graph_t*);
+graph_csr_t* graphCSRTranspose  (graph_csr_t*);
+void         graphCSRFree       (graph_csr_t*);
+int          graphWriteBinary   (graph_t*, const char*);
+int          graphCSRWriteBinary(graph_csr_t*, const char*);
+graph_csr_t* graphMapBinary     (const char*, bool);
+graph_csr_t* graphCreateBinary  (const char*, unsigned int, unsigned int, uint64_t, bool);
+int          graphFinishBinary  (graph_csr_t*);
+hashTable*   breadthFirstSearchCSR              (graph_csr_t*, unsigned int);
+hashTable*   depthFirstSearchCSR                (graph_csr_t*);
+hashTable*   singleSourceShortestPath_dijkstraCSR(graph_csr_t*, unsigned int);
+hashTable*   stronglyConnectedComponentsCSR     (graph_csr_t*);
+graph_dense_t* breadthFirstSearchParallel       (graph_csr_t*, graph_csr_t*, unsigned int, unsigned int);
+graph_dense_t* singleSourceShortestPath_deltaStepping(graph_csr_t*, unsigned int, int, unsigned int);
+void           singleSourceShortestPath_batch   (graph_csr_t*, const unsigned int*, size_t, unsigned int, int*);
+graph_levels_t* graphCSRTopologicalLevels       (graph_csr_t*, unsigned int);
+void            graphLevelsFree                 (graph_levels_t*);
+graph_dense_t*  singleSourceShortestPath_DAGParallel(graph_csr_t*, graph_levels_t*, unsigned int, bool, unsigned int);
+
+/*            Reordering          */
+graph_t*             graphReorder        (graph_t*, unsigned int, unsigned int, graph_permutation_t**);
+graph_csr_t*         graphCSRReorder     (graph_csr_t*, unsigned int, unsigned int, graph_permutation_t**);
+graph_permutation_t* graphCSROrdering    (graph_csr_t*, unsigned int, unsigned int);
+graph_csr_t*         graphCSRPermute     (graph_csr_t*, graph_permutation_t*);
+void                 graphPermutationFree(graph_permutation_t*);
 
 /*            Miscellaneous       */
 void graphFree (graph_t*);
 void graphPrint(graph_t*);
 
+/*            Instrumentation     */
+  // counters of work done, compiled in with -DGRAPH_STATS, see graphStats.h:
+  graph_stats_t graphStatsRead (void);
+  void          graphStatsReset(void);
+
 /*                                */
 /*            End of Summary      */
 /*                                */
@@ -143,11 +388,110 @@ void graphPrint(graph_t*);
 graph_t* graphBuild(bool, bool);
 
 
+/* Returns a new, empty graph whose adjacency list nodes are allocated from
+ * a memory pool (an arena) rather than one malloc each. Prefer this for large
+ * graphs: building is faster, nodes sit close together in memory (faster
+ * traversal), and graphFree releases the whole pool at once.
+ * @param true if you want a MultiGraph, otherwise false
+ * @param true if MultiGraph is also to be a PseudoGraph
+ * @NOTE otherwise the graph behaves exactly like one from graphBuild. Vertices
+ *   may come from graphArenaVertexNew (in the pool) or graphVertexNew; graphFree
+ *   frees the latter one by one and releases the former with the pool
+ */
+graph_t* graphBuildWithArena(bool, bool);
+
+
+/* Returns a new, empty graph that keeps a bit adjacency matrix next to its
+ * adjacency list, see graphEnableMatrix. Prefer this for dense graphs: testing
+ * for an edge, and so adding one to a graph that is not a MultiGraph, is O(1),
+ * and breadth-first search reads 64 neighbors at a time.
+ * @param true if you want a MultiGraph, otherwise false
+ * @param true if MultiGraph is also to be a PseudoGraph
+ * @NOTE otherwise the graph behaves exactly like one from graphBuild
+ */
+graph_t* graphBuildWithMatrix(bool, bool);
+
+
+/* Returns a new graph holding the m edges src[i] -> dst[i], built in bulk.
+ * Much faster than adding the edges one at a time: degrees are counted first,
+ * all adjacency list nodes are allocated in one block, and duplicates are found
+ * by sorting each vertex's list rather than searching it for every new edge.
+ * @param array of the m source ids
+ * @param array of the m destination ids
+ * @param array of the m edge weights, or NULL for an unweighted graph
+ * @param m, the number of edges
+ * @param GRAPH_EDGES_* flags, or 0 for a simple directed graph
+ * @return a pointer to the graph on the heap, as if from graphBuildWithArena,
+ *         with a vertex (value 0) for each id that is an endpoint of an edge
+ * @NOTE unless the graph is a MultiGraph, parallel edges are dropped; as with
+ *       graphAddEdge*, the first of them (in input order) is the one kept.
+ * @NOTE each adjacency list comes out sorted by destination id.
+ * @NOTE as with graphAddEdge*, self loops require a PseudoGraph
+ */
+graph_t* graphBuildFromEdgeList(const uint32_t*, const uint32_t*, const int*, size_t, unsigned int);
+
+
+/* Reads a text file of edges, one "source destination [weight]" per line, and
+ * builds the graph with graphBuildFromEdgeList (see graphEdgeList.c)
+ * @param the path of the file; gzip'd if the library is built with GRAPH_ZLIB
+ * @param GRAPH_EDGES_* flags, as for graphBuildFromEdgeList
+ * @return a pointer to the graph on the heap, or NULL if the file could not
+ *   be read or has a line that is not an edge (reported on stderr)
+ */
+graph_t* graphLoadEdgeList(const char*, unsigned int);
+
+
+/* Streams the edges of a text file (see graphLoadEdgeList) to a callback, in
+ * batches. The file is read by a second thread while the caller's parses it.
+ * @param the path of the file; gzip'd if the library is built with GRAPH_ZLIB
+ * @param function called, in the caller's thread, with the source ids, the
+ *   destination ids, the weights (NULL if the first edge of the file has none)
+ *   and the number of edges of each batch, and the last parameter below.
+ *   The arrays are reused: copy what is needed before returning.
+ * @param pointer passed to batch as is
+ * @return 0 on success, 1 if the file could not be read or has a line that
+ *   is not an edge (reported on stderr with its line number). The batches of
+ *   the edges before such a line may have been delivered already.
+ * @NOTE lines beginning with '#' or '%' are comments; columns may be separated
+ *   by blanks, tabs or commas, and columns after the weight are ignored
+ */
+int graphReadEdgeList(const char*,
+                      void (*batch)(const uint32_t*, const uint32_t*, const int*, size_t, void*), void*);
+
+
+/* Converts a text file of edges (see graphLoadEdgeList) to a binary graph file
+ * for graphMapBinary, without holding the edges in memory: the input is read
+ * twice, and the edges are written straight to their place in the output.
+ * @param the path of the text file; gzip'd if the library is built with GRAPH_ZLIB
+ * @param the path of the binary file to (over)write
+ * @param GRAPH_EDGES_UNDIRECTED to add every edge in both directions, or 0
+ * @return 0 on success, 1 on failure (reported on stderr; no output is left)
+ * @NOTE member ids are those that are an endpoint of an edge, listSize is the
+ *   largest id + 1. Edges are kept as they are in the file, in file order for
+ *   each source, parallel edges and self loops included.
+ */
+int graphConvertEdgeList(const char*, const char*, unsigned int);
+
+
+/* Instantiates a vertex in the arena of a graph built with graphBuildWithArena
+ * (for any other graph it behaves as graphVertexNew). Such a vertex is freed
+ * along with the graph by graphFree, even if it was removed from the graph.
+ * Add it only to the graph whose arena holds it.
+ * @param the graph whose arena should hold the vertex
+ * @param the id of the vertex
+ * @param the value of the vertex
+ * @return pointer to the vertex; add it to the graph with graphAddVertex
+ * @CAUTION never call free() on a vertex allocated this way
+ */
+graph_vertex* graphArenaVertexNew(graph_t*, int, int);
+
+
 /* Returns a new graph that is the transpose of the input graph.
  * @param graph that is to be transposed
- * @NOTE: input graph must be directed graph with un-weighted edges.
+ * @NOTE: input graph must be directed graph.
  *   (the transpose of an undirected graph is simply itself)
- *   (transposing a weighted graph is not supported by this function)
+ *   (if the graph is weighted, each reversed edge keeps its weight)
+ *   (if the graph has an arena, so does its transpose, vertices included)
  * @return a pointer to the transposed graph on the heap
  */
 graph_t* graphBuildTranspose(graph_t*);
@@ -250,6 +594,19 @@ void graphRemoveEdgeWeightU(graph_t*, graph_vertex*, graph_vertex*, int);
 void graphRemoveEdgeWeightD(graph_t*, graph_vertex*, graph_vertex*, int);
 
 
+/* Changes the weight of an existing directed edge from vertex one to two
+ * @param the graph in which to change an edge
+ * @param struct representing the source vertex of the edge
+ * @param struct representing the destination vertex of the edge
+ * @param int that matches the weight of the edge to change
+ * @param the new weight of the edge
+ * @return true if an edge was changed, false if it does not exist
+ * @NOTE if graph is Simple, weight is ignored and edge is changed if it exists;
+ *       Otherwise, edge is only changed if input weight matches edge's weight.
+ */
+bool graphSetEdgeWeightD(graph_t*, graph_vertex*, graph_vertex*, int, int);
+
+
 /* Removes vertex and all undirected edges connected to it
  * @param the graph from which to remove the vertex
  * @param struct representing vertex to be removed
@@ -264,10 +621,42 @@ void graphRemoveVertexU(graph_t*, graph_vertex*);
  * @param struct representing vertex to be removed
  * @NOTE no effect if vertex not in graph
  * @NOTE caller is responsible for freeing vertex, if desired
+ * @NOTE searches every adjacency list for the edges entering vertex, unless
+ *       the graph keeps a reverse adjacency list, see graphEnableReverse
  */
 void graphRemoveVertexD(graph_t*, graph_vertex*);
 
 
+/* Makes the graph keep, next to its adjacency list, a reverse adjacency list:
+ * for every edge from u to v, a node leading back to u in the list of v.
+ * Costs a second node per edge, in time and memory, for every edge added.
+ * In return graphRemoveVertexD finds the edges entering a vertex directly,
+ * instead of searching every list in the graph for them.
+ * The reverse list of the vertex with id v is graph->reverse[v]; each node's
+ * vertex is the source of an edge entering v and weight is that edge's weight.
+ * @param the graph, whose existing edges are reversed at once
+ * @NOTE no effect if the graph already keeps a reverse adjacency list
+ * @NOTE the reverse lists are kept up to date by all functions of this file
+ */
+void graphEnableReverse(graph_t*);
+
+
+/* Makes the graph keep, next to its adjacency list, a bit adjacency matrix:
+ * bit j of row i is set while at least one edge from i to j exists.
+ * graphExistsEdge then tests a single bit rather than walking a list, and
+ * breadthFirstSearch (and everything built on it) expands a vertex by
+ * combining whole words of its row with the visited set.
+ * The row of the vertex with id i is the graph->matrix_words words at
+ * graph->matrix + i * graph->matrix_words.
+ * @param the graph, whose existing edges are entered at once
+ * @NOTE costs listSize^2 / 8 bytes, and growing the graph past its listSize
+ *       copies the matrix: worth it for dense graphs only
+ * @NOTE no effect if the graph already keeps a matrix
+ * @NOTE the matrix is kept up to date by all functions of this file
+ */
+void graphEnableMatrix(graph_t*);
+
+
 /* Determines whether an vertex in a member of a given graph
  * @param the graph to search
  * @param the vertex in which to check for membership
@@ -276,9 +665,18 @@ void graphRemoveVertexD(graph_t*, graph_vertex*);
 bool graphExistsVertex(graph_t*, graph_vertex*);
 
 
+/* Looks up the member vertex of a graph that has a given id, in O(1)
+ * @param the graph to search
+ * @param the id of the vertex
+ * @return pointer to the vertex, or NULL if no member has that id
+ */
+graph_vertex* graphVertexById(graph_t*, unsigned int);
+
+
 /* Determines whether an edge exists from vertex one to two
  * @param the graph where both vertices are members
  * @return true if edge exists, false otherwise
+ * @NOTE O(1) if the graph keeps a bit matrix (graphEnableMatrix), O(degree) otherwise
  */
 bool graphExistsEdge(graph_t*, graph_vertex*, graph_vertex*);
 
@@ -289,6 +687,7 @@ bool graphExistsEdge(graph_t*, graph_vertex*, graph_vertex*);
  * @param the graph where the vertex is a member
  * @param the vertex you wish to know the degree of
  * @return the vertices degree as an integer
+ * @NOTE O(1): the graph keeps a count of each vertex's edges
  */
 int graphVertexDegreeU(graph_t*, graph_vertex*);
 
@@ -299,6 +698,7 @@ int graphVertexDegreeU(graph_t*, graph_vertex*);
  * @param the graph where the vertex is a member
  * @param the vertex you wish to know the Out-Degree of
  * @return the vertices Out-Degree as an integer
+ * @NOTE O(1): the graph keeps a count of each vertex's edges
  */
 int graphVertexDegreeOut(graph_t*, graph_vertex*);
 
@@ -309,6 +709,7 @@ int graphVertexDegreeOut(graph_t*, graph_vertex*);
  * @param the graph where the vertex is a member
  * @param the vertex you wish to know the In-Degree of
  * @return the vertices In-Degree as an integer
+ * @NOTE O(1): the graph keeps a count of each vertex's edges
  */
 int graphVertexDegreeIn(graph_t*, graph_vertex*);
 
@@ -322,6 +723,19 @@ int graphVertexDegreeIn(graph_t*, graph_vertex*);
 bool vertexReachable(graph_t*, graph_vertex*, graph_vertex*);
 
 
+/* Test whether one vertex is reachable from each of many others
+ * @param the graph where the vertices are members
+ * @param array of the vertices that are the sources in your queries
+ * @param the number of sources
+ * @param the vertex whose reachability you're inquiring about
+ * @param array of as many bools as sources, set to true where the target is
+ *   reachable from the source at the same index, otherwise false
+ * @NOTE answers 64 sources per search, see breadthFirstApplyMulti, and stops each
+ *   search as soon as all of its sources have reached the target
+ */
+void vertexReachableMulti(graph_t*, graph_vertex**, unsigned int, graph_vertex*, bool*);
+
+
 /* Traverse a graph, visiting all vertices reachable from input vertex
  * @param the graph to be traversed
  * @param the vertex from which to begin the BFS traversal
@@ -356,6 +770,29 @@ void graphShortestPathEnum(hashTable*, int);
 void breadthFirstApply(graph_t*, graph_vertex*, void (*apply)(graph_vertex*, int, void*), void*);
 
 
+/* Perform a BFS traversal of the graph from each of many sources, calling apply on
+ *   each vertex visited by each traversal
+ * @param the graph to be traversed
+ * @param array of the vertices from which to begin the BFS traversals
+ * @param the number of sources
+ * @param apply function that will be called on each visited vertex, once per
+ *   traversal that visits it
+ *   @param the vertex that is currently being visited
+ *   @param the index, in the array of sources, of the traversal visiting it
+ *   @param the depth of the current vertex from that source
+ *   @param optional argument the apply function can use. Use NULL if undesired
+ * @param this argument takes the place of the last argument in apply. use Null
+ *   if undesired
+ * @NOTE the traversals are run 64 at a time, each edge being scanned once per level
+ *   for all of them: memory is 3 64 bit words and 2 ints per vertex. apply is called
+ *   level by level - every (vertex, source) pair of depth d before any of depth d+1 -
+ *   and not in the order breadthFirstApply would visit the vertices within a level.
+ *   Unlike breadthFirstApply, the bit matrix (graphEnableMatrix) is not used.
+ */
+void breadthFirstApplyMulti(graph_t*, graph_vertex**, unsigned int,
+                            void (*apply)(graph_vertex*, unsigned int, int, void*), void*);
+
+
 /* Here are two functions that may be used in the place of apply (see above)
  * NOTE: do not provide these functions with arguments
  */
@@ -387,11 +824,32 @@ int graphExistsCycle(graph_t*);
 
 
 /* print to STDOUT the vertices that make up each cycle in given graph.
+ * Every elementary cycle is printed once, see graphCycleEnumerate.
  * @param the graph in which to identify cycles
  */
 void graphCycleEnum(graph_t*);
 
 
+/* Enumerate the elementary cycles of a directed graph by Johnson's algorithm
+ * (see cycleEnumeration.c), component by strongly connected component.
+ * Each cycle is found once, starting at its least vertex id.
+ * O((V + E)(C + 1)) time for C cycles, O(V + E) memory.
+ * @param the graph in which to identify cycles
+ * @param the greatest number of vertices of a cycle to report; 0 for no limit
+ * @param the number of cycles after which to stop; 0 for no limit
+ * @param sink called with each cycle: the ids of its vertices in path order
+ *        (the edge back to the first is implied) and their number. The array
+ *        is only valid during the call. Return 0 to go on, nonzero to stop.
+ *        May be NULL, to count the cycles.
+ * @param passed through to sink
+ * @return the number of cycles reported
+ * @NOTE parallel edges don't make distinct cycles. A length limit keeps the
+ *       result exact but loses the bound on the running time.
+ */
+size_t graphCycleEnumerate(graph_t*, unsigned int, size_t,
+                           int (*sink)(const unsigned int*, unsigned int, void*), void*);
+
+
 /* Perform a topological sort on an directed acyclic graph (DAG)
  * it is required that your graph is a DAG
  * The graph itself is not mutated in any way
@@ -406,6 +864,17 @@ void graphCycleEnum(graph_t*);
 graph_vertex* topologicalSort(graph_t*);
 
 
+/* Topological sort by Kahn's algorithm, into a flat array of vertex ids
+ * The graph itself is not mutated in any way
+ * @param the graph to have the sort performed on
+ * @param caller's array of (at least) numVertex ids, to receive the order:
+ *        if edge (u,v) is in the graph, u comes before v
+ * @return the number of ids written: numVertex if the graph is a DAG, fewer
+ *         if it has a cycle (the vertices on or behind a cycle are left out)
+ */
+unsigned int graphTopologicalOrder(graph_t*, uint32_t*);
+
+
 /* DFS approach to identifying all strongly connected components (scc) in graph.
  * @param the graph from which to identify the scc
  * @return a hash table representing one or more forests. Each forest is a scc.
@@ -414,6 +883,21 @@ graph_vertex* topologicalSort(graph_t*);
 hashTable* stronglyConnectedComponents(graph_t*);
 
 
+/* Tarjan's single DFS approach to identifying the scc of a graph. Neither a
+ * transpose nor a hash table is built: besides its result it uses only a few
+ * arrays with one entry per vertex.
+ * @param the graph from which to identify the scc
+ * @param set to the number of scc found
+ * @return array of listSize entries: at the index of each vertex id the number
+ *         of its scc, in [0, count); -1 at ids of vertices not in the graph.
+ *         scc are numbered in the order they are completed, which is a reverse
+ *         topological order: an edge between two scc leads from a higher
+ *         number to a lower one.
+ * @NOTE: the caller is responsible for freeing the returned array
+ */
+int* stronglyConnectedComponentsTarjan(graph_t*, unsigned int*);
+
+
 /* Print to STDOUT all strongly connected components (scc) and their vertices
  * @param the graph fom which to identify the scc
  * @NOTE: this is generally only done on directed graphs
@@ -444,7 +928,7 @@ hashTable* singleSourceShortestPath_DAG(graph_t*, graph_vertex*);
 
 
 /* Perform a Single-Source Shortest Path analysis on an graph WITHOUT negative
- * weighted edges. Uses Dijkstra's algorithm with binary heap for priority queue.
+ * weighted edges. Uses Dijkstra's algorithm with a 4-ary heap for priority queue.
  * @param the graph which to analyze
  * @param the source vertex that is the single-source of all paths
  * @return a hash table that contains vertex id as keys, distances as values
@@ -467,8 +951,455 @@ hashTable* singleSourceShortestPath_dijkstra(graph_t*, graph_vertex*);
 hashTable* singleSourceShortestPath_bellmanFord(graph_t*, graph_vertex*);
 
 
+/* Allocates an empty dense result: nothing visited, all distances INT_MAX
+ * and all predecessors -1.
+ * @param the number of vertex ids the result must hold (graph's listSize)
+ * @return a pointer to the result on the heap, free with graphDenseFree
+ */
+graph_dense_t* graphDenseBuild(unsigned int);
+
+
+/* Frees the memory allocated to a dense result
+ * @param the result to be freed
+ */
+void graphDenseFree(graph_dense_t*);
+
+
+/* Converts a dense result to the hash table returned by the older functions
+ * (keys are vertex ids, ->value is dist and ->graph_predecessor is pred)
+ * @param the dense result to convert; it is not freed
+ * @param NULL to include only the visited vertices (breadthFirstSearch form),
+ *   or the searched graph to include all its vertices, reached or not
+ *   (singleSourceShortestPath form)
+ * @return a pointer to a new hash table on the heap
+ */
+hashTable* graphDenseToHashTable(graph_dense_t*, graph_t*);
+
+
+/* Breadth-First Search, see breadthFirstSearch
+ * @param the graph to be traversed
+ * @param the vertex from which to begin the BFS traversal
+ * @return dense result: dist is depth from the source, pred the BFS tree
+ */
+graph_dense_t* breadthFirstSearchDense(graph_t*, graph_vertex*);
+
+
+/* Depth-First Search, see depthFirstSearch
+ * @param the graph to be traversed
+ * @return dense result: pred is the parent in the DFS forest (-1 at entry
+ *   points), dist is the depth within the forest. All vertices are visited.
+ */
+graph_dense_t* depthFirstSearchDense(graph_t*);
+
+
+/* Dijkstra's algorithm, see singleSourceShortestPath_dijkstra
+ * @param the graph which to analyze; must not have negative weighted edges
+ * @param the source vertex that is the single-source of all paths
+ * @return dense result: dist is distance from source, pred the predecessor
+ */
+graph_dense_t* dijkstraDense(graph_t*, graph_vertex*);
+
+
+/* Bellman-Ford, see singleSourceShortestPath_bellmanFord
+ * Only the edges of vertices whose distance changed are relaxed again, and the
+ * search stops as soon as no distance changes (see singleSourceShortestPath.c)
+ * @param the graph which to analyze; may have negative weighted edges
+ * @param the source vertex that is the single-source of all paths
+ * @return dense result: dist is distance from source, pred the predecessor.
+ *   NULL if a negatively weighted cycle is reachable from source.
+ */
+graph_dense_t* bellmanFordDense(graph_t*, graph_vertex*);
+
+
+/* Builds an immutable CSR snapshot of the graph for read-only analytics.
+ * Edges keep the order they have in the graph's adjacency lists.
+ * @param the graph to snapshot; it is not mutated
+ * @return a pointer to the snapshot on the heap, free with graphCSRFree
+ * @NOTE later changes to the graph are not reflected in the snapshot
+ */
+graph_csr_t* graphFreeze(graph_t*);
+
+
+/* Returns a new CSR snapshot with the direction of every edge reversed.
+ * Unlike graphBuildTranspose, edge weights are carried over.
+ * @param the snapshot to transpose
+ * @return a pointer to the transposed snapshot, free with graphCSRFree
+ */
+graph_csr_t* graphCSRTranspose(graph_csr_t*);
+
+
+/* Frees the memory allocated to a CSR snapshot
+ * @param the snapshot to be freed
+ */
+void graphCSRFree(graph_csr_t*);
+
+
+/* Writes a graph to a binary file that graphMapBinary opens as a CSR snapshot.
+ * The file holds a header, the member ids, and the offsets, targets and weights
+ * arrays of the snapshot, each aligned to 8 bytes, as the arrays are in memory.
+ * @param the graph to write; it is not mutated
+ * @param the path of the file to (over)write
+ * @return 0 on success, 1 if the file could not be written
+ * @NOTE the format stores integers in the byte order of this machine
+ */
+int graphWriteBinary(graph_t*, const char*);
+
+
+/* Writes a CSR snapshot to a binary file, see graphWriteBinary
+ * @param the snapshot to write
+ * @param the path of the file to (over)write
+ * @return 0 on success, 1 if the file could not be written
+ */
+int graphCSRWriteBinary(graph_csr_t*, const char*);
+
+
+/* Opens a file written by graphWriteBinary as a read-only CSR snapshot.
+ * The file is mapped into memory: nothing is read or copied up front, pages
+ * are read from disk as the snapshot's arrays are first used.
+ * @param the path of the file to open
+ * @param true to test the checksum of the whole file and that every target is
+ *   a valid id, which reads all of it; false to only check the header, that the
+ *   file has the expected size, and that the offsets and member ids are in range
+ *   (one pass over them, O(V))
+ * @return the snapshot, free with graphCSRFree (which unmaps the file), or NULL
+ *   if the file is not a graph file of a supported version or fails the checks
+ * @NOTE the file must not be modified while the snapshot is in use
+ * @CAUTION without verify, the targets are trusted: a corrupt target makes the
+ *   CSR kernels read out of bounds. Pass true for files from untrusted sources
+ */
+graph_csr_t* graphMapBinary(const char*, bool);
+
+
+/* Creates a binary graph file of the given sizes (see graphWriteBinary) and maps
+ * it so that the snapshot's arrays can be filled in place, in the file itself.
+ * @param the path of the file to (over)write
+ * @param listSize, numVertex and numEdge of the snapshot
+ * @param true if the snapshot has weighted edges
+ * @return a snapshot whose arrays are not yet initialized, or NULL if the file
+ *   could not be created. Fill vertex_ids, offsets, targets and weights, then
+ *   call graphFinishBinary before graphCSRFree.
+ * @NOTE graphMapBinary refuses the file until graphFinishBinary was called
+ */
+graph_csr_t* graphCreateBinary(const char*, unsigned int, unsigned int, uint64_t, bool);
+
+
+/* Completes a file created by graphCreateBinary: writes its header and checksum,
+ * and waits for the file to be written to disk.
+ * @param the snapshot returned by graphCreateBinary, arrays filled
+ * @return 0 on success, 1 if the file could not be written
+ */
+int graphFinishBinary(graph_csr_t*);
+
+
+/* Breadth-First Search over a CSR snapshot, see breadthFirstSearch
+ * @param the snapshot to be traversed
+ * @param the id of the vertex from which to begin the traversal
+ * @return a hash table identical to the one returned by breadthFirstSearch
+ */
+hashTable* breadthFirstSearchCSR(graph_csr_t*, unsigned int);
+
+
+/* Depth-First Search over a CSR snapshot, see depthFirstSearch
+ * Vertices are entered in the same order depthFirstSearch would enter them
+ * in the graph the snapshot was taken of.
+ * @param the snapshot to be traversed
+ * @return a DFS forest identical to the one returned by depthFirstSearch
+ */
+hashTable* depthFirstSearchCSR(graph_csr_t*);
+
+
+/* Dijkstra's algorithm over a CSR snapshot, see singleSourceShortestPath_dijkstra
+ * @param the snapshot to analyze; must not have negative weighted edges
+ * @param the id of the source vertex that is the single-source of all paths
+ * @return a hash table that contains vertex id as keys, distances as values
+ *   (->value), and vertex predecessors (or parents) in ->graph_predecessor
+ */
+hashTable* singleSourceShortestPath_dijkstraCSR(graph_csr_t*, unsigned int);
+
+
+/* Strongly connected components of a CSR snapshot, see stronglyConnectedComponents
+ * @param the snapshot from which to identify the scc
+ * @return a hash table representing one or more forests. Each forest is a scc.
+ */
+hashTable* stronglyConnectedComponentsCSR(graph_csr_t*);
+
+
+/* Multithreaded, direction-optimizing Breadth-First Search over a CSR snapshot.
+ * Each level is expanded by all threads together. While the frontier is small
+ * its out-edges are followed (top-down); once it covers a large part of the
+ * graph, unvisited vertices instead look for a parent among their in-edges
+ * (bottom-up), which on graphs of low diameter checks far fewer edges.
+ * @param the snapshot to be traversed
+ * @param its transpose (see graphCSRTranspose), giving the in-edges used by the
+ *        bottom-up steps; NULL if the graph is undirected (snapshot is symmetric)
+ * @param the id of the vertex from which to begin the traversal
+ * @param number of threads to use (the caller's included); 0 for one per core
+ * @return the depth and predecessor of every vertex, see graph_dense_t.
+ *         With several parents at the same depth, which one is predecessor is
+ *         decided by the threads' timing. (graphDenseVisited answers reachability)
+ */
+graph_dense_t* breadthFirstSearchParallel(graph_csr_t*, graph_csr_t*, unsigned int, unsigned int);
+
+
+/* Multithreaded Single-Source Shortest Paths over a CSR snapshot by delta-stepping.
+ * Vertices are kept in buckets of distances delta wide; all vertices of the
+ * lowest bucket are relaxed by all threads together, until it stays empty.
+ * @param the snapshot to analyze; must not have negative weighted edges
+ * @param the id of the source vertex that is the single-source of all paths
+ * @param the bucket width; 0 (or less) to use the average edge weight. Near the
+ *        average weight is usually a good choice: a small delta gives little
+ *        parallel work per bucket, a large one relaxes vertices more than once.
+ * @param number of threads to use (the caller's included); 0 for one per core
+ * @return dense result: dist is distance from source, pred the predecessor.
+ *         With several shortest paths, which predecessor is kept is decided by
+ *         the threads' timing.
+ * @NOTE memory for the buckets grows with (largest distance / delta)
+ */
+graph_dense_t* singleSourceShortestPath_deltaStepping(graph_csr_t*, unsigned int, int, unsigned int);
+
+
+/* Distances from many sources at once, see singleSourceShortestPath.c
+ * One Dijkstra search per source; the searches run side by side, each thread
+ * reusing one workspace for all the sources it handles.
+ * @param the snapshot to analyze; must not have negative weighted edges
+ * @param the ids of the sources; NULL to use the ids 0, 1, ..., n-1
+ *        (all-pairs shortest paths when n is the snapshot's listSize)
+ * @param n, the number of sources
+ * @param number of threads to use (the caller's included); 0 for one per core
+ * @param caller's row-major matrix of n * listSize ints: on return, entry
+ *        [i * listSize + v] is the distance from source i to the vertex with id v,
+ *        INT_MAX if it is not reachable (the whole row if source i is not in range)
+ */
+void singleSourceShortestPath_batch(graph_csr_t*, const unsigned int*, size_t, unsigned int, int*);
+
+
+/* Multithreaded topological sort of a CSR snapshot into levels (wavefronts),
+ * see graph_levels_t: Kahn's algorithm, one level at a time, with the vertices
+ * of a level shared out among the threads (see singleSourceShortestPathParallel.c)
+ * @param the snapshot to sort; should be a DAG
+ * @param number of threads to use (the caller's included); 0 for one per core
+ * @return the levels on the heap. Free with graphLevelsFree.
+ *         With several threads the order of the vertices within a level is
+ *         decided by the threads' timing.
+ */
+graph_levels_t* graphCSRTopologicalLevels(graph_csr_t*, unsigned int);
+
+
+/* Frees the memory allocated to levels
+ * @param the levels to be freed
+ */
+void graphLevelsFree(graph_levels_t*);
+
+
+/* Multithreaded Single-Source Shortest (or Longest) Paths over a DAG snapshot.
+ * The levels are relaxed in topological order; the out-edges of all vertices
+ * of one level are relaxed by all threads together. O(V + E) work.
+ * @param the snapshot to analyze; must be a DAG. Negative weights are fine.
+ * @param its levels, see graphCSRTopologicalLevels, to share them between
+ *        queries; NULL to compute them for this call
+ * @param the id of the source vertex that is the single-source of all paths
+ * @param true for longest paths (the critical paths of a schedule), false for
+ *        shortest. Paths whose distance would not fit an int are not followed.
+ * @param number of threads to use (the caller's included); 0 for one per core
+ * @return dense result: dist is distance from source, pred the predecessor.
+ *         With several best paths, the smallest predecessor id is kept.
+ */
+graph_dense_t* singleSourceShortestPath_DAGParallel(graph_csr_t*, graph_levels_t*, unsigned int, bool, unsigned int);
+
+
+/* Renumbers the vertices of a graph so that neighbours get nearby ids, for
+ * faster traversals (see graphReorder.c), and builds the graph anew in that
+ * order. Edges, weights, vertex values and the graph's kind are kept; so are
+ * its reverse adjacency list and bit matrix, if enabled.
+ * @param the graph to reorder; it is not changed
+ * @param the ordering: GRAPH_REORDER_RCM, GRAPH_REORDER_DEGREE or GRAPH_REORDER_BFS
+ * @param the id of the root, for GRAPH_REORDER_BFS; ignored by the others
+ * @param set to the permutation, to translate ids between the two graphs;
+ *        free with graphPermutationFree. NULL if not needed.
+ * @return the reordered graph, built with an arena (see graphBuildWithArena):
+ *         its member ids are 0 .. numVertex-1. Free with graphFree.
+ */
+graph_t* graphReorder(graph_t*, unsigned int, unsigned int, graph_permutation_t**);
+
+
+/* Renumbers the vertices of a CSR snapshot as graphReorder does a graph
+ * @param the snapshot to reorder; it is not changed
+ * @param the ordering, see graphReorder
+ * @param the id of the root, for GRAPH_REORDER_BFS
+ * @param set to the permutation (may be NULL), see graphReorder
+ * @return the reordered snapshot, listSize and numVertex equal. The edges of
+ *         each vertex are sorted by their destination's new id.
+ *         Free with graphCSRFree.
+ */
+graph_csr_t* graphCSRReorder(graph_csr_t*, unsigned int, unsigned int, graph_permutation_t**);
+
+
+/* Computes the permutation graphCSRReorder applies, without applying it
+ * @param the snapshot to order
+ * @param the ordering, see graphReorder
+ * @param the id of the root, for GRAPH_REORDER_BFS
+ * @return the permutation on the heap. Free with graphPermutationFree.
+ */
+graph_permutation_t* graphCSROrdering(graph_csr_t*, unsigned int, unsigned int);
+
+
+/* Builds a CSR snapshot with its vertices renumbered by a permutation
+ * @param the snapshot to renumber; it is not changed
+ * @param a permutation of its vertices, e.g. from graphCSROrdering
+ * @return the renumbered snapshot, see graphCSRReorder. Free with graphCSRFree.
+ */
+graph_csr_t* graphCSRPermute(graph_csr_t*, graph_permutation_t*);
+
+
+/* Frees the memory allocated to a permutation
+ * @param the permutation to be freed
+ */
+void graphPermutationFree(graph_permutation_t*);
+
+
+/* Shortest path between two vertices. Runs Dijkstra's algorithm from source,
+ * stopping as soon as target's distance is final (see singleSourceShortestPath.c)
+ * @param the graph which to analyze; must not have negative weighted edges
+ * @param the source vertex of the path
+ * @param the target vertex of the path
+ * @return the path, see graph_path_t. Free with graphPathFree.
+ */
+graph_path_t* shortestPath_dijkstraTarget(graph_t*, graph_vertex*, graph_vertex*);
+
+
+/* Shortest path between two vertices by bi-directional Dijkstra: one search
+ * forward from source in the graph, one backward from target in its transpose,
+ * until the two meet (see singleSourceShortestPath.c)
+ * @param the graph which to analyze; must not have negative weighted edges
+ * @param the transpose of that graph, see graphBuildTranspose. It is taken as
+ *   a parameter so that it is built once for any number of queries.
+ * @param the source vertex of the path
+ * @param the target vertex of the path (in graph, not in its transpose)
+ * @return the path, see graph_path_t. Free with graphPathFree.
+ */
+graph_path_t* shortestPath_bidirectional(graph_t*, graph_t*, graph_vertex*, graph_vertex*);
+
+
+/* Shortest paths from one source, kept up to date while edges change: each
+ * change repairs only the distances it affects (see dynamicShortestPath.c).
+ * Runs Dijkstra's algorithm once, from source.
+ * @param the graph which to analyze; must not have negative weighted edges.
+ *        Its reverse adjacency list is enabled, see graphEnableReverse.
+ * @param the source vertex of all paths
+ * @return the paths on the heap. Free with graphDynamicSSSPFree.
+ * @NOTE while the paths live, change graph's edges only with the functions
+ *       below, and add or remove no vertices
+ */
+graph_dynamic_sssp_t* graphDynamicSSSPBuild(graph_t*, graph_vertex*);
+
+
+/* Frees the memory allocated to dynamic shortest paths; the graph is left alone
+ * @param the paths to be freed
+ */
+void graphDynamicSSSPFree(graph_dynamic_sssp_t*);
+
+
+/* Adds a directed, weighted, edge as graphAddEdgeWeightD does, and repairs
+ * the paths it shortens by Dijkstra's algorithm from two, limited to the
+ * vertices whose distance it lowers.
+ * @param the dynamic shortest paths of the graph
+ * @param the source vertex of the edge
+ * @param the destination vertex of the edge
+ * @param the weight of the edge, not negative
+ */
+void graphDynamicSSSPAddEdge(graph_dynamic_sssp_t*, graph_vertex*, graph_vertex*, int);
+
+
+/* Removes a directed, weighted, edge as graphRemoveEdgeWeightD does. If it
+ * was on the shortest path of two, the distances of two's subtree of the
+ * shortest path tree are recomputed, and no others.
+ * @param the dynamic shortest paths of the graph
+ * @param the source vertex of the edge
+ * @param the destination vertex of the edge
+ * @param the weight of the edge (ignored unless graph is a MultiGraph)
+ * @NOTE no effect if the edge does not exist
+ */
+void graphDynamicSSSPRemoveEdge(graph_dynamic_sssp_t*, graph_vertex*, graph_vertex*, int);
+
+
+/* Changes the weight of a directed edge as graphSetEdgeWeightD does, and
+ * repairs the paths: as for an added edge if the weight decreases, as for a
+ * removed one if it increases.
+ * @param the dynamic shortest paths of the graph
+ * @param the source vertex of the edge
+ * @param the destination vertex of the edge
+ * @param the weight of the edge (ignored unless graph is a MultiGraph)
+ * @param the new weight of the edge, not negative
+ * @NOTE no effect if the edge does not exist
+ */
+void graphDynamicSSSPSetWeight(graph_dynamic_sssp_t*, graph_vertex*, graph_vertex*, int, int);
+
+
+/* Picks landmarks and computes their distance tables, for use with shortestPath_ALT.
+ * Landmarks are chosen one at a time, each the vertex farthest from those chosen
+ * before it; vertices no landmark reaches are preferred, so that every part of a
+ * disconnected graph gets one. Runs two Dijkstra searches per landmark.
+ * @param the graph which to analyze; must not have negative weighted edges
+ * @param the transpose of that graph, see graphBuildTranspose
+ * @param the number of landmarks to pick (fewer if graph has fewer vertices)
+ * @return the landmark tables on the heap. Free with graphLandmarksFree.
+ * @NOTE the tables must be rebuilt when the graph changes
+ */
+graph_landmarks_t* graphLandmarksBuild(graph_t*, graph_t*, unsigned int);
+
+
+/* Writes landmark tables to a file, to be read back with graphLandmarksLoad
+ * @param the landmark tables to save
+ * @param the path of the file to (over)write
+ * @return 0 on success, 1 if the file could not be written
+ * @NOTE the format stores integers in the byte order of this machine
+ */
+int graphLandmarksSave(graph_landmarks_t*, const char*);
+
+
+/* Reads landmark tables written by graphLandmarksSave
+ * @param the path of the file to read
+ * @return the landmark tables on the heap, or NULL if the file could not be
+ *   read, is not a landmark file of a supported version, or its size is not
+ *   the one its header gives (checked before anything is allocated)
+ */
+graph_landmarks_t* graphLandmarksLoad(const char*);
+
+
+/* Frees the memory allocated to landmark tables
+ * @param the landmark tables to be freed
+ */
+void graphLandmarksFree(graph_landmarks_t*);
+
+
+/* Shortest path between two vertices by A* search, goal-directed with landmarks
+ * (ALT). The triangle inequality on the landmark distances gives a lower bound
+ * on the distance left to target, which steers the search towards it.
+ * @param the graph which to analyze; must not have negative weighted edges
+ * @param landmark tables of that graph, see graphLandmarksBuild
+ * @param the source vertex of the path
+ * @param the target vertex of the path
+ * @return the path, see graph_path_t. Free with graphPathFree.
+ */
+graph_path_t* shortestPath_ALT(graph_t*, graph_landmarks_t*, graph_vertex*, graph_vertex*);
+
+
+/* Print to STDOUT the distance and the vertices of a path
+ * @param the path as returned by e.g. shortestPath_dijkstraTarget
+ */
+void graphPathPrint(graph_path_t*);
+
+
+/* Frees the memory allocated to a path
+ * @param the path to be freed
+ */
+void graphPathFree(graph_path_t*);
+
+
 /* Frees the memory allocated to the graph and all member vertices
  * @param the graph to be freed.
+ * @NOTE vertices from graphArenaVertexNew are released with the arena, see
+ *   graphBuildWithArena
  */
 void graphFree(graph_t*);
 
@@ -0,0 +1,67 @@
+/** Makes available counters of the work done by the graph library and the hash
+ ** tables: vertices visited, edges scanned, relaxations, heap operations, hash
+ ** probes, resizes and allocations.
+ **
+ ** The counters only exist when compiled with GRAPH_STATS defined (-DGRAPH_STATS,
+ ** for every file of the graph library and hashTables.c alike). They are defined
+ ** in Sources/graphStats.c, which any program using either must link. Otherwise every
+ ** GRAPH_STAT_* macro expands to nothing, its arguments are not evaluated, and
+ ** graphStatsRead returns zeros: instrumented code is the same as before.
+ **
+ ** Counters are per thread, so the hot paths increment them without atomics. The
+ ** worker threads of the parallel kernels (breadthFirstSearchParallel,
+ ** singleSourceShortestPath_deltaStepping, singleSourceShortestPath_batch)
+ ** count into their own counters, which are lost when they exit; the calling
+ ** thread, which also works, sees only its own share.
+ **
+ ** Usage:   graphStatsReset();  dijkstraDense(graph, source);
+ **          graph_stats_t stats = graphStatsRead();
+ **/
+
+#ifndef GRAPH_STATS_H
+#define GRAPH_STATS_H
+
+#include <stdint.h>
+
+
+typedef struct graph_stats_t {
+  uint64_t vertices_visited;   // vertices reached (discovered) by traversals and searches
+  uint64_t edges_scanned;      // adjacency list / CSR entries looked at
+  uint64_t relaxations;        // distance improvements by shortest path searches
+  uint64_t heap_pushes;        // indexedHeapPush calls that changed the heap
+  uint64_t heap_pops;          // indexedHeapExtractMin calls
+  uint64_t heap_sift_steps;    // levels moved by entries sifting up or down
+  uint64_t hash_lookups;       // hashTable searches, inserts and deletes by key
+  uint64_t hash_probes;        // chain nodes compared by those lookups
+  uint64_t hash_chain_max;     // longest chain met by a lookup
+  uint64_t hash_resizes;       // times a hashTable grew or shrank
+  uint64_t hash_rehashed;      // nodes moved by those resizes
+  uint64_t allocations;        // malloc calls for hashTable nodes, keys and graph edges
+} graph_stats_t;
+
+
+/* @return copy of the calling thread's counters, all zero without GRAPH_STATS */
+graph_stats_t graphStatsRead(void);
+
+/* Sets the calling thread's counters to zero */
+void graphStatsReset(void);
+
+
+#ifdef GRAPH_STATS
+
+extern __thread graph_stats_t graph_stats;
+
+#define GRAPH_STAT_ADD(field, n)  ((void)(graph_stats.field += (n)))
+#define GRAPH_STAT_MAX(field, n)					\
+  do { uint64_t _stat_n = (n);						\
+       if (_stat_n > graph_stats.field) graph_stats.field = _stat_n; } while (0)
+
+#else
+
+#define GRAPH_STAT_ADD(field, n)  ((void)0)
+#define GRAPH_STAT_MAX(field, n)  ((void)0)
+
+#endif
+
+
+#endif
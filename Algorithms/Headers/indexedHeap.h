@@ -0,0 +1,214 @@
+/** Makes available an indexed d-ary min-heap, to be used as priority queue.
+ ** Elements are integer ids in [0, capacity) with integer keys (priorities).
+ **
+ ** Indexed: the heap tracks the position of every id it holds, so the key of
+ ** an id can be decreased in O(log n) without searching for it first.
+ ** d-ary: every node has INDEXED_HEAP_ARITY children (4 unless defined before
+ ** including this header). A wider heap is shallower, making decrease-key
+ ** cheaper, and the children of a node share a cache line. Extract-min has to
+ ** compare more children per level, a trade Dijkstra's algorithm is happy to
+ ** make: it decreases many more keys than it extracts minimums.
+ ** Keys are stored inline next to their ids, so comparisons never leave the
+ ** heap's own array.
+ ** Pushes, pops and sift steps are counted when compiled with GRAPH_STATS,
+ ** see graphStats.h.
+ **/
+
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "graphStats.h"
+
+#ifndef INDEXED_HEAP_ARITY
+#define INDEXED_HEAP_ARITY 4
+#endif
+
+
+typedef struct indexedHeapEntry {
+  int          key;
+  unsigned int id;
+} indexedHeapEntry;
+
+
+/* The heap is a struct which may live on the stack or the heap; its arrays
+ * are always on the heap. Use indexedHeapInit / indexedHeapDestroy for the
+ * former, indexedHeapBuild / indexedHeapFree for the latter.
+ */
+typedef struct indexedHeap {
+  unsigned int      size;
+  unsigned int      capacity;   // ids must be smaller than capacity
+  indexedHeapEntry *entries;    // heap ordered by key
+  int              *pos;        // position of each id in entries, -1 if absent
+} indexedHeap;
+
+
+/* Initializes an empty heap able to hold the ids [0, capacity) */
+static inline
+void indexedHeapInit(indexedHeap *heap, unsigned int capacity)
+{
+  heap->size = 0;
+  heap->capacity = capacity;
+  heap->entries = (indexedHeapEntry*)malloc(sizeof(indexedHeapEntry) * (capacity ? capacity : 1));
+  heap->pos = (int*)malloc(sizeof(int) * (capacity ? capacity : 1));
+  if (!heap->entries || !heap->pos) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (unsigned int i = 0; i < capacity; i++) { heap->pos[i] = -1; }
+}
+
+/* Frees the arrays of a heap set up with indexedHeapInit */
+static inline
+void indexedHeapDestroy(indexedHeap *heap)
+{
+  free(heap->entries);
+  free(heap->pos);
+}
+
+/* @return pointer to an empty heap on the heap able to hold ids [0, capacity) */
+static inline
+indexedHeap* indexedHeapBuild(unsigned int capacity)
+{
+  indexedHeap *new = (indexedHeap*)malloc(sizeof(*new));
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  indexedHeapInit(new, capacity);
+  return new;
+}
+
+/* Frees a heap allocated with indexedHeapBuild */
+static inline
+void indexedHeapFree(indexedHeap *heap)
+{
+  indexedHeapDestroy(heap);
+  free(heap);
+}
+
+/* Removes all elements; O(size) rather than O(capacity), so a heap can be
+ * reused across many searches at no cost when it was emptied by extraction.
+ */
+static inline
+void indexedHeapClear(indexedHeap *heap)
+{
+  for (unsigned int i = 0; i < heap->size; i++) { heap->pos[heap->entries[i].id] = -1; }
+  heap->size = 0;
+}
+
+static inline
+bool indexedHeapIsEmpty(const indexedHeap *heap)
+{
+  return heap->size == 0;
+}
+
+static inline
+bool indexedHeapContains(const indexedHeap *heap, unsigned int id)
+{
+  return heap->pos[id] != -1;
+}
+
+/* @return the key of an id that is in the heap */
+static inline
+int indexedHeapKey(const indexedHeap *heap, unsigned int id)
+{
+  return heap->entries[heap->pos[id]].key;
+}
+
+
+/* moves an entry towards the root until its parent's key is not larger */
+static inline
+void _indexedHeapSiftUp(indexedHeap *heap, unsigned int i)
+{
+  indexedHeapEntry moving = heap->entries[i];
+  while (i > 0) {
+    unsigned int parent = (i - 1) / INDEXED_HEAP_ARITY;
+    if (heap->entries[parent].key <= moving.key) break;
+    heap->entries[i] = heap->entries[parent];
+    heap->pos[heap->entries[i].id] = i;
+    i = parent;
+    GRAPH_STAT_ADD(heap_sift_steps, 1);
+  }
+  heap->entries[i] = moving;
+  heap->pos[moving.id] = i;
+}
+
+/* moves an entry towards the leaves until no child has a smaller key */
+static inline
+void _indexedHeapSiftDown(indexedHeap *heap, unsigned int i)
+{
+  indexedHeapEntry moving = heap->entries[i];
+  for (;;) {
+    unsigned int first = i * INDEXED_HEAP_ARITY + 1;
+    if (first >= heap->size) break;
+    unsigned int last = first + INDEXED_HEAP_ARITY < heap->size ? first + INDEXED_HEAP_ARITY : heap->size;
+
+    unsigned int smallest = first;
+    for (unsigned int c = first + 1; c < last; c++) {
+      if (heap->entries[c].key < heap->entries[smallest].key) smallest = c;
+    }
+    if (heap->entries[smallest].key >= moving.key) break;
+    heap->entries[i] = heap->entries[smallest];
+    heap->pos[heap->entries[i].id] = i;
+    i = smallest;
+    GRAPH_STAT_ADD(heap_sift_steps, 1);
+  }
+  heap->entries[i] = moving;
+  heap->pos[moving.id] = i;
+}
+
+
+/* Inserts id with key, or decreases its key if it is already in the heap.
+ * @return true if heap changed, false if id was present with key <= new key
+ */
+static inline
+bool indexedHeapPush(indexedHeap *heap, unsigned int id, int key)
+{
+  if (heap->pos[id] == -1) {
+    heap->entries[heap->size].id  = id;
+    heap->entries[heap->size].key = key;
+    heap->pos[id] = heap->size;
+    heap->size++;
+  } else if (heap->entries[heap->pos[id]].key > key) {
+    heap->entries[heap->pos[id]].key = key;
+  } else {
+    return false;
+  }
+  GRAPH_STAT_ADD(heap_pushes, 1);
+  _indexedHeapSiftUp(heap, heap->pos[id]);
+  return true;
+}
+
+/* Decreases the key of an id that is in the heap, see indexedHeapPush */
+static inline
+void indexedHeapDecreaseKey(indexedHeap *heap, unsigned int id, int key)
+{
+  indexedHeapPush(heap, id, key);
+}
+
+/* @return the entry with the smallest key; heap must not be empty */
+static inline
+indexedHeapEntry indexedHeapPeek(const indexedHeap *heap)
+{
+  return heap->entries[0];
+}
+
+/* Removes and returns the entry with the smallest key; heap must not be empty */
+static inline
+indexedHeapEntry indexedHeapExtractMin(indexedHeap *heap)
+{
+  indexedHeapEntry min = heap->entries[0];
+  GRAPH_STAT_ADD(heap_pops, 1);
+  heap->pos[min.id] = -1;
+  heap->size--;
+  if (heap->size > 0) {
+    heap->entries[0] = heap->entries[heap->size];
+    _indexedHeapSiftDown(heap, 0);
+  }
+  return min;
+}
+
+
+#endif
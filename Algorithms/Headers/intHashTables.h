@@ -0,0 +1,85 @@
+/** Makes available my implementation of hash tables with integer keys,
+ ** using open addressing (Robin Hood linear probing) in a flat array.
+ **/
+
+#ifndef INT_HASH_TABLE_H
+#define INT_HASH_TABLE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+
+struct intHashTable;
+typedef struct intHashTable intHashTable;
+
+
+/* Create a new, empty, hash table.
+ * @return returns a pointer to the hash table on the heap
+ */
+intHashTable* intHashTableBuild();
+
+/* Make room for at least a given number of elements.
+ * No rehashing happens while the table holds no more than this many.
+ * @param table pointer to the hash table
+ * @param num_elements number of elements the table must be able to hold
+ * @NOTE never shrinks the table
+ */
+void intHashTableReserve(intHashTable *table, size_t num_elements);
+
+/* @return the number of elements the table can hold before it must grow */
+size_t intHashTableCapacity(intHashTable *table);
+
+/* @return the number of elements currently in the table */
+size_t intHashTableSize(intHashTable *table);
+
+/* Check whether a given hash table is empty.
+ * @return 1 if table is empty, 0 otherwise.
+ */
+int intHashTableIsEmpty(intHashTable *table);
+
+/* Given your hash table, it will empty all its contents.
+ * The table keeps its capacity.
+ */
+void intHashTableEmpty(intHashTable *table);
+
+/* Free all memory allocated for the hash table */
+void intHashTableFree(intHashTable *table);
+
+/* Prints to stdout a textual representation of the hash table's slots */
+void intHashTablePrint(intHashTable *table);
+
+/* Hash table insert
+ * @param table pointer to the hash table
+ * @param key the key of the element to insert
+ * @param value the value of the element to insert
+ * @return 1 if key was new, 0 if an existing element was overwritten
+ */
+int intHashTableInsert(intHashTable *table, uint64_t key, int64_t value);
+
+/* Hash table search for membership.
+ * @param table pointer to the hash table
+ * @param key the key of the element to find
+ * @return pointer to the element's value or NULL if key is not in table.
+ * @CAUTION the pointer is invalidated by the next insert or delete
+ */
+int64_t* intHashTableSearch(intHashTable *table, uint64_t key);
+
+/* Hash table delete
+ * @param table pointer to the hash table
+ * @param key the key of the element to delete
+ * @return returns 1 if delete was made, otherwise 0
+ */
+int intHashTableDelete(intHashTable *table, uint64_t key);
+
+/* Iterate over all elements, in no particular order.
+ * @param table pointer to the hash table
+ * @param iter cursor, set to 0 before the first call
+ * @param key set to the key of the next element
+ * @param value set to the value of the next element
+ * @return 1 if an element was produced, 0 once all have been visited
+ * @NOTE the table must not be modified during iteration
+ */
+int intHashTableNext(intHashTable *table, size_t *iter, uint64_t *key, int64_t *value);
+
+
+#endif
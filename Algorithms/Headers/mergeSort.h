@@ -0,0 +1,54 @@
+/** Makes available my implementation of a stable merge sort of arrays of
+ ** pointers: the pointers are reordered, the records they point to are not
+ ** moved. Records are ordered by a comparator or by an integer key.
+ ** Natural runs in the input are found and kept, short runs are extended by
+ ** insertion sort, and large arrays are sorted by several threads.
+ **/
+
+#ifndef MERGE_SORT_H
+#define MERGE_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Order of two records, as for qsort: negative if a comes before b, 0 if they
+ * are equal, positive if a comes after b. arg is passed through unchanged. */
+typedef int (*mergeSortCompare)(const void *a, const void *b, void *arg);
+
+/* Sort key of a record; records are sorted by increasing key. */
+typedef int64_t (*mergeSortKey)(const void *record, void *arg);
+
+
+/* Sort an array of pointers to records, stably. Memory: one buffer of n pointers.
+ * @param array pointers to the records to sort
+ * @param n number of pointers
+ * @param compare order of two records
+ * @param arg passed to compare
+ * @param threads number of threads to sort with; 0 for one per online processor
+ * @NOTE compare is called from several threads when threads != 1
+ */
+void mergeSortPointers(void **array, size_t n, mergeSortCompare compare, void *arg,
+		       unsigned int threads);
+
+/* Sort an array of pointers to records stably by increasing key.
+ * Calls key once per record, then sorts the keys alone: packed with the
+ * records' indices and merged with SIMD, or by radix sort.
+ * Memory: up to 5 64 bit words per record.
+ * @param array pointers to the records to sort
+ * @param n number of pointers
+ * @param key sort key of a record
+ * @param arg passed to key
+ * @param threads number of threads to sort with; 0 for one per online processor
+ * @NOTE key is only called from the calling thread
+ */
+void mergeSortPointersByKey(void **array, size_t n, mergeSortKey key, void *arg,
+			    unsigned int threads);
+
+/* Sort the pointers array[start..end] (end included) by the ints they point to.
+ * @NOTE kept for old callers; single threaded
+ */
+void mergeSort(int **array, int start, int end);
+
+
+#endif
@@ -0,0 +1,537 @@
+/*
+  Benchmarks for the graph library
+  Times the library's algorithms on synthetic graphs and reports the results as JSON, so that
+  runs can be kept and compared (before and after a change, one machine against another).
+  Build and run with "make bench" in Sources/Graphs; "./graph-bench --help" lists the options.
+
+  Graphs are generated from a seed, so the same options always give the same graph:
+    rmat   R-MAT (Chakrabarti, Zhan and Faloutsos, 2004) with the Graph500 parameters
+           a = 0.57, b = c = 0.19. Each edge picks one quadrant of the adjacency matrix at
+           every level of recursion: a skewed, power-law degree distribution with a few hubs,
+           and a small diameter, like social networks and the web.
+    er     Erdos-Renyi G(n, m): m edges between uniformly random pairs. Degrees are all close
+           to the average, the diameter is small.
+    grid   a square 2D grid, each vertex linked to its 4 neighbours in both directions. Every
+           degree is 4 and the diameter is large: the worst case for level-synchronous BFS.
+    star   every vertex linked to vertex 0 in both directions: a single hub whose in and out
+           degree is the number of vertices. Any step that walks a vertex's list once per edge
+           added to it (the duplicate check of graphAddEdge*) is quadratic here.
+  2^scale vertices (the grid is the nearest square), degree edges per vertex for rmat and er.
+  Weights are uniform in [1, 255]. Self loops are dropped, and so are parallel edges, which
+  graphBuildFromEdgeList removes.
+
+  The algorithms that need a DAG (topological sorts, DAG shortest paths) run on the same graph
+  with every edge pointing from the smaller id to the larger one.
+  With --reorder, the vertices of the graph are renumbered by graphReorder once it is built
+  (the pass is timed as a kernel of its own), and the other kernels run on the result. The
+  generators' ids already have some locality - the grid is numbered row by row, and R-MAT puts
+  the hubs at low ids - so the gain is smaller than on graphs read in no particular order.
+
+  Each kernel is run a number of times (--reps), from a new random source each time where it
+  takes one, and the report gives the minimum, median, 90th percentile and maximum time, and
+  edges per second at the median. bfs_multi runs 64 searches at once (breadthFirstApplyMulti),
+  so compare its times with 64 times those of bfs; its edges per second count one sweep. Peak
+  RSS is the high water mark of the whole process, as reported by getrusage; it is measured
+  after each kernel, so it only ever grows.
+
+  Built with GRAPH_STATS ("make bench-stats"), the report of each kernel also holds the work it
+  did, summed over its runs, as counted by graphStats.h: edges scanned, relaxations, heap and
+  hash table operations. Only the work of the calling thread is counted, and counting slows
+  the kernels down, so compare the times of such runs with each other only.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "../../../Headers/graph.h"
+#include "../../../Headers/Graphs/hashTables.h"
+
+
+#define BENCH_MAX_REPS 1000
+#define BENCH_MULTI_SOURCES 64       // searches per bfs_multi run
+
+
+typedef struct bench_options_t {
+  const char  *generator;
+  unsigned int scale;
+  unsigned int degree;
+  uint64_t     seed;
+  unsigned int reps;
+  unsigned int threads;
+  const char  *kernels;        // comma separated names, NULL for all
+  const char  *reorder;        // rcm, degree or bfs: graphReorder before the kernels; NULL for none
+} bench_options_t;
+
+typedef struct bench_graph_t {
+  uint32_t *src;
+  uint32_t *dst;
+  int      *weights;
+  size_t    size;
+  size_t    capacity;
+  unsigned int num_ids;
+} bench_graph_t;
+
+
+/*                      */
+/*     Generators       */
+/*                      */
+
+// splitmix64: small, fast, and every seed gives a good sequence
+static
+uint64_t _bench_random(uint64_t *state)
+{
+  uint64_t z = (*state += UINT64_C(0x9e3779b97f4a7c15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+static
+void _bench_add(bench_graph_t *graph, uint32_t src, uint32_t dst, uint64_t *state)
+{
+  if (src == dst) return;
+  if (graph->size == graph->capacity) {
+    graph->capacity = graph->capacity ? graph->capacity * 2 : 1024;
+    graph->src     = (uint32_t*)realloc(graph->src, sizeof(uint32_t) * graph->capacity);
+    graph->dst     = (uint32_t*)realloc(graph->dst, sizeof(uint32_t) * graph->capacity);
+    graph->weights = (int*)realloc(graph->weights, sizeof(int) * graph->capacity);
+    if (!graph->src || !graph->dst || !graph->weights) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+  }
+  graph->src[graph->size]     = src;
+  graph->dst[graph->size]     = dst;
+  graph->weights[graph->size] = 1 + _bench_random(state) % 255;
+  graph->size++;
+}
+
+static
+void _bench_rmat(bench_graph_t *graph, unsigned int scale, unsigned int degree, uint64_t *state)
+{
+  const double a = 0.57, b = 0.19, c = 0.19;
+  uint64_t edges = ((uint64_t)degree) << scale;
+  graph->num_ids = 1u << scale;
+
+  for (uint64_t e = 0; e < edges; e++) {
+    uint32_t src = 0, dst = 0;
+    for (unsigned int bit = 0; bit < scale; bit++) {
+      double r = (_bench_random(state) >> 11) * (1.0 / 9007199254740992.0);
+      if (r < a) continue;                      // top left quadrant: both bits 0
+      if (r < a + b)          { dst |= 1u << bit; }
+      else if (r < a + b + c) { src |= 1u << bit; }
+      else                    { src |= 1u << bit;  dst |= 1u << bit; }
+    }
+    _bench_add(graph, src, dst, state);
+  }
+}
+
+static
+void _bench_er(bench_graph_t *graph, unsigned int scale, unsigned int degree, uint64_t *state)
+{
+  uint64_t edges = ((uint64_t)degree) << scale;
+  graph->num_ids = 1u << scale;
+
+  for (uint64_t e = 0; e < edges; e++) {
+    uint32_t src = _bench_random(state) % graph->num_ids;
+    uint32_t dst = _bench_random(state) % graph->num_ids;
+    _bench_add(graph, src, dst, state);
+  }
+}
+
+static
+void _bench_star(bench_graph_t *graph, unsigned int scale, uint64_t *state)
+{
+  graph->num_ids = 1u << scale;
+  for (uint32_t id = 1; id < graph->num_ids; id++) {
+    _bench_add(graph, id, 0, state);
+    _bench_add(graph, 0, id, state);
+  }
+}
+
+static
+void _bench_grid(bench_graph_t *graph, unsigned int scale, uint64_t *state)
+{
+  uint32_t side = 1u << (scale / 2);
+  if (scale % 2) side = side * 1.4142135623730951;
+  graph->num_ids = side * side;
+
+  for (uint32_t row = 0; row < side; row++) {
+    for (uint32_t col = 0; col < side; col++) {
+      uint32_t id = row * side + col;
+      if (col + 1 < side) { _bench_add(graph, id, id + 1, state);     _bench_add(graph, id + 1, id, state); }
+      if (row + 1 < side) { _bench_add(graph, id, id + side, state);  _bench_add(graph, id + side, id, state); }
+    }
+  }
+}
+
+
+/*                      */
+/*     Measurement      */
+/*                      */
+
+typedef struct bench_timer_t {
+  double times[BENCH_MAX_REPS];
+  unsigned int count;
+} bench_timer_t;
+
+static
+double _bench_now(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static
+long _bench_peak_rss_kb(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;          // kilobytes on Linux
+}
+
+static
+int _bench_compare_double(const void *one, const void *two)
+{
+  double a = *(const double*)one, b = *(const double*)two;
+  return (a > b) - (a < b);
+}
+
+// nearest-rank percentile of sorted times
+static
+double _bench_percentile(const bench_timer_t *timer, double p)
+{
+  unsigned int rank = (unsigned int)(p * timer->count + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > timer->count) rank = timer->count;
+  return timer->times[rank - 1];
+}
+
+static
+bool _bench_selected(const bench_options_t *options, const char *name)
+{
+  if (!options->kernels) return true;
+  size_t length = strlen(name);
+  const char *at = options->kernels;
+  while ((at = strstr(at, name))) {
+    bool starts = at == options->kernels || at[-1] == ',';
+    bool ends   = at[length] == '\0' || at[length] == ',';
+    if (starts && ends) return true;
+    at += length;
+  }
+  return false;
+}
+
+static
+void _bench_report(const char *name, bench_timer_t *timer, uint64_t edges, bool *first)
+{
+  qsort(timer->times, timer->count, sizeof(double), _bench_compare_double);
+  double median = _bench_percentile(timer, 0.5);
+  printf("%s\n    {\"name\": \"%s\", \"reps\": %u, \"min_s\": %.6f, \"p50_s\": %.6f, \"p90_s\": %.6f,"
+	 " \"max_s\": %.6f, \"edges_per_s\": %.0f, \"peak_rss_kb\": %ld",
+	 *first ? "" : ",", name, timer->count, timer->times[0], median, _bench_percentile(timer, 0.9),
+	 timer->times[timer->count - 1], median > 0 ? edges / median : 0.0, _bench_peak_rss_kb());
+#ifdef GRAPH_STATS
+  graph_stats_t stats = graphStatsRead();
+  printf(",\n     \"stats\": {\"vertices_visited\": %llu, \"edges_scanned\": %llu, \"relaxations\": %llu,"
+	 " \"heap_pushes\": %llu, \"heap_pops\": %llu, \"heap_sift_steps\": %llu,"
+	 " \"hash_lookups\": %llu, \"hash_probes\": %llu, \"hash_chain_max\": %llu,"
+	 " \"hash_resizes\": %llu, \"hash_rehashed\": %llu, \"allocations\": %llu}",
+	 (unsigned long long)stats.vertices_visited, (unsigned long long)stats.edges_scanned,
+	 (unsigned long long)stats.relaxations, (unsigned long long)stats.heap_pushes,
+	 (unsigned long long)stats.heap_pops, (unsigned long long)stats.heap_sift_steps,
+	 (unsigned long long)stats.hash_lookups, (unsigned long long)stats.hash_probes,
+	 (unsigned long long)stats.hash_chain_max, (unsigned long long)stats.hash_resizes,
+	 (unsigned long long)stats.hash_rehashed, (unsigned long long)stats.allocations);
+#endif
+  printf("}");
+  *first = false;
+  fflush(stdout);
+}
+
+
+/*                      */
+/*      Kernels         */
+/*                      */
+
+typedef struct bench_state_t {
+  bench_options_t *options;
+  graph_t         *graph;
+  graph_t         *dag;
+  graph_csr_t     *csr;
+  graph_csr_t     *transpose;
+  graph_csr_t     *dag_csr;
+  uint32_t        *order;       // numVertex ids, for topological_order
+  uint64_t         random;      // source selection
+  bool             first;       // no kernel reported yet
+} bench_state_t;
+
+// a random member with at least one out-edge (any member if there is none)
+static
+graph_vertex* _bench_source(bench_state_t *state, graph_t *graph)
+{
+  for (int tries = 0; tries < 64; tries++) {
+    graph_vertex *vertex = graphVertexById(graph, _bench_random(&state->random) % graph->listSize);
+    if (vertex && graph->list[vertex->id]) return vertex;
+  }
+  return graph->vertex_head;
+}
+
+static
+void _bench_free_list(graph_vertex *head)
+{
+  while (head) {
+    graph_vertex *next = head->next;
+    free(head);
+    head = next;
+  }
+}
+
+enum {
+  BENCH_BFS, BENCH_BFS_PARALLEL, BENCH_DFS, BENCH_TOPOLOGICAL_SORT, BENCH_SCC_TARJAN, BENCH_SCC_KOSARAJU,
+  BENCH_DIJKSTRA, BENCH_DELTA_STEPPING, BENCH_BELLMAN_FORD, BENCH_DAG_SSSP,
+  BENCH_TOPOLOGICAL_ORDER, BENCH_TOPOLOGICAL_LEVELS, BENCH_DAG_PARALLEL, BENCH_BFS_MULTI, BENCH_KERNELS
+};
+
+static const char *bench_kernel_names[BENCH_KERNELS] = {
+  "bfs", "bfs_parallel", "dfs", "topological_sort", "scc_tarjan", "scc_kosaraju",
+  "dijkstra", "delta_stepping", "bellman_ford", "dag_sssp",
+  "topological_order", "topological_levels", "dag_parallel", "bfs_multi"
+};
+
+// bfs_multi's apply: counts the (vertex, source) pairs visited
+static
+void _bench_count_visit(graph_vertex *vertex, unsigned int source, int depth, void *count)
+{
+  (*(size_t*)count)++;
+}
+
+static
+void _bench_run_kernel(bench_state_t *state, int kernel)
+{
+  graph_t *graph = state->graph;
+  bool on_dag = kernel == BENCH_DAG_SSSP || kernel == BENCH_DAG_PARALLEL;
+  graph_vertex *source = _bench_source(state, on_dag ? state->dag : graph);
+  unsigned int count;
+
+  switch (kernel) {
+  case BENCH_BFS:           graphDenseFree(breadthFirstSearchDense(graph, source));  break;
+  case BENCH_BFS_PARALLEL:
+    graphDenseFree(breadthFirstSearchParallel(state->csr, state->transpose, source->id, state->options->threads));
+    break;
+  case BENCH_DFS:           graphDenseFree(depthFirstSearchDense(graph));  break;
+  case BENCH_TOPOLOGICAL_SORT: _bench_free_list(topologicalSort(state->dag));  break;
+  case BENCH_SCC_TARJAN:    free(stronglyConnectedComponentsTarjan(graph, &count));  break;
+  case BENCH_SCC_KOSARAJU:  hashTableFree(stronglyConnectedComponents(graph));  break;
+  case BENCH_DIJKSTRA:      graphDenseFree(dijkstraDense(graph, source));  break;
+  case BENCH_DELTA_STEPPING:
+    graphDenseFree(singleSourceShortestPath_deltaStepping(state->csr, source->id, 0, state->options->threads));
+    break;
+  case BENCH_BELLMAN_FORD: {
+    graph_dense_t *paths = bellmanFordDense(graph, source);
+    if (paths) graphDenseFree(paths);
+    break;
+  }
+  case BENCH_DAG_SSSP:      hashTableFree(singleSourceShortestPath_DAG(state->dag, source));  break;
+  case BENCH_TOPOLOGICAL_ORDER: graphTopologicalOrder(state->dag, state->order);  break;
+  case BENCH_TOPOLOGICAL_LEVELS:
+    graphLevelsFree(graphCSRTopologicalLevels(state->dag_csr, state->options->threads));
+    break;
+  case BENCH_DAG_PARALLEL:
+    graphDenseFree(singleSourceShortestPath_DAGParallel(state->dag_csr, NULL, source->id, false,
+							state->options->threads));
+    break;
+  case BENCH_BFS_MULTI: {
+    graph_vertex *sources[BENCH_MULTI_SOURCES];
+    size_t visits = 0;
+    sources[0] = source;
+    for (int i = 1; i < BENCH_MULTI_SOURCES; i++) { sources[i] = _bench_source(state, graph); }
+    breadthFirstApplyMulti(graph, sources, BENCH_MULTI_SOURCES, _bench_count_visit, &visits);
+    break;
+  }
+  }
+}
+
+
+/*                      */
+/*        Main          */
+/*                      */
+
+static
+void _bench_usage(const char *program)
+{
+  fprintf(stderr,
+	  "usage: %s [options]\n"
+	  "  --graph rmat|er|grid|star  generator (rmat)\n"
+	  "  --scale S                  2^S vertices (16)\n"
+	  "  --degree D                 edges per vertex, rmat and er (16)\n"
+	  "  --seed N                   seed of the generator and of source selection (1)\n"
+	  "  --reps R                   runs of each kernel, at most %d (5)\n"
+	  "  --threads T                threads of the parallel kernels, 0 for one per core (0)\n"
+	  "  --reorder rcm|degree|bfs   renumber the vertices before the kernels run (no)\n"
+	  "  --kernels a,b,...          kernels to run (all):", program, BENCH_MAX_REPS);
+  for (int k = 0; k < BENCH_KERNELS; k++) { fprintf(stderr, " %s", bench_kernel_names[k]); }
+  fprintf(stderr, "\n");
+}
+
+static
+bool _bench_parse(int argc, char **argv, bench_options_t *options)
+{
+  for (int i = 1; i < argc; i++) {
+    const char *option = argv[i];
+    if (!strcmp(option, "--help")) return false;
+    if (i + 1 >= argc) { fprintf(stderr, "%s needs a value\n", option);  return false; }
+    const char *value = argv[++i];
+    char *end;
+    unsigned long long number = strtoull(value, &end, 10);
+    bool numeric = *value && !*end;
+
+    if      (!strcmp(option, "--graph"))   options->generator = value;
+    else if (!strcmp(option, "--kernels")) options->kernels = value;
+    else if (!strcmp(option, "--reorder")) options->reorder = value;
+    else if (!numeric) { fprintf(stderr, "%s: %s is not a number\n", option, value);  return false; }
+    else if (!strcmp(option, "--scale"))   options->scale = number;
+    else if (!strcmp(option, "--degree"))  options->degree = number;
+    else if (!strcmp(option, "--seed"))    options->seed = number;
+    else if (!strcmp(option, "--reps"))    options->reps = number;
+    else if (!strcmp(option, "--threads")) options->threads = number;
+    else { fprintf(stderr, "unknown option %s\n", option);  return false; }
+  }
+  if (strcmp(options->generator, "rmat") && strcmp(options->generator, "er") && strcmp(options->generator, "grid") &&
+      strcmp(options->generator, "star")) {
+    fprintf(stderr, "unknown graph %s\n", options->generator);
+    return false;
+  }
+  if (options->reorder && strcmp(options->reorder, "rcm") && strcmp(options->reorder, "degree") &&
+      strcmp(options->reorder, "bfs")) {
+    fprintf(stderr, "unknown ordering %s\n", options->reorder);
+    return false;
+  }
+  if (options->scale < 1 || options->scale > 30) { fprintf(stderr, "scale must be in [1, 30]\n");  return false; }
+  if (options->reps < 1 || options->reps > BENCH_MAX_REPS) {
+    fprintf(stderr, "reps must be in [1, %d]\n", BENCH_MAX_REPS);
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char **argv)
+{
+  bench_options_t options = { "rmat", 16, 16, 1, 5, 0, NULL, NULL };
+  if (!_bench_parse(argc, argv, &options)) {
+    _bench_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // generate
+  bench_graph_t edges;
+  memset(&edges, 0, sizeof(edges));
+  uint64_t random = options.seed;
+  double start = _bench_now();
+  if      (!strcmp(options.generator, "rmat")) _bench_rmat(&edges, options.scale, options.degree, &random);
+  else if (!strcmp(options.generator, "er"))   _bench_er(&edges, options.scale, options.degree, &random);
+  else if (!strcmp(options.generator, "star")) _bench_star(&edges, options.scale, &random);
+  else                                         _bench_grid(&edges, options.scale, &random);
+  double generate = _bench_now() - start;
+
+  bench_state_t state;
+  memset(&state, 0, sizeof(state));
+  state.options = &options;
+  state.random  = options.seed ^ UINT64_C(0x5851f42d4c957f2d);
+  state.first   = true;
+
+  printf("{\n  \"graph\": {\"generator\": \"%s\", \"scale\": %u, \"degree\": %u, \"seed\": %llu,"
+	 " \"ids\": %u, \"generated_edges\": %zu, \"generate_s\": %.6f},\n  \"kernels\": [",
+	 options.generator, options.scale, options.degree, (unsigned long long)options.seed,
+	 edges.num_ids, edges.size, generate);
+
+  // build: the graph is rebuilt every rep, the last one is kept
+  bench_timer_t timer;
+  timer.count = 0;
+  graphStatsReset();
+  for (unsigned int r = 0; r < options.reps; r++) {
+    if (state.graph) graphFree(state.graph);
+    start = _bench_now();
+    state.graph = graphBuildFromEdgeList(edges.src, edges.dst, edges.weights, edges.size, 0);
+    timer.times[timer.count++] = _bench_now() - start;
+  }
+  _bench_report("build", &timer, edges.size, &state.first);
+
+  timer.count = 0;
+  graphStatsReset();
+  for (unsigned int r = 0; r < options.reps; r++) {
+    if (state.csr) graphCSRFree(state.csr);
+    start = _bench_now();
+    state.csr = graphFreeze(state.graph);
+    timer.times[timer.count++] = _bench_now() - start;
+  }
+  _bench_report("freeze", &timer, state.csr->numEdge, &state.first);
+
+  if (options.reorder) {      // the kernels run on the reordered graph (the DAG is left alone)
+    unsigned int strategy = !strcmp(options.reorder, "rcm")    ? GRAPH_REORDER_RCM
+                          : !strcmp(options.reorder, "degree") ? GRAPH_REORDER_DEGREE : GRAPH_REORDER_BFS;
+    graph_t *reordered = NULL;
+    timer.count = 0;
+    graphStatsReset();
+    for (unsigned int r = 0; r < options.reps; r++) {
+      if (reordered) graphFree(reordered);
+      start = _bench_now();
+      reordered = graphReorder(state.graph, strategy, state.graph->vertex_head->id, NULL);
+      timer.times[timer.count++] = _bench_now() - start;
+    }
+    _bench_report("reorder", &timer, state.csr->numEdge, &state.first);
+    graphFree(state.graph);
+    graphCSRFree(state.csr);
+    state.graph = reordered;
+    state.csr   = graphFreeze(state.graph);
+  }
+  state.transpose = graphCSRTranspose(state.csr);
+
+  // the same edges, from smaller to larger id
+  for (size_t e = 0; e < edges.size; e++) {
+    if (edges.src[e] > edges.dst[e]) {
+      uint32_t tmp = edges.src[e];
+      edges.src[e] = edges.dst[e];
+      edges.dst[e] = tmp;
+    }
+  }
+  state.dag = graphBuildFromEdgeList(edges.src, edges.dst, edges.weights, edges.size, 0);
+  state.dag_csr = graphFreeze(state.dag);
+  state.order = (uint32_t*)malloc(sizeof(uint32_t) * (state.dag->numVertex ? state.dag->numVertex : 1));
+  if (!state.order) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  free(edges.src);
+  free(edges.dst);
+  free(edges.weights);
+
+  uint64_t num_edges = state.csr->numEdge;
+  for (int k = 0; k < BENCH_KERNELS; k++) {
+    if (!_bench_selected(&options, bench_kernel_names[k])) continue;
+    timer.count = 0;
+    graphStatsReset();
+    for (unsigned int r = 0; r < options.reps; r++) {
+      start = _bench_now();
+      _bench_run_kernel(&state, k);
+      timer.times[timer.count++] = _bench_now() - start;
+    }
+    _bench_report(bench_kernel_names[k], &timer, num_edges, &state.first);
+  }
+
+  printf("\n  ],\n  \"vertices\": %u, \"edges\": %llu, \"peak_rss_kb\": %ld\n}\n",
+	 state.graph->numVertex, (unsigned long long)num_edges, _bench_peak_rss_kb());
+
+  graphFree(state.graph);
+  graphFree(state.dag);
+  graphCSRFree(state.csr);
+  graphCSRFree(state.transpose);
+  graphCSRFree(state.dag_csr);
+  free(state.order);
+  return EXIT_SUCCESS;
+}
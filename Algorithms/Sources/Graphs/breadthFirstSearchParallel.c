@@ -0,0 +1,308 @@
+/*
+  Parallel, direction-optimizing Breadth-First Search
+  BFS explores the graph one level at a time: the frontier holds the vertices at depth d, and
+  the next frontier those at depth d+1. All vertices of a frontier may be expanded at the same
+  time, so the work of each level is split between threads, which meet at a barrier before the
+  next level starts (level-synchronous BFS). A vertex may be found by several threads at once;
+  the one that atomically sets its bit in the visited bitset claims it.
+
+  Top-down and bottom-up:
+  The usual, top-down, step looks at every edge leaving the frontier to find unvisited vertices.
+  On graphs of low diameter (social networks, the web) the frontier grows to a large part of the
+  graph within a few levels, and then almost every edge checked leads to a vertex that is already
+  visited. The bottom-up step turns this around: every unvisited vertex looks through its in-edges
+  for a parent in the frontier and stops at the first one it finds. When the frontier is large,
+  most unvisited vertices find a parent after a few edges, far fewer than top-down would check.
+  Bottom-up needs the in-edges of each vertex: the transpose of the snapshot, see graphCSRTranspose,
+  or the snapshot itself if the graph is undirected (symmetric).
+  Each thread owns the words of the bitsets it works on in a bottom-up step, so no atomics needed.
+
+  The switch between the two (Beamer, Asanovic and Patterson, 2012):
+    top-down  -> bottom-up   when m_f > m_u / alpha
+    bottom-up -> top-down    when n_f < n / beta, and the frontier is shrinking
+  where m_f is the number of edges leaving the frontier, m_u the number of edges leaving vertices
+  not yet visited, n_f the size of the frontier and n the number of vertices; alpha = 14 and
+  beta = 24. The top-down frontier is a queue (array) of vertex ids, the bottom-up frontier a
+  bitset over all ids; the frontier is converted between the two when the direction changes.
+
+  Running time: O(V+E) work, O(diameter) barriers.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../../Headers/graph.h"
+
+
+#define BFS_ALPHA       14
+#define BFS_BETA        24
+#define BFS_CHUNK       64     // frontier vertices claimed by a thread at a time (top-down)
+#define BFS_WORD_CHUNK  16     // bitset words of 64 ids claimed by a thread at a time (bottom-up)
+#define BFS_LOCAL_QUEUE 256    // vertices found by a thread before they are added to next
+
+
+/* State shared by the threads of one search. The leader (the calling thread) updates the
+ * frontier between the two barriers that separate levels; everything else is written by
+ * the threads either atomically or to the bitset words they have claimed.
+ */
+typedef struct bfs_shared_t {
+  graph_csr_t   *out;            // out-edges
+  graph_csr_t   *in;             // in-edges, for bottom-up
+  graph_dense_t *result;
+  pthread_barrier_t barrier;
+  bool           bottom_up;
+  bool           done;
+  int            level;          // depth of the vertices in the frontier
+  size_t         words;          // of each bitset
+
+  uint32_t      *frontier;       // top-down frontier
+  size_t         frontier_size;
+  uint32_t      *next;           // top-down next frontier
+  size_t         next_size;
+  uint64_t      *front_bits;     // bottom-up frontier
+  uint64_t      *next_bits;      // bottom-up next frontier
+
+  size_t         claim;          // start of the next piece of work to be claimed
+  uint64_t       next_count;     // n_f of next frontier
+  uint64_t       next_edges;     // m_f of next frontier
+  uint64_t       unexplored;     // m_u
+  uint64_t       prev_count;
+} bfs_shared_t;
+
+
+static
+void* _bfs_malloc(size_t size)
+{
+  void *new = malloc(size ? size : 1);
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
+
+static inline
+uint64_t _bfs_degree(graph_csr_t *csr, uint32_t v)
+{
+  return csr->offsets[v + 1] - csr->offsets[v];
+}
+
+// appends the vertices a thread found to the shared next frontier
+static
+void _bfs_flush(bfs_shared_t *shared, uint32_t *local, size_t size)
+{
+  size_t pos = __atomic_fetch_add(&shared->next_size, size, __ATOMIC_RELAXED);
+  memcpy(shared->next + pos, local, sizeof(uint32_t) * size);
+}
+
+
+static
+void _bfs_top_down_step(bfs_shared_t *shared)
+{
+  graph_csr_t *csr = shared->out;
+  uint64_t *visited = shared->result->visited;
+  uint32_t local[BFS_LOCAL_QUEUE];
+  size_t   local_size = 0;
+  uint64_t count = 0, edges = 0;
+
+  for (;;) {
+    size_t begin = __atomic_fetch_add(&shared->claim, BFS_CHUNK, __ATOMIC_RELAXED);
+    if (begin >= shared->frontier_size) break;
+    size_t end = begin + BFS_CHUNK < shared->frontier_size ? begin + BFS_CHUNK : shared->frontier_size;
+
+    for (size_t i = begin; i < end; i++) {
+      uint32_t current = shared->frontier[i];
+      for (uint64_t e = csr->offsets[current]; e < csr->offsets[current + 1]; e++) {
+	uint32_t  v    = csr->targets[e];
+	uint64_t  bit  = UINT64_C(1) << (v & 63);
+	GRAPH_STAT_ADD(edges_scanned, 1);
+	uint64_t *word = &visited[v >> 6];
+
+	// cheap test first; only the thread whose fetch_or sets the bit claims v
+	if (__atomic_load_n(word, __ATOMIC_RELAXED) & bit) continue;
+	if (__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit) continue;
+
+	shared->result->dist[v] = shared->level + 1;
+	shared->result->pred[v] = current;
+	GRAPH_STAT_ADD(vertices_visited, 1);
+	count++;
+	edges += _bfs_degree(csr, v);
+	local[local_size++] = v;
+	if (local_size == BFS_LOCAL_QUEUE) { _bfs_flush(shared, local, local_size);  local_size = 0; }
+      }
+    }
+  }
+  if (local_size) _bfs_flush(shared, local, local_size);
+  __atomic_fetch_add(&shared->next_count, count, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&shared->next_edges, edges, __ATOMIC_RELAXED);
+}
+
+
+static
+void _bfs_bottom_up_step(bfs_shared_t *shared)
+{
+  graph_csr_t *in = shared->in;
+  uint64_t *visited = shared->result->visited;
+  unsigned int size = shared->result->size;
+  uint64_t count = 0, edges = 0;
+
+  for (;;) {
+    size_t begin = __atomic_fetch_add(&shared->claim, BFS_WORD_CHUNK, __ATOMIC_RELAXED);
+    if (begin >= shared->words) break;
+    size_t end = begin + BFS_WORD_CHUNK < shared->words ? begin + BFS_WORD_CHUNK : shared->words;
+
+    for (size_t w = begin; w < end; w++) {
+      uint64_t unvisited = ~visited[w];
+      if (w == shared->words - 1 && size % 64) unvisited &= (UINT64_C(1) << (size % 64)) - 1;
+      uint64_t found = 0;
+
+      while (unvisited) {
+	unsigned int bit = __builtin_ctzll(unvisited);
+	uint32_t v = w * 64 + bit;
+	unvisited &= unvisited - 1;
+
+	// first in-neighbor in the frontier becomes the parent
+	for (uint64_t e = in->offsets[v]; e < in->offsets[v + 1]; e++) {
+	  uint32_t u = in->targets[e];
+	  GRAPH_STAT_ADD(edges_scanned, 1);
+	  if ((shared->front_bits[u >> 6] >> (u & 63)) & 1) {
+	    GRAPH_STAT_ADD(vertices_visited, 1);
+	    shared->result->dist[v] = shared->level + 1;
+	    shared->result->pred[v] = u;
+	    found |= UINT64_C(1) << bit;
+	    count++;
+	    edges += _bfs_degree(shared->out, v);
+	    break;
+	  }
+	}
+      }
+      visited[w] |= found;
+      shared->next_bits[w] = found;
+    }
+  }
+  __atomic_fetch_add(&shared->next_count, count, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&shared->next_edges, edges, __ATOMIC_RELAXED);
+}
+
+
+// leader only: makes the next frontier current and picks the direction of the next level
+static
+void _bfs_next_level(bfs_shared_t *shared)
+{
+  uint64_t n_f = shared->next_count;
+  uint64_t m_f = shared->next_edges;
+  shared->unexplored -= m_f;
+  shared->level++;
+
+  if (n_f == 0) { shared->done = true;  return; }
+
+  if (!shared->bottom_up) {
+    if (m_f > shared->unexplored / BFS_ALPHA) {
+      shared->bottom_up = true;              // queue to bitset
+      memset(shared->front_bits, 0, sizeof(uint64_t) * shared->words);
+      for (size_t i = 0; i < shared->next_size; i++) {
+	uint32_t v = shared->next[i];
+	shared->front_bits[v >> 6] |= UINT64_C(1) << (v & 63);
+      }
+    } else {
+      uint32_t *tmp = shared->frontier;
+      shared->frontier = shared->next;
+      shared->next = tmp;
+      shared->frontier_size = shared->next_size;
+    }
+  } else {
+    if (n_f < shared->out->numVertex / BFS_BETA && n_f < shared->prev_count) {
+      shared->bottom_up = false;             // bitset to queue
+      shared->frontier_size = 0;
+      for (size_t w = 0; w < shared->words; w++) {
+	uint64_t bits = shared->next_bits[w];
+	while (bits) {
+	  shared->frontier[shared->frontier_size++] = w * 64 + __builtin_ctzll(bits);
+	  bits &= bits - 1;
+	}
+      }
+    } else {
+      uint64_t *tmp = shared->front_bits;
+      shared->front_bits = shared->next_bits;
+      shared->next_bits = tmp;
+    }
+  }
+  shared->next_size  = 0;
+  shared->claim      = 0;
+  shared->next_count = 0;
+  shared->next_edges = 0;
+  shared->prev_count = n_f;
+}
+
+
+static
+void _bfs_run(bfs_shared_t *shared, bool leader)
+{
+  for (;;) {
+    pthread_barrier_wait(&shared->barrier);      // level starts
+    if (shared->done) return;
+    if (shared->bottom_up) _bfs_bottom_up_step(shared);
+    else                   _bfs_top_down_step(shared);
+    pthread_barrier_wait(&shared->barrier);      // level ends
+    if (leader) _bfs_next_level(shared);
+  }
+}
+
+static
+void* _bfs_worker(void *shared)
+{
+  _bfs_run((bfs_shared_t*)shared, false);
+  return NULL;
+}
+
+
+graph_dense_t* breadthFirstSearchParallel(graph_csr_t *csr, graph_csr_t *transpose,
+					  unsigned int source, unsigned int threads)
+{
+  graph_dense_t *result = graphDenseBuild(csr->listSize);
+  if (source >= csr->listSize) return result;
+
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+
+  bfs_shared_t shared;
+  memset(&shared, 0, sizeof(shared));
+  shared.out        = csr;
+  shared.in         = transpose ? transpose : csr;
+  shared.result     = result;
+  shared.words      = ((size_t)csr->listSize + 63) / 64;
+  shared.frontier   = (uint32_t*)_bfs_malloc(sizeof(uint32_t) * csr->listSize);
+  shared.next       = (uint32_t*)_bfs_malloc(sizeof(uint32_t) * csr->listSize);
+  shared.front_bits = (uint64_t*)_bfs_malloc(sizeof(uint64_t) * shared.words);
+  shared.next_bits  = (uint64_t*)_bfs_malloc(sizeof(uint64_t) * shared.words);
+
+  result->dist[source] = 0;
+  graphDenseMarkVisited(result, source);
+  shared.frontier[0]   = source;
+  shared.frontier_size = 1;
+  shared.prev_count    = 1;
+  shared.unexplored    = csr->numEdge - _bfs_degree(csr, source);
+
+  pthread_barrier_init(&shared.barrier, NULL, threads);
+  pthread_t *workers = (pthread_t*)_bfs_malloc(sizeof(pthread_t) * threads);
+  for (unsigned int t = 1; t < threads; t++) {
+    if (pthread_create(&workers[t], NULL, _bfs_worker, &shared)) {
+      perror("pthread_create");  exit(EXIT_FAILURE);
+    }
+  }
+  _bfs_run(&shared, true);
+  for (unsigned int t = 1; t < threads; t++) { pthread_join(workers[t], NULL); }
+  pthread_barrier_destroy(&shared.barrier);
+
+  free(workers);
+  free(shared.frontier);
+  free(shared.next);
+  free(shared.front_bits);
+  free(shared.next_bits);
+  return result;
+}
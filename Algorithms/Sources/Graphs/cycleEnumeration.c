@@ -0,0 +1,369 @@
+/*
+  Cycle Enumeration: Johnson's algorithm (Johnson, 1975)
+  An elementary cycle (or circuit) is a path that ends where it began and visits no vertex
+  twice. A graph may have exponentially many of them, so no algorithm is fast in the size of
+  the graph alone; Johnson's is fast in the size of its output: O((V + E)(C + 1)) time for C
+  cycles, and O(V + E) memory. The cycles of a lock-order graph are its potential deadlocks.
+
+  A DFS finds a cycle for every back edge it meets, but not every cycle: two cycles through
+  the same back edge show as one, and a cycle made of tree and cross edges not at all.
+  Johnson's algorithm finds each one exactly once, by its least vertex s: all cycles through
+  s are searched for in the graph induced by s and the vertices after it, then s is dropped.
+  Only the strongly connected component of s in that graph can hold such cycles, so the
+  search is confined to it (and a vertex in no component with a cycle is skipped).
+  The search from s is a DFS in which a vertex is blocked while it is on the path, and stays
+  blocked after it is left without having led to a cycle: no path from it back to s avoids
+  the path, so trying it again would be in vain. Such a vertex is noted, in a list B(w), with
+  each of its successors w. When a vertex does lead to a cycle it is unblocked, and so are,
+  transitively through their B lists, the vertices that were only blocked because of it.
+  Thanks to blocking, at most O(V + E) work is done between two cycles found.
+
+  Limits:
+  The enumeration can stop after a number of cycles, or at the callback's request, and can
+  leave out the cycles longer than a given length. With a length limit a vertex left for want
+  of length is not blocked, as a shorter path might still lead from it to s; the search stays
+  exact but is then no longer bound by the number of cycles found.
+
+  In my implementation the strongly connected components of the whole graph are found first
+  (stronglyConnectedComponentsTarjan), and each component with a cycle is then copied into a
+  small CSR of its own: vertices renumbered in the order of their ids, edges leaving the
+  component dropped, and parallel edges merged - cycles are sequences of vertices, so a
+  MultiGraph doesn't report a cycle once per parallel edge. Both the searches and the
+  components of the shrinking subgraphs (by Tarjan's algorithm again) run on these copies,
+  iteratively, so long cycles don't overflow the stack.
+  In undirected graphs every edge is a cycle of two vertices, and every cycle is found twice,
+  once in each direction: the enumeration is meant for directed graphs.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../Headers/graph.h"
+
+
+typedef struct cycle_enum_t {
+  // the caller's
+  unsigned int   max_length;    // 0 for no limit
+  size_t         max_cycles;    // 0 for no limit
+  int          (*sink)(const unsigned int*, unsigned int, void*);
+  void          *arg;
+  size_t         count;         // cycles reported
+  bool           stop;
+
+  // the component being searched; vertices are numbered 0..size-1 in the order of their ids
+  unsigned int   size;
+  unsigned int  *ids;           // vertex id of each vertex
+  unsigned int  *offsets;       // size + 1: edges of vertex v are targets[offsets[v]..offsets[v+1])
+  unsigned int  *targets;
+  bool          *loop;          // vertex has an edge to itself
+
+  // components of the subgraph of vertices >= some start
+  int           *index;
+  int           *low;
+  unsigned int  *label;         // component of each vertex
+  unsigned int  *members;       // number of vertices of each component
+  unsigned int  *waiting;       // vertices waiting for their component
+  bool          *on_stack;
+
+  // the search from s
+  bool          *blocked;
+  unsigned int **b_list;        // B(w): blocked vertices to unblock with w
+  unsigned int  *b_size;
+  unsigned int  *b_capacity;
+  unsigned int  *path;          // DFS path, s first
+  unsigned int  *cursor;        // next edge of each vertex on path
+  bool          *closes;        // vertex on path has led to a cycle
+  unsigned int  *cycle;         // ids of a cycle, handed to sink
+} cycle_enum_t;
+
+
+static
+void* _cycle_malloc(size_t size)
+{
+  void *new = malloc(size ? size : 1);
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
+
+
+/*                      */
+/*     Components       */
+/*                      */
+
+// Tarjan's algorithm on the subgraph of vertices >= start; the DFS path is kept in path/cursor
+static
+void _cycle_components(cycle_enum_t *e, unsigned int start)
+{
+  int counter = 0;
+  unsigned int labels = 0, top = 0;
+  for (unsigned int v = start; v < e->size; v++) { e->index[v] = -1;  e->on_stack[v] = false; }
+
+  for (unsigned int root = start; root < e->size; root++) {
+    if (e->index[root] != -1) continue;
+    unsigned int depth = 0;
+    e->index[root] = e->low[root] = counter++;
+    e->waiting[top++] = root;
+    e->on_stack[root] = true;
+    e->path[depth] = root;
+    e->cursor[depth++] = e->offsets[root];
+
+    while (depth) {
+      unsigned int v = e->path[depth - 1];
+      if (e->cursor[depth - 1] < e->offsets[v + 1]) {
+	unsigned int w = e->targets[e->cursor[depth - 1]++];
+	if (w < start) continue;
+	if (e->index[w] == -1) {
+	  e->index[w] = e->low[w] = counter++;
+	  e->waiting[top++] = w;
+	  e->on_stack[w] = true;
+	  e->path[depth] = w;
+	  e->cursor[depth++] = e->offsets[w];
+	} else if (e->on_stack[w] && e->index[w] < e->low[v]) {
+	  e->low[v] = e->index[w];
+	}
+	continue;
+      }
+
+      depth--;
+      if (depth && e->low[v] < e->low[e->path[depth - 1]]) e->low[e->path[depth - 1]] = e->low[v];
+      if (e->low[v] == e->index[v]) {              // v is the first of its component
+	unsigned int member;
+	e->members[labels] = 0;
+	do {
+	  member = e->waiting[--top];
+	  e->on_stack[member] = false;
+	  e->label[member] = labels;
+	  e->members[labels]++;
+	} while (member != v);
+	labels++;
+      }
+    }
+  }
+}
+
+
+/*                      */
+/*       Circuits       */
+/*                      */
+
+static
+void _cycle_unblock(cycle_enum_t *e, unsigned int u)
+{
+  // waiting doubles as the stack of vertices whose B lists are still to be emptied
+  unsigned int top = 0;
+  e->blocked[u] = false;
+  e->waiting[top++] = u;
+  while (top) {
+    unsigned int x = e->waiting[--top];
+    for (unsigned int i = 0; i < e->b_size[x]; i++) {
+      unsigned int w = e->b_list[x][i];
+      if (e->blocked[w]) {
+	e->blocked[w] = false;
+	e->waiting[top++] = w;
+      }
+    }
+    e->b_size[x] = 0;
+  }
+}
+
+static
+void _cycle_b_add(cycle_enum_t *e, unsigned int w, unsigned int v)
+{
+  for (unsigned int i = 0; i < e->b_size[w]; i++) {
+    if (e->b_list[w][i] == v) return;
+  }
+  if (e->b_size[w] == e->b_capacity[w]) {
+    e->b_capacity[w] = e->b_capacity[w] ? e->b_capacity[w] * 2 : 4;
+    e->b_list[w] = (unsigned int*)realloc(e->b_list[w], sizeof(unsigned int) * e->b_capacity[w]);
+    if (!e->b_list[w]) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+  }
+  e->b_list[w][e->b_size[w]++] = v;
+}
+
+static
+void _cycle_report(cycle_enum_t *e, unsigned int length)
+{
+  for (unsigned int i = 0; i < length; i++) { e->cycle[i] = e->ids[e->path[i]]; }
+  e->count++;
+  if (e->sink && e->sink(e->cycle, length, e->arg)) e->stop = true;
+  if (e->max_cycles && e->count >= e->max_cycles) e->stop = true;
+}
+
+// all cycles through s, in the component of s among the vertices >= s
+static
+void _cycle_circuits(cycle_enum_t *e, unsigned int s)
+{
+  unsigned int component = e->label[s];
+  for (unsigned int v = s; v < e->size; v++) {
+    if (e->label[v] == component) { e->blocked[v] = false;  e->b_size[v] = 0; }
+  }
+
+  unsigned int depth = 0;
+  e->blocked[s] = true;
+  e->closes[depth] = false;
+  e->path[depth] = s;
+  e->cursor[depth++] = e->offsets[s];
+
+  while (depth) {
+    unsigned int v = e->path[depth - 1];
+    if (e->cursor[depth - 1] < e->offsets[v + 1]) {
+      unsigned int w = e->targets[e->cursor[depth - 1]++];
+      if (w < s || e->label[w] != component) continue;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (w == s) {
+	e->closes[depth - 1] = true;
+	_cycle_report(e, depth);
+	if (e->stop) return;
+      } else if (!e->blocked[w]) {
+	if (e->max_length && depth >= e->max_length) {
+	  e->closes[depth - 1] = true;             // length, not blocking, stopped us: don't block v
+	  continue;
+	}
+	GRAPH_STAT_ADD(vertices_visited, 1);
+	e->blocked[w] = true;
+	e->closes[depth] = false;
+	e->path[depth] = w;
+	e->cursor[depth++] = e->offsets[w];
+      }
+      continue;
+    }
+
+    depth--;
+    if (e->closes[depth]) {
+      _cycle_unblock(e, v);
+      if (depth) e->closes[depth - 1] = true;
+    } else {
+      for (unsigned int i = e->offsets[v]; i < e->offsets[v + 1]; i++) {
+	unsigned int w = e->targets[i];
+	if (w >= s && e->label[w] == component) _cycle_b_add(e, w, v);
+      }
+    }
+  }
+}
+
+// Johnson's algorithm on the component copied into e
+static
+void _cycle_component(cycle_enum_t *e)
+{
+  unsigned int start = 0;
+  while (start < e->size && !e->stop) {
+    _cycle_components(e, start);
+    unsigned int s = start;
+    while (s < e->size && e->members[e->label[s]] == 1 && !e->loop[s]) s++;
+    if (s == e->size) return;
+    _cycle_circuits(e, s);
+    start = s + 1;
+  }
+}
+
+
+size_t graphCycleEnumerate(graph_t *graph, unsigned int max_length, size_t max_cycles,
+			   int (*sink)(const unsigned int*, unsigned int, void*), void *arg)
+{
+  unsigned int num_scc;
+  int *scc = stronglyConnectedComponentsTarjan(graph, &num_scc);
+
+  // members of each scc, by increasing id
+  unsigned int *first = (unsigned int*)calloc((size_t)num_scc + 1, sizeof(unsigned int));
+  unsigned int *by_scc = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * graph->numVertex);
+  if (!first) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  size_t num_edges = 0;
+  for (unsigned int id = 0; id < graph->listSize; id++) {
+    if (scc[id] >= 0) first[scc[id] + 1]++;
+    num_edges += graph->degree_out[id];
+  }
+  for (unsigned int c = 0; c < num_scc; c++) { first[c + 1] += first[c]; }
+  for (unsigned int id = 0; id < graph->listSize; id++) {
+    if (scc[id] >= 0) by_scc[first[scc[id]]++] = id;
+  }
+  for (unsigned int c = num_scc; c > 0; c--) { first[c] = first[c - 1]; }
+  first[0] = 0;
+
+  size_t n = graph->numVertex;
+  cycle_enum_t e;
+  memset(&e, 0, sizeof(e));
+  e.max_length = max_length;
+  e.max_cycles = max_cycles;
+  e.sink       = sink;
+  e.arg        = arg;
+  e.offsets    = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * (n + 1));
+  e.targets    = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * num_edges);
+  e.loop       = (bool*)_cycle_malloc(sizeof(bool) * n);
+  e.index      = (int*)_cycle_malloc(sizeof(int) * n);
+  e.low        = (int*)_cycle_malloc(sizeof(int) * n);
+  e.label      = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  e.members    = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  e.waiting    = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  e.on_stack   = (bool*)_cycle_malloc(sizeof(bool) * n);
+  e.blocked    = (bool*)_cycle_malloc(sizeof(bool) * n);
+  e.path       = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  e.cursor     = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  e.closes     = (bool*)_cycle_malloc(sizeof(bool) * n);
+  e.cycle      = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  e.b_list     = (unsigned int**)calloc(n ? n : 1, sizeof(unsigned int*));
+  e.b_size     = (unsigned int*)calloc(n ? n : 1, sizeof(unsigned int));
+  e.b_capacity = (unsigned int*)calloc(n ? n : 1, sizeof(unsigned int));
+  // number of each vertex within its scc; seen[t] == v + 1 once edge v -> t is copied
+  unsigned int *local = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * graph->listSize);
+  unsigned int *seen  = (unsigned int*)_cycle_malloc(sizeof(unsigned int) * n);
+  if (!e.b_list || !e.b_size || !e.b_capacity) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+
+  for (unsigned int c = 0; c < num_scc && !e.stop; c++) {
+    e.ids  = by_scc + first[c];
+    e.size = first[c + 1] - first[c];
+    if (e.size == 1 && !graphExistsEdge(graph, graph->vertex_index[e.ids[0]], graph->vertex_index[e.ids[0]])) {
+      continue;                                    // a single vertex without a loop: no cycle
+    }
+
+    for (unsigned int v = 0; v < e.size; v++) { local[e.ids[v]] = v;  seen[v] = 0; }
+    unsigned int num = 0;
+    for (unsigned int v = 0; v < e.size; v++) {
+      e.offsets[v] = num;
+      e.loop[v] = false;
+      for (adjacencyListNode_t *edge = graph->list[e.ids[v]]; edge; edge = edge->next) {
+	unsigned int to = edge->vertex->id;
+	if (scc[to] != (int)c || seen[local[to]] == v + 1) continue;
+	seen[local[to]] = v + 1;
+	if (local[to] == v) e.loop[v] = true;
+	e.targets[num++] = local[to];
+      }
+    }
+    e.offsets[e.size] = num;
+    _cycle_component(&e);
+  }
+
+  for (size_t v = 0; v < n; v++) { free(e.b_list[v]); }
+  free(e.b_list);  free(e.b_size);  free(e.b_capacity);
+  free(e.offsets);  free(e.targets);  free(e.loop);
+  free(e.index);  free(e.low);  free(e.label);  free(e.members);  free(e.waiting);  free(e.on_stack);
+  free(e.blocked);  free(e.path);  free(e.cursor);  free(e.closes);  free(e.cycle);
+  free(local);  free(seen);  free(first);  free(by_scc);  free(scc);
+  return e.count;
+}
+
+
+static
+int _cycle_print(const unsigned int *cycle, unsigned int length, void *arg)
+{
+  (void)arg;
+  printf("Cycle found: ");
+  for (unsigned int i = 0; i < length; i++) { printf("%u->", cycle[i]); }
+  printf("%u\n", cycle[0]);
+  return 0;
+}
+
+
+void graphCycleEnum(graph_t *graph)
+{
+  graphCycleEnumerate(graph, 0, 0, _cycle_print, NULL);
+}
@@ -46,6 +46,8 @@
   In order to identify the vertices in a cycle once you have found the backward
   edge, travel back along the tree edges in the DFS-forest until you reach the
   vertix identified as the predecessor vertix by the backward edge.
+  That finds one cycle per backward edge, not all of them: graphCycleEnum lists
+  every elementary cycle by Johnson's algorithm instead (see cycleEnumeration.c).
 
   Topological Sort:  O(V + E)
   Topological sort is ran only on directed acyclic graphs (DAGs). A directed
@@ -59,6 +61,12 @@
   vertices at the head of a linked list as they are finished.
   Applications include job scheduling (determining ordering of tasks where edges
   represent constraints in regard to the task's precedence).
+  Kahn's algorithm (graphTopologicalOrder) sorts without DFS: a vertex with no in-edges
+  left can come next. It starts from the vertices of in-degree 0, and each vertex output
+  takes one off the in-degree of every vertex it leads to - a copy of the graph's degree_in,
+  which the graph keeps anyway. The order is written to a flat array of ids, and the array
+  doubles as the queue: nothing is allocated per vertex. A cycle shows as vertices that never
+  reach in-degree 0, so fewer ids are written than the graph has members.
 
   Strongly Connected Components (scc) decomposition:  O(V+E)
   Many graph algorithms require scc as their input. Decomposing a graph into its scc
@@ -73,158 +81,214 @@
   of the input graph AND the order in which the DFS function enters into the graph
   corresponds to the reverse of the finishing times as identified in the first DFS.
   Each forest produced by the second DFS (on the transpose) is a scc.
-  In my implementation I modified how I use the array mentioned in the above two
-  sections such that at each index (corresponding to a vertex's id) I store its
-  finishing position - 1 if vertex finished first, 5 if it finished fifth, etc.
-  All positions corresponding to vertices not in the graph are defaulted to 0.
-  The second running of DFS than finds the highest value in this array and enters
-  DFS on its vertex. This is continued until all positions have been explored.
+  In my implementation the first DFS records, at each index (corresponding to a vertex's
+  id) of an array, its finishing position - 1 if vertex finished first, 5 if it finished
+  fifth, etc. This array is then inverted, such that the second DFS can enter the vertices
+  from the latest finishing position down. If the graph keeps a reverse adjacency list
+  (see graphEnableReverse) the second DFS follows it instead of building the transpose.
+
+  Tarjan's algorithm finds the scc in a single DFS, without the transpose. Every vertex
+  gets a discovery index, and a low value: the smallest index reachable from its subtree
+  through at most one edge that leads back to a vertex still waiting for its scc. Vertices
+  wait on a second stack in discovery order. When a vertex finishes with low == index,
+  nothing it reaches leads further back: it is the first vertex of its scc, and the scc is
+  every vertex above it on the second stack.
+
+  One engine for all of the above:
+  Written recursively, each of these algorithms needs one C stack frame per vertex on the
+  current path, and a long path (a chain of a million dependencies) overflows the stack.
+  All of them therefore run on one iterative DFS engine (dfs_t below). It keeps its own
+  stack on the heap: for every vertex on the current path, the next of its edges still to
+  be explored, so vertices are discovered and finished in exactly the order recursion would
+  discover and finish them. What the algorithms do differently happens in three hooks:
+  pre (vertex discovered), edge (edge examined, before its destination may be discovered)
+  and post (vertex finished). The engine's per-vertex state lives in arrays indexed by id.
 */
 
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "../../Headers/graph.h"
 #include "../../Headers/Graphs/hashTables.h"
 
 
 /*                                            */
-/*       Depth-First Search                   */
+/*       DFS engine                           */
 /*                                            */
 
+enum { DFS_NEW = 0, DFS_ACTIVE, DFS_DONE };  // ACTIVE: on the stack, i.e. being explored
+
+typedef struct dfs_t {
+  graph_t               *graph;
+  adjacencyListNode_t  **lists;     // the adjacency lists to follow: graph's list, or reverse
+  int                   *parent;    // listSize: id of parent in DFS forest, -1 for roots
+  unsigned char         *state;     // listSize: DFS_NEW, DFS_ACTIVE or DFS_DONE
+  graph_vertex         **stack;     // current path, root first
+  adjacencyListNode_t  **cursor;    // next edge to explore of each vertex on the stack
+  size_t                 top;       // number of vertices on the stack
+
+  // hooks, each may be NULL; the vertex at stack[top - 1] is the one being explored
+  void (*pre) (struct dfs_t*, graph_vertex*);                 // discovered, not yet on stack
+  void (*edge)(struct dfs_t*, graph_vertex*, graph_vertex*);  // edge from, to examined
+  void (*post)(struct dfs_t*, graph_vertex*);                 // finished, already off stack
+  void  *arg;
+} dfs_t;
+
+
 static
-void _depthFirstSearch_visit(graph_t *graph, int parent_id, hashTable **parents)
+void _dfs_init(dfs_t *dfs, graph_t *graph, adjacencyListNode_t **lists)
 {
-  adjacencyListNode_t *edge = graph->list[parent_id];
-  while (edge) {
-    if (!hashTableSearchNode( (*parents), &edge->vertex->id, keyConvertFromInt)) {
-      hashTableInsertNode( &(*parents), nodeHashTable_int(edge->vertex->id, parent_id, parent_id));
-      _depthFirstSearch_visit(graph, edge->vertex->id, parents);
-    }
-    edge = edge->next;
+  size_t capacity = graph->numVertex ? graph->numVertex : 1;
+  size_t size     = graph->listSize  ? graph->listSize  : 1;
+  memset(dfs, 0, sizeof(*dfs));
+  dfs->graph  = graph;
+  dfs->lists  = lists;
+  dfs->parent = (int*)malloc(sizeof(int) * size);
+  dfs->state  = (unsigned char*)calloc(size, sizeof(unsigned char));
+  dfs->stack  = (graph_vertex**)malloc(sizeof(graph_vertex*) * capacity);
+  dfs->cursor = (adjacencyListNode_t**)malloc(sizeof(adjacencyListNode_t*) * capacity);
+  if (!dfs->parent || !dfs->state || !dfs->stack || !dfs->cursor) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
   }
+  for (size_t i = 0; i < graph->listSize; i++) { dfs->parent[i] = -1; }
 }
 
 
-hashTable* depthFirstSearch(graph_t *graph)
+static
+void _dfs_destroy(dfs_t *dfs)
 {
-  hashTable *parent = hashTableBuild();
+  free(dfs->parent);
+  free(dfs->state);
+  free(dfs->stack);
+  free(dfs->cursor);
+}
 
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    if (!hashTableSearchNode(parent, &curr->id, keyConvertFromInt)) {
-      hashTableInsertNode(&parent, nodeHashTable_int(curr->id, -1, -1));
-      _depthFirstSearch_visit(graph, curr->id, &parent);
+
+static inline
+void _dfs_push(dfs_t *dfs, graph_vertex *vertex, int parent_id)
+{
+  GRAPH_STAT_ADD(vertices_visited, 1);
+  dfs->state[vertex->id]  = DFS_ACTIVE;
+  dfs->parent[vertex->id] = parent_id;
+  if (dfs->pre) dfs->pre(dfs, vertex);
+  dfs->stack[dfs->top]  = vertex;
+  dfs->cursor[dfs->top] = dfs->lists[vertex->id];
+  dfs->top++;
+}
+
+
+// explores everything reachable from root that has not been explored yet
+static
+void _dfs_visit(dfs_t *dfs, graph_vertex *root)
+{
+  _dfs_push(dfs, root, -1);
+
+  while (dfs->top > 0) {
+    graph_vertex        *from = dfs->stack[dfs->top - 1];
+    adjacencyListNode_t *edge = dfs->cursor[dfs->top - 1];
+    if (!edge) {                // all edges explored: vertex finishes
+      dfs->top--;
+      dfs->state[from->id] = DFS_DONE;
+      if (dfs->post) dfs->post(dfs, from);
+      continue;
     }
+    dfs->cursor[dfs->top - 1] = edge->next;
+    GRAPH_STAT_ADD(edges_scanned, 1);
+
+    if (dfs->edge) dfs->edge(dfs, from, edge->vertex);
+    if (dfs->state[edge->vertex->id] == DFS_NEW) { _dfs_push(dfs, edge->vertex, from->id); }
+  }
+}
+
+
+// explores the whole graph, entering it in the order of its list of vertices
+static
+void _dfs_run(dfs_t *dfs)
+{
+  graph_vertex *curr = dfs->graph->vertex_head;
+  while (curr) {
+    if (dfs->state[curr->id] == DFS_NEW) _dfs_visit(dfs, curr);
     curr = curr->next;
   }
-  return parent;
 }
 
 
-/*                      */
-/*   Cycle Detection    */
-/*                      */
+/*                                            */
+/*       Depth-First Search                   */
+/*                                            */
 
 static
-void _DFS_visit_cycle_detect(graph_t *graph, int parent_id, hashTable **parents, int *progress_array, int *num_cycles)
+void _dfs_pre_forest(dfs_t *dfs, graph_vertex *vertex)
 {
-  adjacencyListNode_t *edge = graph->list[parent_id];
-  while (edge) {
-    if (progress_array[edge->vertex->id] == 1 &&
-	hashTableSearchNode( (*parents), &parent_id, keyConvertFromInt)->graph_predecessor != edge->vertex->id) { // for undirected graphs
-      *num_cycles += 1;
-    }
-    if (!hashTableSearchNode( (*parents), &edge->vertex->id, keyConvertFromInt)) {
-      progress_array[edge->vertex->id] = 1;
-      hashTableInsertNode( &(*parents), nodeHashTable_int(edge->vertex->id, parent_id, parent_id));
-      _DFS_visit_cycle_detect(graph, edge->vertex->id, parents, progress_array, num_cycles);
-      progress_array[edge->vertex->id] = 0;
-    }
-    edge = edge->next;
-  }
+  graph_dense_t *forest = (graph_dense_t*)dfs->arg;
+  graphDenseMarkVisited(forest, vertex->id);
+  forest->pred[vertex->id] = dfs->parent[vertex->id];
+  forest->dist[vertex->id] = dfs->top;     // depth: number of ancestors on the stack
 }
 
 
-int graphExistsCycle(graph_t *graph)
+graph_dense_t* depthFirstSearchDense(graph_t *graph)
 {
-  hashTable *parent = hashTableBuild();
-  int num_cycles = 0;
-  int in_progress[graph->listSize];
-  for (size_t i = 0; i < graph->listSize; i++) { in_progress[i] = 0; }
+  graph_dense_t *forest = graphDenseBuild(graph->listSize);
+  dfs_t dfs;
+  _dfs_init(&dfs, graph, graph->list);
+  dfs.pre = _dfs_pre_forest;
+  dfs.arg = forest;
+  _dfs_run(&dfs);
+  _dfs_destroy(&dfs);
+  return forest;
+}
+
+
+hashTable* depthFirstSearch(graph_t *graph)
+{
+  graph_dense_t *forest = depthFirstSearchDense(graph);
 
+  // the values of a DFS forest are parents, not depths
+  hashTable *parent = hashTableBuild();
   graph_vertex *curr = graph->vertex_head;
   while (curr) {
-    if (!hashTableSearchNode(parent, &curr->id, keyConvertFromInt)) {
-      in_progress[curr->id] = 1;
-      hashTableInsertNode(&parent, nodeHashTable_int(curr->id, -1, -1));
-      _DFS_visit_cycle_detect(graph, curr->id, &parent, in_progress, &num_cycles);
-      in_progress[curr->id] = 0;
-    }
+    int parent_id = forest->pred[curr->id];
+    hashTableInsertNode(&parent, nodeHashTable_int(curr->id, parent_id, parent_id));
     curr = curr->next;
   }
-  hashTableFree(parent);
-  return num_cycles;
+  graphDenseFree(forest);
+  return parent;
 }
 
 
 /*                      */
-/*   Cycle Enumeration  */
+/*   Cycle Detection    */
 /*                      */
 
-static
-void _print_cycle_path(hashTable *parents, int cycle_origin, int cycle_end)
+// an edge back to a vertex on the stack closes a cycle, unless it is the tree edge
+// just taken, walked back the other way (for undirected graphs)
+static inline
+bool _dfs_back_edge(dfs_t *dfs, graph_vertex *from, graph_vertex *to)
 {
-  if (cycle_origin == cycle_end) { printf("%d->", cycle_end); }
-  else {
-    int parent = hashTableSearchNode(parents, &cycle_end, keyConvertFromInt)->graph_predecessor;
-    _print_cycle_path(parents, cycle_origin, parent);
-    printf("%d->", cycle_end);
-  }
+  return dfs->state[to->id] == DFS_ACTIVE && dfs->parent[from->id] != (int)to->id;
 }
 
 
 static
-void _DFS_visit_cycle_enumerate(graph_t *graph, int parent_id, hashTable **parents, int *progress_array)
+void _dfs_edge_cycle_count(dfs_t *dfs, graph_vertex *from, graph_vertex *to)
 {
-  adjacencyListNode_t *edge = graph->list[parent_id];
-  while (edge) {
-    if (progress_array[edge->vertex->id] == 1 &&
-	hashTableSearchNode( (*parents), &parent_id, keyConvertFromInt)->graph_predecessor != edge->vertex->id) { // for undirected graphs
-      printf("Cycle found: ");
-      _print_cycle_path( (*parents), edge->vertex->id, parent_id);
-      printf("\n");
-    }
-
-    if (!hashTableSearchNode( (*parents), &edge->vertex->id, keyConvertFromInt)) {
-      progress_array[edge->vertex->id] = 1;
-      hashTableInsertNode( &(*parents), nodeHashTable_int(edge->vertex->id, parent_id, parent_id));
-      _DFS_visit_cycle_enumerate(graph, edge->vertex->id, parents, progress_array);
-      progress_array[edge->vertex->id] = 0;
-    }
-    edge = edge->next;
-  }
+  if (_dfs_back_edge(dfs, from, to)) { *(int*)dfs->arg += 1; }
 }
 
 
-void graphCycleEnum(graph_t *graph)
+int graphExistsCycle(graph_t *graph)
 {
-  hashTable *parents = hashTableBuild();
-  int in_progress[graph->listSize];
-  for (size_t i = 0; i < graph->listSize; i++) { in_progress[i] = 0; }
-
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    if (!hashTableSearchNode(parents, &curr->id, keyConvertFromInt)) {
-      in_progress[curr->id] = 1;
-      hashTableInsertNode(&parents, nodeHashTable_int(curr->id, -1, -1));
-      _DFS_visit_cycle_enumerate(graph, curr->id, &parents, in_progress);
-      in_progress[curr->id] = 0;
-    }
-    curr = curr->next;
-  }
-  hashTableFree(parents);
+  int num_cycles = 0;
+  dfs_t dfs;
+  _dfs_init(&dfs, graph, graph->list);
+  dfs.edge = _dfs_edge_cycle_count;
+  dfs.arg  = &num_cycles;
+  _dfs_run(&dfs);
+  _dfs_destroy(&dfs);
+  return num_cycles;
 }
 
 
@@ -232,61 +296,54 @@ void graphCycleEnum(graph_t *graph)
 /*   Topological Sort   */
 /*                      */
 
+// vertex has finished being explored: add to head of list
 static
-void _DFS_visit_topological_sort(graph_t *graph, int parent_id, hashTable **parents, int *progress_array, graph_vertex **sorted_head)
+void _dfs_post_topological(dfs_t *dfs, graph_vertex *vertex)
 {
-  adjacencyListNode_t *edge = graph->list[parent_id];
-  while (edge) {
-    if (!hashTableSearchNode( (*parents), &edge->vertex->id, keyConvertFromInt)) {
-      progress_array[edge->vertex->id] = 1;
-      hashTableInsertNode( &(*parents), nodeHashTable_int(edge->vertex->id, parent_id, parent_id));
-      _DFS_visit_topological_sort(graph, edge->vertex->id, parents, progress_array, sorted_head);
-      progress_array[edge->vertex->id] = 0;
-
-      // vertex has finished being explored: add to head of list
-      if ( (*sorted_head) == NULL) {
-	*sorted_head = graphVertexNew(edge->vertex->id, edge->vertex->value);
-	(*sorted_head)->next = NULL;
-      } else {
-	graph_vertex *new = graphVertexNew(edge->vertex->id, edge->vertex->value);
-	new->next = *sorted_head;
-	*sorted_head = new;
-      }
-    }
-    edge = edge->next;
-  }
+  graph_vertex **sorted_head = (graph_vertex**)dfs->arg;
+  graph_vertex *new = graphVertexNew(vertex->id, vertex->value);
+  new->next = *sorted_head;
+  *sorted_head = new;
 }
 
 
 graph_vertex* topologicalSort(graph_t *graph)
 {
-  hashTable *parent = hashTableBuild();
-  int in_progress[graph->listSize];
-  for (size_t i = 0; i < graph->listSize; i++) { in_progress[i] = 0; }
   graph_vertex *sorted_head = NULL;
+  dfs_t dfs;
+  _dfs_init(&dfs, graph, graph->list);
+  dfs.post = _dfs_post_topological;
+  dfs.arg  = &sorted_head;
+  _dfs_run(&dfs);
+  _dfs_destroy(&dfs);
+  return sorted_head;
+}
 
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    if (!hashTableSearchNode(parent, &curr->id, keyConvertFromInt)) {
-      in_progress[curr->id] = 1;
-      hashTableInsertNode(&parent, nodeHashTable_int(curr->id, -1, -1));
-      _DFS_visit_topological_sort(graph, curr->id, &parent, in_progress, &sorted_head);
-      in_progress[curr->id] = 0;
-
-      // vertex has finished being explored: add to head of list
-      if (sorted_head == NULL) {
-	sorted_head = graphVertexNew(curr->id, curr->value);
-	sorted_head->next = NULL;
-      } else {
-	graph_vertex *new = graphVertexNew(curr->id, curr->value);
-	new->next = sorted_head;
-	sorted_head = new;
-      }
+
+unsigned int graphTopologicalOrder(graph_t *graph, uint32_t *order)
+{
+  unsigned int *degree = (unsigned int*)malloc(sizeof(unsigned int) * (graph->listSize ? graph->listSize : 1));
+  if (!degree) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  memcpy(degree, graph->degree_in, sizeof(unsigned int) * graph->listSize);
+
+  unsigned int tail = 0;
+  for (graph_vertex *vertex = graph->vertex_head; vertex; vertex = vertex->next) {
+    if (degree[vertex->id] == 0) order[tail++] = vertex->id;
+  }
+
+  // order[0..head) is output, order[head..tail) waits with in-degree 0
+  for (unsigned int head = 0; head < tail; head++) {
+    GRAPH_STAT_ADD(vertices_visited, 1);
+    for (adjacencyListNode_t *edge = graph->list[order[head]]; edge; edge = edge->next) {
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (--degree[edge->vertex->id] == 0) order[tail++] = edge->vertex->id;
     }
-    curr = curr->next;
   }
-  hashTableFree(parent);
-  return sorted_head;
+
+  free(degree);
+  return tail;
 }
 
 
@@ -294,68 +351,149 @@ graph_vertex* topologicalSort(graph_t *graph)
 /*   Strongly Connected Components     */
 /*                                     */
 
+typedef struct scc_finish_t {
+  unsigned int *by_finish;   // by_finish[t] is the id of the vertex that finished t-th
+  unsigned int  fin_pos;
+} scc_finish_t;
+
 static
-void _DFS_visit_components(graph_t *graph, int parent_id, hashTable **parents, int *progress_array, int *fin_pos, int print_to_STDOUT)
+void _dfs_post_finish(dfs_t *dfs, graph_vertex *vertex)
 {
-  adjacencyListNode_t *edge = graph->list[parent_id];
-  while (edge) {
-    if (!hashTableSearchNode( (*parents), &edge->vertex->id, keyConvertFromInt)) {
-      if (print_to_STDOUT) { printf(" %d", edge->vertex->id); }
-      hashTableInsertNode( &(*parents), nodeHashTable_int(edge->vertex->id, parent_id, parent_id));
-      _DFS_visit_components(graph, edge->vertex->id, parents, progress_array, fin_pos, print_to_STDOUT);
-      progress_array[edge->vertex->id] = *fin_pos; *fin_pos += 1;
-    }
-    edge = edge->next;
-  }
+  scc_finish_t *finish = (scc_finish_t*)dfs->arg;
+  finish->by_finish[finish->fin_pos++] = vertex->id;
+}
+
+static
+void _dfs_pre_component_print(dfs_t *dfs, graph_vertex *vertex)
+{
+  if (dfs->top) printf(" %d", vertex->id);   // roots are printed as the component's header
 }
 
 
 static
 hashTable* _DFS_SCC(graph_t *graph, int print_to_STDOUT)
 {
-  hashTable *parent = hashTableBuild();
-  int fin_positions[graph->listSize];
-  for (size_t i = 0; i < graph->listSize; i++) { fin_positions[i] = 0; }
-  int fin_pos = 1;
-
   // DFS of original input graph in order to find order of finishing times
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    if (!hashTableSearchNode(parent, &curr->id, keyConvertFromInt)) {
-      hashTableInsertNode(&parent, nodeHashTable_int(curr->id, -1, -1));
-      _DFS_visit_components(graph, curr->id, &parent, fin_positions, &fin_pos, 0);
-      fin_positions[curr->id] = fin_pos; fin_pos++;
+  scc_finish_t finish;
+  finish.by_finish = (unsigned int*)malloc(sizeof(unsigned int) * (graph->numVertex ? graph->numVertex : 1));
+  finish.fin_pos = 0;
+  if (!finish.by_finish) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  dfs_t dfs;
+  _dfs_init(&dfs, graph, graph->list);
+  dfs.post = _dfs_post_finish;
+  dfs.arg  = &finish;
+  _dfs_run(&dfs);
+  _dfs_destroy(&dfs);
+
+  // DFS of the transpose of input graph: the reverse lists are the transpose's lists
+  graph_t *transpose = graph->reverse ? NULL : graphBuildTranspose(graph);
+  graph_t *second    = transpose ? transpose : graph;
+  _dfs_init(&dfs, second, transpose ? transpose->list : graph->reverse);
+  if (print_to_STDOUT) dfs.pre = _dfs_pre_component_print;
+
+  // run DFS from each vertex not yet in a component, latest finish time first
+  for (size_t t = finish.fin_pos; t-- > 0; ) {
+    graph_vertex *vertex = second->vertex_index[finish.by_finish[t]];
+    if (dfs.state[vertex->id] == DFS_NEW) {
+      if (print_to_STDOUT) { printf("\nStrongly Connected Component: %d", vertex->id); }
+      _dfs_visit(&dfs, vertex);
     }
+  }
+
+  hashTable *parent = hashTableBuild();
+  graph_vertex *curr = second->vertex_head;
+  while (curr) {
+    int parent_id = dfs.parent[curr->id];
+    hashTableInsertNode(&parent, nodeHashTable_int(curr->id, parent_id, parent_id));
     curr = curr->next;
   }
-  hashTableFree(parent);
-
-  // DFS of the transpose of input graph
-  graph_t *transpose = graphBuildTranspose(graph);
-  hashTable *parent2 = hashTableBuild();
-  int dummy_array[transpose->listSize];  // need this to avoid mutating the one from above
-  for (size_t i = 0; i < transpose->listSize; i++) { dummy_array[i] = 0; }
-  int remaining_vertices = transpose->numVertex;
-
-  while (remaining_vertices > 0) {
-
-    // loop over array containing knowledge of when vertices finished
-    for (size_t vertex = 0; vertex < transpose->listSize; vertex++) {
-
-      // identify vertex with the latest finish time and run DFS on it
-      if (fin_positions[vertex] == remaining_vertices) {
-	remaining_vertices--;
-	if (!hashTableSearchNode(parent2, &vertex, keyConvertFromInt)) {
-	  if (print_to_STDOUT) { printf("\nStrongly Connected Component: %ld", vertex); }
-	  hashTableInsertNode(&parent2, nodeHashTable_int(vertex, -1, -1));
-	  _DFS_visit_components(transpose, vertex, &parent2, dummy_array, &fin_pos, print_to_STDOUT);
-	  break;
-	}
-      }
-    }
+  _dfs_destroy(&dfs);
+  free(finish.by_finish);
+  if (transpose) graphFree(transpose);
+  return parent;
+}
+
+
+typedef struct scc_tarjan_t {
+  int          *index;       // discovery index of each vertex
+  int          *low;
+  int          *component;   // -1 while vertex waits on stack
+  unsigned int *stack;       // vertices waiting for their scc, in discovery order
+  size_t        top;
+  int           counter;
+  unsigned int  count;
+} scc_tarjan_t;
+
+static
+void _dfs_pre_tarjan(dfs_t *dfs, graph_vertex *vertex)
+{
+  scc_tarjan_t *tarjan = (scc_tarjan_t*)dfs->arg;
+  tarjan->index[vertex->id] = tarjan->low[vertex->id] = tarjan->counter++;
+  tarjan->stack[tarjan->top++] = vertex->id;
+}
+
+static
+void _dfs_edge_tarjan(dfs_t *dfs, graph_vertex *from, graph_vertex *to)
+{
+  scc_tarjan_t *tarjan = (scc_tarjan_t*)dfs->arg;
+  if (dfs->state[to->id] != DFS_NEW && tarjan->component[to->id] == -1 &&
+      tarjan->index[to->id] < tarjan->low[from->id]) {
+    tarjan->low[from->id] = tarjan->index[to->id];
   }
-  graphFree(transpose);
-  return parent2;
+}
+
+static
+void _dfs_post_tarjan(dfs_t *dfs, graph_vertex *vertex)
+{
+  scc_tarjan_t *tarjan = (scc_tarjan_t*)dfs->arg;
+  unsigned int id = vertex->id;
+  if (tarjan->low[id] == tarjan->index[id]) {       // vertex is the first of its scc
+    unsigned int member;
+    do {
+      member = tarjan->stack[--tarjan->top];
+      tarjan->component[member] = tarjan->count;
+    } while (member != id);
+    tarjan->count++;
+  } else {                                          // pass low on to parent
+    int parent = dfs->parent[id];
+    if (tarjan->low[id] < tarjan->low[parent]) tarjan->low[parent] = tarjan->low[id];
+  }
+}
+
+
+int* stronglyConnectedComponentsTarjan(graph_t *graph, unsigned int *count)
+{
+  size_t size     = graph->listSize  ? graph->listSize  : 1;
+  size_t capacity = graph->numVertex ? graph->numVertex : 1;
+  scc_tarjan_t tarjan;
+  tarjan.index     = (int*)malloc(sizeof(int) * size);
+  tarjan.low       = (int*)malloc(sizeof(int) * size);
+  tarjan.component = (int*)malloc(sizeof(int) * size);
+  tarjan.stack     = (unsigned int*)malloc(sizeof(unsigned int) * capacity);
+  if (!tarjan.index || !tarjan.low || !tarjan.component || !tarjan.stack) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < graph->listSize; i++) { tarjan.component[i] = -1; }
+  tarjan.top = 0;
+  tarjan.counter = 0;
+  tarjan.count = 0;
+
+  dfs_t dfs;
+  _dfs_init(&dfs, graph, graph->list);
+  dfs.pre  = _dfs_pre_tarjan;
+  dfs.edge = _dfs_edge_tarjan;
+  dfs.post = _dfs_post_tarjan;
+  dfs.arg  = &tarjan;
+  _dfs_run(&dfs);
+  _dfs_destroy(&dfs);
+
+  free(tarjan.index);
+  free(tarjan.low);
+  free(tarjan.stack);
+  *count = tarjan.count;
+  return tarjan.component;
 }
 
 
@@ -371,4 +509,3 @@ hashTable* stronglyConnectedComponents(graph_t *graph)
   hashTable *scc_forest = _DFS_SCC(graph, 0);
   return scc_forest;
 }
-
@@ -0,0 +1,213 @@
+/*
+  Dynamic Single-Source Shortest Paths
+  When the edges of a graph change one at a time, most shortest paths from a source survive
+  each change, and running Dijkstra's algorithm from scratch after every one redoes all of
+  them. graph_dynamic_sssp_t keeps the distances and the shortest path tree of one source,
+  and repairs only what a change touches:
+
+  Insertions and weight decreases can only make distances shorter. If the edge (u,v) now
+  gives v a shorter distance, v's distance is lowered and Dijkstra's algorithm is run from v
+  alone: it goes on only through the vertices whose distances it lowers, so the work is
+  proportional to the vertices that gain a shorter path, and their edges (Ramalingam and
+  Reps, 1996). If (u,v) gives v no shorter path, nothing is done at all.
+
+  Deletions and weight increases can only make distances longer, and only for the vertices
+  whose shortest path took the edge: if (u,v) was the tree edge into v, the subtree of v in
+  the shortest path tree. That subtree is found by following the out-edges of its vertices
+  to those whose predecessor they are; its distances are forgotten, and each of its vertices
+  is offered the best distance through its in-edges from outside the subtree - these are
+  unchanged, and are read from the reverse adjacency list. A Dijkstra search restricted to
+  the subtree, seeded with these offers, then settles the subtree again. The work is
+  proportional to the subtree and the edges into and out of it, instead of the whole graph.
+  If (u,v) was not v's tree edge, no distance changes and nothing is done.
+
+  Weights must not be negative, as for Dijkstra's algorithm.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "../../Headers/graph.h"
+#include "../../Headers/indexedHeap.h"
+
+
+static
+void _dynamic_check_weight(int weight)
+{
+  if (weight < 0) {
+    fprintf(stderr, "Dynamic shortest paths require non-negative weights\n");  exit(EXIT_FAILURE);
+  }
+}
+
+// Dijkstra from the vertices in the heap; a vertex only enters it with a lowered distance
+static
+void _dynamic_settle(graph_dynamic_sssp_t *sssp)
+{
+  graph_dense_t *paths = sssp->paths;
+  indexedHeap *heap = sssp->heap;
+
+  while (!indexedHeapIsEmpty(heap)) {
+    unsigned int vertex = indexedHeapExtractMin(heap).id;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+
+    for (adjacencyListNode_t *edge = sssp->graph->list[vertex]; edge; edge = edge->next) {
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (paths->dist[next] > paths->dist[vertex] + edge->weight) {
+	paths->dist[next] = paths->dist[vertex] + edge->weight;
+	GRAPH_STAT_ADD(relaxations, 1);
+	paths->pred[next] = vertex;
+	graphDenseMarkVisited(paths, next);
+	indexedHeapPush(heap, next, paths->dist[next]);
+      }
+    }
+  }
+}
+
+// edge from -> to is new, or lighter, with the given weight
+static
+void _dynamic_decrease(graph_dynamic_sssp_t *sssp, unsigned int from, unsigned int to, int weight)
+{
+  graph_dense_t *paths = sssp->paths;
+  if (paths->dist[from] == INT_MAX || paths->dist[to] <= paths->dist[from] + weight) return;
+
+  paths->dist[to] = paths->dist[from] + weight;
+  GRAPH_STAT_ADD(relaxations, 1);
+  paths->pred[to] = from;
+  graphDenseMarkVisited(paths, to);
+  indexedHeapPush(sssp->heap, to, paths->dist[to]);
+  _dynamic_settle(sssp);
+}
+
+// edge from -> to, of the given weight, is gone or heavier
+static
+void _dynamic_increase(graph_dynamic_sssp_t *sssp, unsigned int from, unsigned int to, int weight)
+{
+  graph_dense_t *paths = sssp->paths;
+  if (paths->pred[to] != (int)from || paths->dist[to] != paths->dist[from] + weight) return;
+
+  // the subtree of to, in the shortest path tree
+  unsigned int size = 0;
+  sssp->subtree[size++] = to;
+  sssp->in_subtree[to] = true;
+  for (unsigned int i = 0; i < size; i++) {
+    unsigned int vertex = sssp->subtree[i];
+    for (adjacencyListNode_t *edge = sssp->graph->list[vertex]; edge; edge = edge->next) {
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (paths->pred[next] == (int)vertex && !sssp->in_subtree[next]) {
+	sssp->in_subtree[next] = true;
+	sssp->subtree[size++] = next;
+      }
+    }
+  }
+  for (unsigned int i = 0; i < size; i++) {
+    unsigned int vertex = sssp->subtree[i];
+    paths->dist[vertex] = INT_MAX;
+    paths->pred[vertex] = -1;
+    paths->visited[vertex >> 6] &= ~(UINT64_C(1) << (vertex & 63));
+  }
+
+  // best offer from outside the subtree, whose distances stand
+  for (unsigned int i = 0; i < size; i++) {
+    unsigned int vertex = sssp->subtree[i];
+    for (adjacencyListNode_t *back = sssp->graph->reverse[vertex]; back; back = back->next) {
+      unsigned int prev = back->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (sssp->in_subtree[prev] || paths->dist[prev] == INT_MAX) continue;
+      if (paths->dist[vertex] > paths->dist[prev] + back->weight) {
+	paths->dist[vertex] = paths->dist[prev] + back->weight;
+	paths->pred[vertex] = prev;
+      }
+    }
+    if (paths->dist[vertex] != INT_MAX) {
+      graphDenseMarkVisited(paths, vertex);
+      indexedHeapPush(sssp->heap, vertex, paths->dist[vertex]);
+    }
+  }
+  for (unsigned int i = 0; i < size; i++) { sssp->in_subtree[sssp->subtree[i]] = false; }
+
+  _dynamic_settle(sssp);
+}
+
+
+graph_dynamic_sssp_t* graphDynamicSSSPBuild(graph_t *graph, graph_vertex *source)
+{
+  for (unsigned int id = 0; id < graph->listSize; id++) {
+    for (adjacencyListNode_t *edge = graph->list[id]; edge; edge = edge->next) {
+      _dynamic_check_weight(edge->weight);
+    }
+  }
+  graphEnableReverse(graph);
+
+  graph_dynamic_sssp_t *sssp = (graph_dynamic_sssp_t*)malloc(sizeof(graph_dynamic_sssp_t));
+  if (!sssp) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  sssp->graph  = graph;
+  sssp->source = source->id;
+  sssp->paths  = dijkstraDense(graph, source);
+  sssp->heap   = indexedHeapBuild(graph->listSize);
+  sssp->subtree    = (unsigned int*)malloc(sizeof(unsigned int) * (graph->listSize ? graph->listSize : 1));
+  sssp->in_subtree = (bool*)calloc(graph->listSize ? graph->listSize : 1, sizeof(bool));
+  if (!sssp->subtree || !sssp->in_subtree) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return sssp;
+}
+
+
+void graphDynamicSSSPFree(graph_dynamic_sssp_t *sssp)
+{
+  graphDenseFree(sssp->paths);
+  indexedHeapFree(sssp->heap);
+  free(sssp->subtree);
+  free(sssp->in_subtree);
+  free(sssp);
+}
+
+
+void graphDynamicSSSPAddEdge(graph_dynamic_sssp_t *sssp, graph_vertex *one, graph_vertex *two, int weight)
+{
+  _dynamic_check_weight(weight);
+  if (!sssp->graph->multiGraph && graphExistsEdge(sssp->graph, one, two)) return;
+  graphAddEdgeWeightD(sssp->graph, one, two, weight);
+  _dynamic_decrease(sssp, one->id, two->id, weight);
+}
+
+
+void graphDynamicSSSPRemoveEdge(graph_dynamic_sssp_t *sssp, graph_vertex *one, graph_vertex *two, int weight)
+{
+  // the weight of the edge graphRemoveEdgeWeightD will remove
+  graph_t *graph = sssp->graph;
+  adjacencyListNode_t *edge = graph->list[one->id];
+  while (edge && !(edge->vertex == two && (!graph->multiGraph || edge->weight == weight))) {
+    edge = edge->next;
+  }
+  if (!edge) return;
+  weight = edge->weight;
+
+  graphRemoveEdgeWeightD(graph, one, two, weight);
+  _dynamic_increase(sssp, one->id, two->id, weight);
+}
+
+
+void graphDynamicSSSPSetWeight(graph_dynamic_sssp_t *sssp, graph_vertex *one, graph_vertex *two,
+			       int weight, int new_weight)
+{
+  _dynamic_check_weight(new_weight);
+  graph_t *graph = sssp->graph;
+  adjacencyListNode_t *edge = graph->list[one->id];
+  while (edge && !(edge->vertex == two && (!graph->multiGraph || edge->weight == weight))) {
+    edge = edge->next;
+  }
+  if (!edge) return;
+  weight = edge->weight;
+
+  graphSetEdgeWeightD(graph, one, two, weight, new_weight);
+  if (new_weight < weight) _dynamic_decrease(sssp, one->id, two->id, new_weight);
+  else if (new_weight > weight) _dynamic_increase(sssp, one->id, two->id, weight);
+}
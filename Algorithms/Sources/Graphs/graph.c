@@ -94,6 +94,52 @@
   Additionaly: my vertex struct still contains a next pointer, and this is used to build a linked list of all vertices
   that are in the graph, the head of which is kept in the graph struct. This allows me to quickly loop over all vertices
   in the graph, useful for, among other things, freeing the memory allocated to the graph.
+  The list is doubly linked (the prev pointer), so a vertex can be unlinked without searching for it.
+  Next to the adjacency list the graph keeps an index from id to vertex, vertex_index[id], which grows
+  along with it. Checking that an id is free, that a vertex is a member, and finding the vertex with
+  a given id are then a single array access each, where they used to walk the whole list of vertices.
+
+  Degrees and reverse adjacency:
+  The graph counts, for every vertex, the nodes in its list (out degree) and the nodes in all lists
+  that lead to it (in degree), updating both whenever an edge comes or goes. Degree queries are then
+  O(1), where the in degree used to require a pass over the entire graph. Removing a vertex from a
+  directed graph has the same problem: its in-edges may be in any list. A graph may therefore also
+  keep a reverse adjacency list (graphEnableReverse), holding for every edge u -> v a node for u in
+  the list of v. Removal then reads the in-edges of the vertex straight from its reverse list and
+  only walks the lists of its neighbors. This costs a second node per edge, so it is opt in.
+
+  Memory pools (arenas):
+  Every edge added costs at least one malloc, and every edge removed a free. For large graphs
+  most of the build time is spent inside malloc, and as the nodes end up wherever malloc finds
+  room, walking an adjacency list jumps all over memory. A graph built with graphBuildWithArena
+  instead carves its nodes from large chunks of memory, obtained with one malloc each. Nodes
+  added one after the other sit next to each other. Nodes of removed edges go on a free list
+  and are handed out again before the chunk is touched. Vertices come from the chunks too
+  (graphArenaVertexNew); graphAddVertex notes the ids of those that do not (a binary search of
+  the chunks by address, once per vertex added), and graphFree frees only these, then releases
+  the chunks without looking at nodes one by one. Chunks double in size as the graph grows (up to a limit), so
+  building a graph of E edges costs O(lg E) calls to malloc.
+
+  Bulk loading:
+  Unless the graph is a MultiGraph, adding an edge first walks the source's list to make sure
+  the edge is not there yet, so loading a vertex of degree d costs O(d^2). graphBuildFromEdgeList
+  takes all edges at once and builds the lists the way a CSR is built: count every vertex's
+  degree, hand each vertex its range of one array sized for all edges, and drop each edge into
+  its range. Duplicates are then next to each other once a range is sorted, and a single pass
+  keeps the first of each. Finally the nodes of all lists are carved from one block of the arena.
+
+  Bit matrix:
+  Dense graphs get the worst of adjacency lists: checking for an edge walks a list that holds a
+  large part of all vertices, and so does every edge added to a graph that is not a MultiGraph.
+  A graph built with graphBuildWithMatrix (or given one later, graphEnableMatrix) also keeps the
+  adjacency matrix described above, one bit per pair: row i holds a bit for every id j such that
+  an edge i -> j exists. graphExistsEdge, and with it the duplicate check of adding an edge, is
+  then a single bit test. Breadth-first search reads whole words of a row at a time: the
+  neighbors of a vertex that are not yet visited are row AND NOT visited, 64 vertices per word,
+  in branch free loops the compiler turns into vector instructions. The lists stay the primary
+  storage (they hold the weights and parallel edges, and every other algorithm walks them); the
+  matrix is kept up to date alongside, at a cost of listSize^2 / 8 bytes, so it is only worth it
+  once the lists take more memory than that, from around a tenth of all pairs.
 */
 
 
@@ -105,12 +151,209 @@
 #include "../../Headers/graph.h"
 
 
+/*                                  */
+/*       Memory pool (arena)        */
+/*                                  */
+
+#define ARENA_FIRST_CHUNK (64 * 1024)
+#define ARENA_MAX_CHUNK   (16 * 1024 * 1024)
+
+static
+graph_arena_t* _arena_init(void)
+{
+  graph_arena_t *arena = (graph_arena_t*)malloc(sizeof(*arena));
+  if (!arena) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  arena->chunks = NULL;
+  arena->free_edges = NULL;
+  arena->sorted = NULL;
+  arena->num_chunks = 0;
+  arena->heap_ids = NULL;
+  arena->heap_words = 0;
+  return arena;
+}
+
+// hands out size bytes (8 byte aligned) from the current chunk, starting a new one if needed
+static
+void* _arena_alloc(graph_arena_t *arena, size_t size)
+{
+  size = (size + 7) & ~(size_t)7;
+  graph_arena_chunk_t *chunk = arena->chunks;
+  if (!chunk || chunk->size - chunk->used < size) {
+    size_t chunk_size = chunk ? chunk->size * 2 : ARENA_FIRST_CHUNK;
+    if (chunk_size > ARENA_MAX_CHUNK) chunk_size = ARENA_MAX_CHUNK;
+    if (chunk_size < size)            chunk_size = size;
+
+    chunk = (graph_arena_chunk_t*)malloc(sizeof(*chunk) + chunk_size);
+    GRAPH_STAT_ADD(allocations, 1);
+    if (!chunk) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+
+    // kept in address order as well: chunks are few, an insertion is cheap
+    graph_arena_chunk_t **sorted = (graph_arena_chunk_t**)
+      realloc(arena->sorted, sizeof(graph_arena_chunk_t*) * (arena->num_chunks + 1));
+    if (!sorted) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+    size_t at = arena->num_chunks++;
+    while (at > 0 && (char*)sorted[at - 1] > (char*)chunk) { sorted[at] = sorted[at - 1];  at--; }
+    sorted[at] = chunk;
+    arena->sorted = sorted;
+  }
+  void *memory = (char*)chunk->data + chunk->used;
+  chunk->used += size;
+  return memory;
+}
+
+// whether memory was handed out by the arena: binary search of the chunks by address
+static
+bool _arena_owns(graph_arena_t *arena, void *memory)
+{
+  size_t low = 0, high = arena->num_chunks;
+  while (low < high) {                // first chunk that starts after memory
+    size_t mid = (low + high) / 2;
+    if ((char*)arena->sorted[mid]->data <= (char*)memory) low = mid + 1;
+    else                                                   high = mid;
+  }
+  if (low == 0) return false;
+  graph_arena_chunk_t *chunk = arena->sorted[low - 1];
+  return (char*)memory < (char*)chunk->data + chunk->size;
+}
+
+// records whether the member vertex with this id came from malloc, for graphFree
+static
+void _arena_mark_heap(graph_arena_t *arena, unsigned int id, bool heap)
+{
+  size_t word = id / 64;
+  if (word >= arena->heap_words) {
+    if (!heap) return;
+    size_t words = arena->heap_words ? arena->heap_words : 1;
+    while (words <= word) words *= 2;
+    uint64_t *ids = (uint64_t*)realloc(arena->heap_ids, sizeof(uint64_t) * words);
+    if (!ids) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+    memset(ids + arena->heap_words, 0, sizeof(uint64_t) * (words - arena->heap_words));
+    arena->heap_ids = ids;
+    arena->heap_words = words;
+  }
+  if (heap) arena->heap_ids[word] |=   UINT64_C(1) << (id % 64);
+  else      arena->heap_ids[word] &= ~(UINT64_C(1) << (id % 64));
+}
+
+static
+bool _arena_is_heap(graph_arena_t *arena, unsigned int id)
+{
+  return id / 64 < arena->heap_words && (arena->heap_ids[id / 64] >> (id % 64)) & 1;
+}
+
+static
+void _arena_free(graph_arena_t *arena)
+{
+  graph_arena_chunk_t *chunk = arena->chunks;
+  while (chunk) {
+    graph_arena_chunk_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(arena->sorted);
+  free(arena->heap_ids);
+  free(arena);
+}
+
+// every adjacency list node of the graph is allocated and freed through these two
+static
+adjacencyListNode_t* _edge_new(graph_t *graph)
+{
+  adjacencyListNode_t *edge;
+  if (!graph->arena) {
+    edge = (adjacencyListNode_t*)malloc(sizeof(*edge));
+    GRAPH_STAT_ADD(allocations, 1);
+    if (!edge) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+  } else if (graph->arena->free_edges) {
+    edge = graph->arena->free_edges;
+    graph->arena->free_edges = edge->next;
+  } else {
+    edge = (adjacencyListNode_t*)_arena_alloc(graph->arena, sizeof(*edge));
+  }
+  return edge;
+}
+
+static
+void _edge_free(graph_t *graph, adjacencyListNode_t *edge)
+{
+  if (!graph->arena) {
+    free(edge);
+  } else {
+    edge->next = graph->arena->free_edges;
+    graph->arena->free_edges = edge;
+  }
+}
+
+
+/*                                  */
+/*       Bit matrix                 */
+/*                                  */
+
+// words in a row of the matrix of a graph whose list has list_size entries
+static inline
+size_t _matrix_words(size_t list_size)
+{
+  return (list_size + 63) / 64;
+}
+
+static
+uint64_t* _matrix_alloc(size_t list_size)
+{
+  uint64_t *matrix = (uint64_t*)calloc(list_size * _matrix_words(list_size), sizeof(uint64_t));
+  if (!matrix) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return matrix;
+}
+
+static inline
+void _matrix_set(graph_t *graph, unsigned int src_id, unsigned int dst_id)
+{
+  graph->matrix[src_id * graph->matrix_words + (dst_id >> 6)] |= UINT64_C(1) << (dst_id & 63);
+}
+
+static inline
+void _matrix_clear(graph_t *graph, unsigned int src_id, unsigned int dst_id)
+{
+  graph->matrix[src_id * graph->matrix_words + (dst_id >> 6)] &= ~(UINT64_C(1) << (dst_id & 63));
+}
+
+static inline
+bool _matrix_test(graph_t *graph, unsigned int src_id, unsigned int dst_id)
+{
+  return (graph->matrix[src_id * graph->matrix_words + (dst_id >> 6)] >> (dst_id & 63)) & 1;
+}
+
+
+/*                                  */
+/*       Graph                      */
+/*                                  */
+
 static
 graph_t* _graph_init(size_t arr_size, size_t num_vertex, graph_vertex *vertex_head,
-		     bool multiGraph, bool pseudoGraph, bool weighted)
+		     bool multiGraph, bool pseudoGraph, bool weighted, graph_arena_t *arena)
 {
   graph_t *new = (graph_t*)malloc(sizeof(*new) + sizeof(adjacencyListNode_t*) * arr_size);
-  if (!new) {
+  if (new) {
+    new->vertex_index = (graph_vertex**)calloc(arr_size, sizeof(graph_vertex*));
+    new->degree_out   = (unsigned int*)calloc(arr_size, sizeof(unsigned int));
+    new->degree_in    = (unsigned int*)calloc(arr_size, sizeof(unsigned int));
+  }
+  if (!new || !new->vertex_index || !new->degree_out || !new->degree_in) {
     perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
   }
   new->numVertex   = num_vertex;
@@ -119,6 +362,10 @@ graph_t* _graph_init(size_t arr_size, size_t num_vertex, graph_vertex *vertex_he
   new->pseudoGraph = pseudoGraph;
   new->weighted    = weighted;
   new->vertex_head = vertex_head;
+  new->arena       = arena;
+  new->reverse     = NULL;
+  new->matrix      = NULL;
+  new->matrix_words = 0;
   memset(new->list, 0, sizeof(adjacencyListNode_t*) * arr_size);
 
   return new;
@@ -130,71 +377,322 @@ graph_t* graphBuild(bool multiGraph, bool pseudoGraph)
   if (!multiGraph && pseudoGraph) {
     fprintf(stderr, "PseudoGraphs must be MultiGraphs\n");  exit(EXIT_FAILURE);
   }
-  return _graph_init(8, 0, NULL, multiGraph, pseudoGraph, false);
+  return _graph_init(8, 0, NULL, multiGraph, pseudoGraph, false, NULL);
 }
 
 
-graph_t* graphBuildTranspose(graph_t *graph)
+graph_t* graphBuildWithArena(bool multiGraph, bool pseudoGraph)
 {
-  graph_t *transpose = graphBuild(graph->multiGraph, graph->pseudoGraph);
+  graph_t *graph = graphBuild(multiGraph, pseudoGraph);
+  graph->arena = _arena_init();
+  return graph;
+}
 
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    graphAddVertex(&transpose, graphVertexNew(curr->id, curr->value));
-    curr = curr->next;
+
+graph_t* graphBuildWithMatrix(bool multiGraph, bool pseudoGraph)
+{
+  graph_t *graph = graphBuild(multiGraph, pseudoGraph);
+  graphEnableMatrix(graph);
+  return graph;
+}
+
+
+graph_vertex* graphArenaVertexNew(graph_t *graph, int id, int value)
+{
+  if (!graph->arena) return graphVertexNew(id, value);
+
+  graph_vertex *new = (graph_vertex*)_arena_alloc(graph->arena, sizeof(*new));
+  new->id = id;
+  new->value = value;
+  new->next = NULL;
+  new->prev = NULL;
+  return new;
+}
+
+
+// orders the edges of one range by destination, ties by position in input
+static
+int _edge_key_cmp(const void *one, const void *two)
+{
+  uint64_t a = *(const uint64_t*)one;
+  uint64_t b = *(const uint64_t*)two;
+  return (a > b) - (a < b);
+}
+
+
+graph_t* graphBuildFromEdgeList(const uint32_t *src, const uint32_t *dst, const int *weights,
+				size_t m, unsigned int flags)
+{
+  bool pseudoGraph = flags & GRAPH_EDGES_PSEUDOGRAPH;
+  bool multiGraph  = (flags & GRAPH_EDGES_MULTIGRAPH) || pseudoGraph;
+  bool undirected  = flags & GRAPH_EDGES_UNDIRECTED;
+
+  size_t num_ids = 0;
+  for (size_t i = 0; i < m; i++) {
+    if (src[i] == dst[i] && !pseudoGraph) {
+      fprintf(stderr, "Only PseudoGraphs may have self-referencing or circular edges\n");
+      exit(EXIT_FAILURE); }
+    if (src[i] >= num_ids) num_ids = (size_t)src[i] + 1;
+    if (dst[i] >= num_ids) num_ids = (size_t)dst[i] + 1;
+  }
+  size_t list_size = 8;
+  while (list_size < num_ids) list_size *= 2;
+
+  // pass one: count degrees, turn them into the start of each vertex's range
+  size_t slots = undirected ? 2 * m : m;
+  size_t   *start = (size_t*)calloc(list_size + 1, sizeof(size_t));
+  uint64_t *keys  = (uint64_t*)malloc(sizeof(uint64_t) * (slots ? slots : 1));
+  int      *fill_weights = (int*)malloc(sizeof(int) * (slots ? slots : 1));
+  bool     *member = (bool*)calloc(list_size, sizeof(bool));
+  if (!start || !keys || !fill_weights || !member) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < m; i++) {
+    start[src[i] + 1]++;
+    if (undirected) start[dst[i] + 1]++;
+    member[src[i]] = member[dst[i]] = true;
   }
+  for (size_t v = 0; v < list_size; v++) { start[v + 1] += start[v]; }
 
-  // add to new graph the transpose of each edge in adjacency list
-  for (size_t i = 0; i < graph->listSize; i++) {
-    adjacencyListNode_t *edge = graph->list[i];
-    graph_vertex *edge_src = NULL;
-    graph_vertex *edge_dst = NULL;
-    while (edge) {
-
-      // retrieve the source/dest vertix instances from graph's linked list
-      int updated = 0;
-      curr = transpose->vertex_head;
-      while (curr) {
-	if (curr->id == i)                { edge_src = curr; updated++; }
-	if (curr->id == edge->vertex->id) { edge_dst = curr; updated++; }
-	if (updated == 2) break;
-	curr = curr->next;
-      }
-      graphAddEdgeD(transpose, edge_dst, edge_src);
-      edge = edge->next;
+  // pass two: drop each edge into its range; key is destination, then position in range
+  size_t *cursor = (size_t*)malloc(sizeof(size_t) * list_size);
+  if (!cursor) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  memcpy(cursor, start, sizeof(size_t) * list_size);
+  for (size_t i = 0; i < m; i++) {
+    int weight = weights ? weights[i] : 0;
+    size_t pos = cursor[src[i]]++;
+    keys[pos] = (uint64_t)dst[i] << 32 | (pos - start[src[i]]);
+    fill_weights[pos] = weight;
+    if (undirected) {
+      pos = cursor[dst[i]]++;
+      keys[pos] = (uint64_t)src[i] << 32 | (pos - start[dst[i]]);
+      fill_weights[pos] = weight;
     }
   }
-  return transpose;
+
+  // sort each range, then squeeze out parallel edges (keeping the first) unless MultiGraph;
+  // the edges kept for v are the first cursor[v] keys of its range
+  size_t num_edges = 0;
+  for (size_t v = 0; v < list_size; v++) {
+    size_t begin = start[v], end = start[v + 1];
+    qsort(keys + begin, end - begin, sizeof(uint64_t), _edge_key_cmp);
+    size_t out = begin;
+    for (size_t k = begin; k < end; k++) {
+      if (!multiGraph && out > begin && keys[out - 1] >> 32 == keys[k] >> 32) continue;
+      keys[out++] = keys[k];
+    }
+    cursor[v] = out - begin;
+    num_edges += out - begin;
+  }
+
+  // vertices and nodes all come from the arena, the nodes as one block
+  graph_t *graph = _graph_init(list_size, 0, NULL, multiGraph, pseudoGraph, weights != NULL, _arena_init());
+  for (size_t v = list_size; v-- > 0; ) {
+    if (member[v]) graphAddVertex(&graph, graphArenaVertexNew(graph, v, 0));
+  }
+  adjacencyListNode_t *nodes = (adjacencyListNode_t*)
+    _arena_alloc(graph->arena, sizeof(adjacencyListNode_t) * (num_edges ? num_edges : 1));
+
+  // link each vertex's nodes in order, consecutive in memory
+  adjacencyListNode_t *node = nodes;
+  for (size_t v = 0; v < list_size; v++) {
+    if (!cursor[v]) continue;
+    graph->list[v] = node;
+    for (size_t k = start[v]; k < start[v] + cursor[v]; k++) {
+      node->vertex = graph->vertex_index[keys[k] >> 32];
+      node->weight = fill_weights[start[v] + (keys[k] & 0xffffffff)];
+      node->next   = k + 1 < start[v] + cursor[v] ? node + 1 : NULL;
+      graph->degree_in[node->vertex->id]++;
+      node++;
+    }
+    graph->degree_out[v] = cursor[v];
+  }
+  free(start);  free(cursor);  free(keys);  free(fill_weights);  free(member);
+  return graph;
 }
 
 
 int graphAddVertex(graph_t **graph, graph_vertex *vertex)
 {
-  graph_vertex *curr = (*graph)->vertex_head;  // exit with error if duplicate id
-  while (curr) {
-    if (curr->id == vertex->id) return 1;
-    curr = curr->next;
+  // exit with error if duplicate id
+  if (vertex->id < (*graph)->listSize && (*graph)->vertex_index[vertex->id]) return 1;
+
+  // Table-Doubling on adjacency list, straight to the size that fits id
+  if ((*graph)->listSize <= vertex->id) {
+    size_t size = (*graph)->listSize;
+    while (size <= vertex->id) size *= 2;
+
+    graph_t *old = *graph;
+    graph_t *new_graph = _graph_init(size, old->numVertex, old->vertex_head,
+				     old->multiGraph, old->pseudoGraph, old->weighted, old->arena);
+    memcpy(new_graph->list, old->list, old->listSize * sizeof(adjacencyListNode_t*));
+    memcpy(new_graph->vertex_index, old->vertex_index, old->listSize * sizeof(graph_vertex*));
+    memcpy(new_graph->degree_out, old->degree_out, old->listSize * sizeof(unsigned int));
+    memcpy(new_graph->degree_in,  old->degree_in,  old->listSize * sizeof(unsigned int));
+    if (old->reverse) {
+      new_graph->reverse = (adjacencyListNode_t**)calloc(size, sizeof(adjacencyListNode_t*));
+      if (!new_graph->reverse) {
+	perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+      }
+      memcpy(new_graph->reverse, old->reverse, old->listSize * sizeof(adjacencyListNode_t*));
+    }
+    if (old->matrix) {                          // rows get longer: copied one at a time
+      new_graph->matrix = _matrix_alloc(size);
+      new_graph->matrix_words = _matrix_words(size);
+      for (size_t i = 0; i < old->listSize; i++) {
+	memcpy(new_graph->matrix + i * new_graph->matrix_words, old->matrix + i * old->matrix_words,
+	       old->matrix_words * sizeof(uint64_t));
+      }
+    }
+    free(old->vertex_index);
+    free(old->degree_out);
+    free(old->degree_in);
+    free(old->reverse);
+    free(old->matrix);
+    free(old);
+    *graph = new_graph;
   }
-  vertex->next = (*graph)->vertex_head;        // insert node at head of list
+
+  // a vertex of an arena graph that is not in the arena is freed on its own by graphFree
+  if ((*graph)->arena) _arena_mark_heap((*graph)->arena, vertex->id, !_arena_owns((*graph)->arena, vertex));
+
+  vertex->prev = NULL;                          // insert node at head of list
+  vertex->next = (*graph)->vertex_head;
+  if (vertex->next) vertex->next->prev = vertex;
   (*graph)->vertex_head = vertex;
+  (*graph)->vertex_index[vertex->id] = vertex;
   (*graph)->numVertex++;
+  return 0;
+}
 
-  // Table-Doubling on adjacency list
 
-  unsigned int numVertex   = (*graph)->numVertex;
-  graph_vertex *Ve_head    = (*graph)->vertex_head;
-  bool         multiGraph  = (*graph)->multiGraph;
-  bool         pseudoGraph = (*graph)->pseudoGraph;
-  bool         weighted    = (*graph)->weighted;
+// unlinks a member vertex from the graph's list of vertices and index
+static
+void _vertex_unlink(graph_t *graph, graph_vertex *vertex)
+{
+  if (vertex->prev) { vertex->prev->next = vertex->next; }
+  else              { graph->vertex_head = vertex->next; }
+  if (vertex->next) { vertex->next->prev = vertex->prev; }
+  vertex->next = vertex->prev = NULL;
+  graph->vertex_index[vertex->id] = NULL;
+  graph->numVertex--;
+  if (graph->arena) _arena_mark_heap(graph->arena, vertex->id, false);  // the caller's again
+}
 
-  while ((*graph)->listSize <= vertex->id) {
-    graph_t *new_graph = _graph_init( (*graph)->listSize * 2, numVertex, Ve_head, multiGraph, pseudoGraph, weighted);
-    memcpy(new_graph->list, (*graph)->list, (*graph)->listSize * sizeof(adjacencyListNode_t*));
-    graph_t *old = *graph;
-    *graph = new_graph;
-    free(old);
+
+// adds the edge src -> dst at the head of src's list, keeping degrees and reverse list
+static
+void _edge_link(graph_t *graph, graph_vertex *src, graph_vertex *dst, int weight)
+{
+  adjacencyListNode_t *edge = _edge_new(graph);
+  edge->vertex = dst;
+  edge->weight = weight;
+  edge->next = graph->list[src->id];
+  graph->list[src->id] = edge;
+  graph->degree_out[src->id]++;
+  graph->degree_in[dst->id]++;
+  if (graph->matrix) _matrix_set(graph, src->id, dst->id);
+
+  if (graph->reverse) {
+    adjacencyListNode_t *back = _edge_new(graph);
+    back->vertex = src;
+    back->weight = weight;
+    back->next = graph->reverse[dst->id];
+    graph->reverse[dst->id] = back;
+  }
+}
+
+
+// removes edge, which follows prev (NULL if it is the head) in the list of src_id
+static
+void _edge_unlink(graph_t *graph, unsigned int src_id, adjacencyListNode_t *prev, adjacencyListNode_t *edge)
+{
+  unsigned int dst_id = edge->vertex->id;
+  if (!prev) { graph->list[src_id] = edge->next; }
+  else       { prev->next = edge->next; }
+  graph->degree_out[src_id]--;
+  graph->degree_in[dst_id]--;
+
+  if (graph->reverse) {    // and one matching node from the reverse list of dst
+    adjacencyListNode_t *back_prev = NULL;
+    adjacencyListNode_t *back = graph->reverse[dst_id];
+    while (back->vertex->id != src_id || back->weight != edge->weight) {
+      back_prev = back;
+      back = back->next;
+    }
+    if (!back_prev) { graph->reverse[dst_id] = back->next; }
+    else            { back_prev->next = back->next; }
+    _edge_free(graph, back);
+  }
+  _edge_free(graph, edge);
+
+  if (graph->matrix) {     // a MultiGraph may have another edge src -> dst left
+    bool parallel = false;
+    for (adjacencyListNode_t *curr = graph->list[src_id]; curr && graph->multiGraph; curr = curr->next) {
+      if (curr->vertex->id == dst_id) { parallel = true;  break; }
+    }
+    if (!parallel) _matrix_clear(graph, src_id, dst_id);
+  }
+}
+
+
+void graphEnableReverse(graph_t *graph)
+{
+  if (graph->reverse) return;
+  graph->reverse = (adjacencyListNode_t**)calloc(graph->listSize, sizeof(adjacencyListNode_t*));
+  if (!graph->reverse) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < graph->listSize; i++) {
+    for (adjacencyListNode_t *edge = graph->list[i]; edge; edge = edge->next) {
+      adjacencyListNode_t *back = _edge_new(graph);
+      back->vertex = graph->vertex_index[i];
+      back->weight = edge->weight;
+      back->next = graph->reverse[edge->vertex->id];
+      graph->reverse[edge->vertex->id] = back;
+    }
+  }
+}
+
+
+void graphEnableMatrix(graph_t *graph)
+{
+  if (graph->matrix) return;
+  graph->matrix = _matrix_alloc(graph->listSize);
+  graph->matrix_words = _matrix_words(graph->listSize);
+  for (size_t i = 0; i < graph->listSize; i++) {
+    for (adjacencyListNode_t *edge = graph->list[i]; edge; edge = edge->next) {
+      _matrix_set(graph, i, edge->vertex->id);
+    }
   }
-  return 0;
+}
+
+
+graph_t* graphBuildTranspose(graph_t *graph)
+{
+  graph_t *transpose = graph->arena ? graphBuildWithArena(graph->multiGraph, graph->pseudoGraph)
+                                    : graphBuild(graph->multiGraph, graph->pseudoGraph);
+
+  graph_vertex *curr = graph->vertex_head;
+  while (curr) {
+    graphAddVertex(&transpose, graphArenaVertexNew(transpose, curr->id, curr->value));
+    curr = curr->next;
+  }
+  if (graph->matrix) graphEnableMatrix(transpose);    // at its final size
+
+  // add to new graph the transpose of each edge in adjacency list. The edges of graph are
+  // already free of duplicates, so they are linked without graphAddEdge*'s search of the
+  // destination's list, which would make a vertex of in-degree d cost O(d^2)
+  for (size_t i = 0; i < graph->listSize; i++) {
+    graph_vertex *edge_dst = transpose->vertex_index[i];
+    for (adjacencyListNode_t *edge = graph->list[i]; edge; edge = edge->next) {
+      _edge_link(transpose, transpose->vertex_index[edge->vertex->id], edge_dst, edge->weight);
+    }
+  }
+  transpose->weighted = graph->weighted;
+  return transpose;
 }
 
 
@@ -211,21 +709,8 @@ void graphAddEdgeU(graph_t *graph, graph_vertex *one, graph_vertex *two)
     return; }
 
   // create adjacency list nodes for graph's adjacency list
-  adjacencyListNode_t *for_one = (adjacencyListNode_t*)malloc(sizeof(*for_one));
-  adjacencyListNode_t *for_two = (adjacencyListNode_t*)malloc(sizeof(*for_two));
-  if (!for_one || !for_two) {
-    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
-  }
-
-  for_one->vertex = one;
-  for_one->next = graph->list[two->id];
-  for_one->weight = 0;
-  graph->list[two->id] = for_one;
-
-  for_two->vertex = two;
-  for_two->next = graph->list[one->id];
-  for_two->weight = 0;
-  graph->list[one->id] = for_two;
+  _edge_link(graph, two, one, 0);
+  _edge_link(graph, one, two, 0);
 }
 
 
@@ -242,15 +727,7 @@ void graphAddEdgeD(graph_t *graph, graph_vertex *one, graph_vertex *two)
     return; }
 
   // create adjacency list node for graph's adjacency list
-  adjacencyListNode_t *edge = (adjacencyListNode_t*)malloc(sizeof(*edge));
-  if (!edge) {
-    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
-  }
-
-  edge->vertex = two;
-  edge->next = graph->list[one->id];
-  edge->weight = 0;
-  graph->list[one->id] = edge;
+  _edge_link(graph, one, two, 0);
 }
 
 
@@ -267,21 +744,8 @@ void graphAddEdgeWeightU(graph_t *graph, graph_vertex *one, graph_vertex *two, i
     return; }
 
   // create adjacency list nodes for graph's adjacency list
-  adjacencyListNode_t *for_one = (adjacencyListNode_t*)malloc(sizeof(*for_one));
-  adjacencyListNode_t *for_two = (adjacencyListNode_t*)malloc(sizeof(*for_two));
-  if (!for_one || !for_two) {
-    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
-  }
-
-  for_one->vertex = one;
-  for_one->next = graph->list[two->id];
-  for_one->weight = weight;
-  graph->list[two->id] = for_one;
-
-  for_two->vertex = two;
-  for_two->next = graph->list[one->id];
-  for_two->weight = weight;
-  graph->list[one->id] = for_two;
+  _edge_link(graph, two, one, weight);
+  _edge_link(graph, one, two, weight);
 
   graph->weighted = true;
 }
@@ -300,15 +764,7 @@ void graphAddEdgeWeightD(graph_t *graph, graph_vertex *one, graph_vertex *two, i
     return; }
 
   // create adjacency list node for graph's adjacency list
-  adjacencyListNode_t *edge = (adjacencyListNode_t*)malloc(sizeof(*edge));
-  if (!edge) {
-    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
-  }
-
-  edge->vertex = two;
-  edge->next = graph->list[one->id];
-  edge->weight = weight;
-  graph->list[one->id] = edge;
+  _edge_link(graph, one, two, weight);
 
   graph->weighted = true;
 }
@@ -320,9 +776,7 @@ void graphRemoveEdgeU(graph_t *graph, graph_vertex *one, graph_vertex *two)
   adjacencyListNode_t *curr = graph->list[one->id];
   while (curr != NULL) {
     if (curr->vertex == two) {
-      if (!prev) { graph->list[one->id] = curr->next; }
-      else       { prev->next = curr->next; }
-      free(curr);
+      _edge_unlink(graph, one->id, prev, curr);
       break;
     }
     prev = curr;
@@ -332,9 +786,7 @@ void graphRemoveEdgeU(graph_t *graph, graph_vertex *one, graph_vertex *two)
   curr = graph->list[two->id];
   while (curr != NULL) {
     if (curr->vertex == one) {
-      if (!prev) { graph->list[two->id] = curr->next; }
-      else       { prev->next = curr->next; }
-      free(curr);
+      _edge_unlink(graph, two->id, prev, curr);
       break;
     }
     prev = curr;
@@ -349,9 +801,7 @@ void graphRemoveEdgeD(graph_t *graph, graph_vertex *one, graph_vertex *two)
   adjacencyListNode_t *curr = graph->list[one->id];
   while (curr != NULL) {
     if (curr->vertex == two) {
-      if (!prev) { graph->list[one->id] = curr->next; }
-      else       { prev->next = curr->next; }
-      free(curr);
+      _edge_unlink(graph, one->id, prev, curr);
       break;
     }
     prev = curr;
@@ -366,9 +816,7 @@ void graphRemoveEdgeWeightU(graph_t *graph, graph_vertex *one, graph_vertex *two
   adjacencyListNode_t *curr = graph->list[one->id];
   while (curr != NULL) {
     if ( (curr->vertex == two && !graph->multiGraph) || (curr->vertex == two && curr->weight == weight)) {
-      if (!prev) { graph->list[one->id] = curr->next; }
-      else       { prev->next = curr->next; }
-      free(curr);
+      _edge_unlink(graph, one->id, prev, curr);
       break;
     }
     prev = curr;
@@ -378,9 +826,7 @@ void graphRemoveEdgeWeightU(graph_t *graph, graph_vertex *one, graph_vertex *two
   curr = graph->list[two->id];
   while (curr != NULL) {
     if ( (curr->vertex == one && !graph->multiGraph) || (curr->vertex == one && curr->weight == weight)) {
-      if (!prev) { graph->list[two->id] = curr->next; }
-      else       { prev->next = curr->next; }
-      free(curr);
+      _edge_unlink(graph, two->id, prev, curr);
       break;
     }
     prev = curr;
@@ -395,9 +841,7 @@ void graphRemoveEdgeWeightD(graph_t *graph, graph_vertex *one, graph_vertex *two
   adjacencyListNode_t *curr = graph->list[one->id];
   while (curr != NULL) {
     if ( (curr->vertex == two && !graph->multiGraph) || (curr->vertex == two && curr->weight == weight)) {
-      if (!prev) { graph->list[one->id] = curr->next; }
-      else       { prev->next = curr->next; }
-      free(curr);
+      _edge_unlink(graph, one->id, prev, curr);
       break;
     }
     prev = curr;
@@ -406,78 +850,76 @@ void graphRemoveEdgeWeightD(graph_t *graph, graph_vertex *one, graph_vertex *two
 }
 
 
-void graphRemoveVertexU(graph_t *graph, graph_vertex *vertex)
+bool graphSetEdgeWeightD(graph_t *graph, graph_vertex *one, graph_vertex *two, int weight, int new_weight)
 {
-  int found_vertex = 0;       // find and eliminate node from vertex list
-  graph_vertex *curr = graph->vertex_head;
-  graph_vertex *prev = NULL;
-  while (curr) {
-    if (curr == vertex) {
-      found_vertex = 1;
-      graph->numVertex--;
-
-      if (!prev) { graph->vertex_head = curr->next; }
-      else       { prev->next = curr->next; }
-      break;
-    }
-    prev = curr;
+  adjacencyListNode_t *curr = graph->list[one->id];
+  while (curr && !(curr->vertex == two && (!graph->multiGraph || curr->weight == weight))) {
     curr = curr->next;
   }
-  if (found_vertex) {         // loop over vertices neighbors, remove edges
-    u_int adj_slot = vertex->id;
-    while (graph->list[adj_slot] != NULL) {
-      graphRemoveEdgeU(graph, vertex, graph->list[adj_slot]->vertex);
-    }
+  if (!curr) return false;
+
+  if (graph->reverse) {    // and the matching node of the reverse list of two
+    adjacencyListNode_t *back = graph->reverse[two->id];
+    while (back->vertex != one || back->weight != curr->weight) { back = back->next; }
+    back->weight = new_weight;
+  }
+  curr->weight = new_weight;
+  graph->weighted = true;
+  return true;
+}
+
+
+void graphRemoveVertexU(graph_t *graph, graph_vertex *vertex)
+{
+  if (!graphExistsVertex(graph, vertex)) return;
+  _vertex_unlink(graph, vertex);
+
+  // loop over vertices neighbors, remove edges
+  u_int adj_slot = vertex->id;
+  while (graph->list[adj_slot] != NULL) {
+    graphRemoveEdgeU(graph, vertex, graph->list[adj_slot]->vertex);
   }
 }
 
 
 void graphRemoveVertexD(graph_t *graph, graph_vertex *vertex)
 {
-  bool found_vertex = false;       // find and eliminate node from vertex list
-  graph_vertex *curr = graph->vertex_head;
-  graph_vertex *prev = NULL;
-  while (curr) {
-    if (curr == vertex) {
-      found_vertex = true;
-      graph->numVertex--;
+  if (!graphExistsVertex(graph, vertex)) return;
+  _vertex_unlink(graph, vertex);
 
-      if (!prev) { graph->vertex_head = curr->next; }
-      else       { prev->next = curr->next; }
-      break;
+  adjacencyListNode_t *curr;
+  adjacencyListNode_t *prev;
+  if (graph->reverse) {
+    while (graph->list[vertex->id]) {       // free all out edges from vertex
+      _edge_unlink(graph, vertex->id, NULL, graph->list[vertex->id]);
     }
-    prev = curr;
-    curr = curr->next;
-  }
-  if (found_vertex) {              // loop over edges, removing them
-    adjacencyListNode_t *curr;
-    adjacencyListNode_t *prev;
-    for (size_t i = 0; i < graph->listSize; i++) {
-      curr = graph->list[i];
+    while (graph->reverse[vertex->id]) {    // free all in edges, looked up in reverse list
+      adjacencyListNode_t *back = graph->reverse[vertex->id];
+      unsigned int src_id = back->vertex->id;
       prev = NULL;
+      curr = graph->list[src_id];
+      while (curr->vertex != vertex || curr->weight != back->weight) {
+	prev = curr;
+	curr = curr->next;
+      }
+      _edge_unlink(graph, src_id, prev, curr);
+    }
+    return;
+  }
 
-      while (curr) {
-	if (i == vertex->id) {    // free all out edges from vertex
-	  graph->list[i] = NULL;
-	  prev = curr;
-	  curr = curr->next;
-	  free(prev);
-	} else {                  // free all in edges to vertex
-	  if (curr->vertex == vertex) {
-	    if (!prev) {
-	      graph->list[i] = curr->next;
-	      prev = curr;
-	      curr = curr->next;
-	      free(prev);
-	    } else {
-	      prev->next = curr->next;
-	      prev = curr;
-	      curr = curr->next;
-	      free(prev);
-	    }
-	  } else { prev = curr; curr = curr->next; }
-	}
+  // loop over edges, removing them
+  for (size_t i = 0; i < graph->listSize; i++) {
+    curr = graph->list[i];
+    prev = NULL;
+
+    while (curr) {
+      adjacencyListNode_t *next = curr->next;
+      if (i == vertex->id || curr->vertex == vertex) {  // out edges from, in edges to vertex
+	_edge_unlink(graph, i, prev, curr);
+      } else {
+	prev = curr;
       }
+      curr = next;
     }
   }
 }
@@ -485,17 +927,22 @@ void graphRemoveVertexD(graph_t *graph, graph_vertex *vertex)
 
 bool graphExistsVertex(graph_t *graph, graph_vertex *vertex)
 {
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    if (curr == vertex) { return true; }
-    curr = curr->next;
-  }
-  return false;
+  return vertex->id < graph->listSize && graph->vertex_index[vertex->id] == vertex;
+}
+
+
+graph_vertex* graphVertexById(graph_t *graph, unsigned int id)
+{
+  return id < graph->listSize ? graph->vertex_index[id] : NULL;
 }
 
 
 bool graphExistsEdge(graph_t *graph, graph_vertex *one, graph_vertex *two)
 {
+  if (graph->matrix) {
+    return graphExistsVertex(graph, one) && graphExistsVertex(graph, two)
+      && _matrix_test(graph, one->id, two->id);
+  }
   adjacencyListNode_t *curr = graph->list[one->id];
   while (curr) {
     if (curr->vertex == two) { return true; }
@@ -507,47 +954,28 @@ bool graphExistsEdge(graph_t *graph, graph_vertex *one, graph_vertex *two)
 
 int graphVertexDegreeU(graph_t *graph, graph_vertex *vertex)
 {
-  int num_neighbors = 0;
-  adjacencyListNode_t *curr = graph->list[vertex->id];
-
-  while (curr) {
-    num_neighbors++;
-    curr = curr->next;
-  }
-  return num_neighbors;
+  return graph->degree_out[vertex->id];
 }
 
 
 int graphVertexDegreeOut(graph_t *graph, graph_vertex *vertex)
 {
-  return graphVertexDegreeU(graph, vertex);
+  return graph->degree_out[vertex->id];
 }
 
 
 int graphVertexDegreeIn(graph_t *graph, graph_vertex *vertex)
 {
-  int in_deg = 0;
-  adjacencyListNode_t *curr;
-
-  for (size_t i = 0; i < graph->listSize; i++) {
-    if (i == vertex->id && !graph->pseudoGraph) continue;
-    curr = graph->list[i];
-
-    while (curr) {
-      if (curr->vertex == vertex) { in_deg++; }
-      curr = curr->next;
-    }
-  }
-  return in_deg;
+  return graph->degree_in[vertex->id];
 }
 
 
 void graphFree(graph_t *graph)
 {
-  // free adjacency list nodes
+  // free adjacency list nodes; an arena releases them all at once below
   adjacencyListNode_t *curr;
   adjacencyListNode_t *temp;
-  for (size_t i = 0; i < graph->listSize; i++) {
+  for (size_t i = 0; i < graph->listSize && !graph->arena; i++) {
     if ((curr = graph->list[i])) {
       while (curr) {
 	temp = curr;
@@ -555,15 +983,28 @@ void graphFree(graph_t *graph)
 	free(temp);
       }
     }
+    if (graph->reverse && (curr = graph->reverse[i])) {
+      while (curr) {
+	temp = curr;
+	curr = curr->next;
+	free(temp);
+      }
+    }
   }
-  // free vertices of graph
+  // free vertices of graph, except those living in the arena
   graph_vertex *curr2 = graph->vertex_head;
   graph_vertex *temp2;
   while (curr2) {
     temp2 = curr2;
     curr2 = curr2->next;
-    free(temp2);
+    if (!graph->arena || _arena_is_heap(graph->arena, temp2->id)) free(temp2);
   }
+  if (graph->arena) _arena_free(graph->arena);
+  free(graph->matrix);
+  free(graph->vertex_index);
+  free(graph->degree_out);
+  free(graph->degree_in);
+  free(graph->reverse);
   free(graph);
 }
 
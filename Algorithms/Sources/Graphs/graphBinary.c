@@ -0,0 +1,328 @@
+/*
+  Binary graph files
+  Building a large graph one graphAddVertex / graphAddEdge call at a time spends most of its
+  time in malloc, and a graph read back from a text dump must first be parsed. A CSR snapshot
+  (see graphCSR.c) on the other hand is nothing but four flat arrays. Written to a file as
+  they are in memory, they can be used straight from the file: map it into memory with mmap
+  and point the snapshot's arrays into the mapping. Opening a graph is then O(1), whatever
+  its size. Nothing is parsed or copied; the operating system reads each page of the file
+  the first time it is touched, and keeps it in the page cache for the next process to open
+  the same file.
+
+  Layout of the file (every section starts at a multiple of 8 bytes, so that the arrays are
+  aligned in the mapping as malloc would have aligned them):
+    header       magic, version, flags, numVertex, listSize, numEdge, checksum, and the
+                 byte offset of each section below from the start of the file
+    vertex ids   numVertex  uint32    member ids, in the order of graph's vertex_head
+    offsets      listSize+1 uint64
+    targets      numEdge    uint32
+    weights      numEdge    int32
+  Sections are padded with zeros to a multiple of 8 bytes.
+
+  Versioning: the version is bumped whenever the layout changes. A file of another version
+  (or not a graph file at all, or written on a machine of the other byte order: the magic
+  number reads backwards) is refused rather than misread.
+  Checksum: a 64 bit hash of the whole file, taken 8 bytes at a time with the checksum itself
+  counted as 0. Testing it reads every page of the file, which defeats the lazy loading, so
+  graphMapBinary only does so when asked. Without it the header is still checked for sizes
+  that agree with each other and with the size of the file, so that no array reaches past
+  the end of the mapping, and the offsets and member ids are checked in one pass, O(V): the
+  offsets never go down and end at numEdge, the ids are below listSize. The targets (and
+  weights) are trusted: checking them means reading every page of the file, as the checksum
+  does, so that is left to verify, which also checks every target is below listSize.
+
+  A file may also be filled in place: graphCreateBinary sizes and maps a new file for known
+  numbers of vertices and edges, and hands out a snapshot whose arrays are the file itself.
+  Once the caller has filled them, graphFinishBinary writes the header. Until then the file
+  has no magic number, so a file left behind half written is never mistaken for a graph.
+  (see graphConvertEdgeList, which writes files larger than memory this way)
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../../Headers/graph.h"
+
+
+#define GRAPH_FILE_MAGIC    0x52534347u     // "GCSR"
+#define GRAPH_FILE_VERSION  1u
+#define GRAPH_FILE_WEIGHTED 0x1u
+
+
+typedef struct graph_file_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t numVertex;
+  uint32_t listSize;
+  uint32_t reserved;               // 0
+  uint64_t numEdge;
+  uint64_t checksum;
+  uint64_t vertex_ids;             // byte offsets of the sections
+  uint64_t offsets;
+  uint64_t targets;
+  uint64_t weights;
+  uint64_t size;                   // of the whole file
+} graph_file_header_t;
+
+
+static inline
+uint64_t _pad8(uint64_t bytes)
+{
+  return (bytes + 7) & ~(uint64_t)7;
+}
+
+// lays out the sections of a file for a snapshot of the given sizes
+static
+void _file_layout(graph_file_header_t *header, uint32_t num_vertex, uint32_t list_size, uint64_t num_edge)
+{
+  header->vertex_ids = _pad8(sizeof(graph_file_header_t));
+  header->offsets    = header->vertex_ids + _pad8((uint64_t)num_vertex * sizeof(uint32_t));
+  header->targets    = header->offsets    + ((uint64_t)list_size + 1) * sizeof(uint64_t);
+  header->weights    = header->targets    + _pad8(num_edge * sizeof(uint32_t));
+  header->size       = header->weights    + _pad8(num_edge * sizeof(int32_t));
+}
+
+
+/*                      */
+/*      Checksum        */
+/*                      */
+
+static inline
+uint64_t _checksum_word(uint64_t hash, uint64_t word)
+{
+  hash ^= word * UINT64_C(0x9e3779b97f4a7c15);
+  hash  = (hash << 27) | (hash >> 37);
+  return hash * UINT64_C(0xff51afd7ed558ccd) + UINT64_C(0xc4ceb9fe1a85ec53);
+}
+
+// hashes a section as the 8 byte words it occupies in the file, padding included
+static
+uint64_t _checksum_section(uint64_t hash, const void *data, uint64_t bytes)
+{
+  const unsigned char *bytes_in = (const unsigned char*)data;
+  uint64_t word;
+  uint64_t full = bytes & ~(uint64_t)7;
+
+  for (uint64_t i = 0; i < full; i += 8) {
+    memcpy(&word, bytes_in + i, 8);
+    hash = _checksum_word(hash, word);
+  }
+  if (bytes > full) {
+    word = 0;
+    memcpy(&word, bytes_in + full, bytes - full);
+    hash = _checksum_word(hash, word);
+  }
+  return hash;
+}
+
+static
+uint64_t _checksum(const graph_file_header_t *header, const uint32_t *vertex_ids, const uint64_t *offsets,
+		   const uint32_t *targets, const int32_t *weights)
+{
+  graph_file_header_t copy = *header;
+  copy.checksum = 0;
+
+  uint64_t hash = _checksum_section(0, &copy, sizeof(copy));
+  hash = _checksum_section(hash, vertex_ids, (uint64_t)header->numVertex * sizeof(uint32_t));
+  hash = _checksum_section(hash, offsets, ((uint64_t)header->listSize + 1) * sizeof(uint64_t));
+  hash = _checksum_section(hash, targets, header->numEdge * sizeof(uint32_t));
+  hash = _checksum_section(hash, weights, header->numEdge * sizeof(int32_t));
+  return hash;
+}
+
+
+/*                      */
+/*      Writing         */
+/*                      */
+
+// writes bytes of data followed by zeros up to a multiple of 8
+static
+int _write_section(FILE *file, const void *data, uint64_t bytes)
+{
+  static const unsigned char zeros[8] = { 0 };
+  if (bytes && fwrite(data, bytes, 1, file) != 1) return 1;
+  uint64_t padding = _pad8(bytes) - bytes;
+  if (padding && fwrite(zeros, padding, 1, file) != 1) return 1;
+  return 0;
+}
+
+
+int graphCSRWriteBinary(graph_csr_t *csr, const char *path)
+{
+  graph_file_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = GRAPH_FILE_MAGIC;
+  header.version   = GRAPH_FILE_VERSION;
+  header.flags     = csr->weighted ? GRAPH_FILE_WEIGHTED : 0;
+  header.numVertex = csr->numVertex;
+  header.listSize  = csr->listSize;
+  header.numEdge   = csr->numEdge;
+  _file_layout(&header, csr->numVertex, csr->listSize, csr->numEdge);
+  header.checksum  = _checksum(&header, csr->vertex_ids, csr->offsets, csr->targets, csr->weights);
+
+  FILE *file = fopen(path, "wb");
+  if (!file) { perror("fopen");  return 1; }
+
+  int failed = _write_section(file, &header, sizeof(header))
+    || _write_section(file, csr->vertex_ids, (uint64_t)csr->numVertex * sizeof(uint32_t))
+    || _write_section(file, csr->offsets, ((uint64_t)csr->listSize + 1) * sizeof(uint64_t))
+    || _write_section(file, csr->targets, csr->numEdge * sizeof(uint32_t))
+    || _write_section(file, csr->weights, csr->numEdge * sizeof(int32_t));
+  if (fclose(file) != 0) failed = 1;
+  return failed;
+}
+
+
+int graphWriteBinary(graph_t *graph, const char *path)
+{
+  graph_csr_t *csr = graphFreeze(graph);
+  int failed = graphCSRWriteBinary(csr, path);
+  graphCSRFree(csr);
+  return failed;
+}
+
+
+/*                      */
+/*      Mapping         */
+/*                      */
+
+graph_csr_t* graphMapBinary(const char *path, bool verify)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) { perror("open");  return NULL; }
+
+  struct stat info;
+  if (fstat(fd, &info) == -1) { perror("fstat");  close(fd);  return NULL; }
+  if ((uint64_t)info.st_size < sizeof(graph_file_header_t)) {
+    fprintf(stderr, "%s: not a graph file of a supported version\n", path);
+    close(fd);
+    return NULL;
+  }
+
+  void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);                          // the mapping keeps the file open
+  if (mapping == MAP_FAILED) { perror("mmap");  return NULL; }
+
+  graph_file_header_t header, expected;
+  memcpy(&header, mapping, sizeof(header));
+  if (header.magic != GRAPH_FILE_MAGIC || header.version != GRAPH_FILE_VERSION) {
+    fprintf(stderr, "%s: not a graph file of a supported version\n", path);
+    munmap(mapping, info.st_size);
+    return NULL;
+  }
+
+  // the sections must be where this version puts them, and the file just large enough
+  _file_layout(&expected, header.numVertex, header.listSize, header.numEdge);
+  if (header.vertex_ids != expected.vertex_ids || header.offsets != expected.offsets
+      || header.targets != expected.targets || header.weights != expected.weights
+      || header.size != expected.size || header.size != (uint64_t)info.st_size
+      || header.numVertex > header.listSize) {
+    fprintf(stderr, "%s: graph file is truncated or corrupt\n", path);
+    munmap(mapping, info.st_size);
+    return NULL;
+  }
+
+  graph_csr_t *csr = (graph_csr_t*)malloc(sizeof(*csr));
+  if (!csr) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  char *base = (char*)mapping;
+  csr->numVertex    = header.numVertex;
+  csr->listSize     = header.listSize;
+  csr->numEdge      = header.numEdge;
+  csr->weighted     = header.flags & GRAPH_FILE_WEIGHTED;
+  csr->vertex_ids   = (uint32_t*)(base + header.vertex_ids);
+  csr->offsets      = (uint64_t*)(base + header.offsets);
+  csr->targets      = (uint32_t*)(base + header.targets);
+  csr->weights      = (int32_t*) (base + header.weights);
+  csr->mapping      = mapping;
+  csr->mapping_size = info.st_size;
+
+  // O(V): the offsets must run from 0 up to numEdge without going down, so that each
+  // vertex's targets lie within the array, and the member ids must be within the list
+  bool valid = csr->offsets[0] == 0 && csr->offsets[csr->listSize] == csr->numEdge;
+  for (size_t v = 0; valid && v < csr->listSize; v++) {
+    valid = csr->offsets[v] <= csr->offsets[v + 1];
+  }
+  for (size_t i = 0; valid && i < csr->numVertex; i++) {
+    valid = csr->vertex_ids[i] < csr->listSize;
+  }
+  // O(E), reading the whole file: the targets too
+  for (uint64_t e = 0; valid && verify && e < csr->numEdge; e++) {
+    valid = csr->targets[e] < csr->listSize;
+  }
+  if (valid && verify) {
+    valid = header.checksum == _checksum(&header, csr->vertex_ids, csr->offsets, csr->targets, csr->weights);
+  }
+  if (!valid) {
+    fprintf(stderr, "%s: graph file is truncated or corrupt\n", path);
+    graphCSRFree(csr);
+    return NULL;
+  }
+  return csr;
+}
+
+
+/*                      */
+/*   Writing in place   */
+/*                      */
+
+graph_csr_t* graphCreateBinary(const char *path, unsigned int list_size, unsigned int num_vertex,
+			       uint64_t num_edge, bool weighted)
+{
+  graph_file_header_t header;
+  memset(&header, 0, sizeof(header));
+  _file_layout(&header, num_vertex, list_size, num_edge);
+
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) { perror("open");  return NULL; }
+  if (ftruncate(fd, header.size) == -1) { perror("ftruncate");  close(fd);  return NULL; }
+
+  // the header stays zero (no magic number) until graphFinishBinary
+  void *mapping = mmap(NULL, header.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) { perror("mmap");  return NULL; }
+
+  graph_csr_t *csr = (graph_csr_t*)malloc(sizeof(*csr));
+  if (!csr) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  char *base = (char*)mapping;
+  csr->numVertex    = num_vertex;
+  csr->listSize     = list_size;
+  csr->numEdge      = num_edge;
+  csr->weighted     = weighted;
+  csr->vertex_ids   = (uint32_t*)(base + header.vertex_ids);
+  csr->offsets      = (uint64_t*)(base + header.offsets);
+  csr->targets      = (uint32_t*)(base + header.targets);
+  csr->weights      = (int32_t*) (base + header.weights);
+  csr->mapping      = mapping;
+  csr->mapping_size = header.size;
+  return csr;
+}
+
+
+int graphFinishBinary(graph_csr_t *csr)
+{
+  graph_file_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = GRAPH_FILE_MAGIC;
+  header.version   = GRAPH_FILE_VERSION;
+  header.flags     = csr->weighted ? GRAPH_FILE_WEIGHTED : 0;
+  header.numVertex = csr->numVertex;
+  header.listSize  = csr->listSize;
+  header.numEdge   = csr->numEdge;
+  _file_layout(&header, csr->numVertex, csr->listSize, csr->numEdge);
+  header.checksum  = _checksum(&header, csr->vertex_ids, csr->offsets, csr->targets, csr->weights);
+
+  memcpy(csr->mapping, &header, sizeof(header));
+  if (msync(csr->mapping, csr->mapping_size, MS_SYNC) == -1) { perror("msync");  return 1; }
+  return 0;
+}
@@ -0,0 +1,333 @@
+/*
+  Compressed Sparse Row (CSR) snapshots
+  The adjacency lists of graph.c are a good fit for graphs that keep changing: adding
+  an edge is a single allocation and a pointer swap. Traversing them however means
+  following one pointer per edge, and the nodes are scattered across the heap, so
+  nearly every edge visited costs a cache miss.
+
+  Once a graph stops changing we can "freeze" it into a CSR snapshot. All edges are
+  laid out back to back in one array (targets), grouped by their source vertex. A
+  second array (offsets) records where the group of each vertex begins; the edges of
+  vertex i are found at positions offsets[i] up to, but not including, offsets[i+1].
+  The weights live in a third array parallel to targets.
+    Memory:          O(V + E)  (two 32-bit ints per edge, one 64-bit int per vertex)
+    Traverse graph:  O(V + E)  (but sequential reads: the hardware prefetcher helps)
+    Out-edges(v):    O(1) to find, O(deg) to scan
+    Add/Remove:      not supported; freeze the graph again instead
+
+  The algorithms below mirror those of breadthFirstSearch.c, depthFirstSearch.c and
+  singleSourceShortestPath.c and return the same hash tables, so callers may switch
+  between the two representations freely. Their bookkeeping is done in arrays indexed
+  by vertex id rather than in hash tables; the hash table is only built at the end.
+
+  Transposing a snapshot is a counting sort of its edges by destination: O(V + E).
+  Snapshots can be written to a file and mapped back into memory, see graphBinary.c.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#include "../../Headers/graph.h"
+#include "../../Headers/Graphs/hashTables.h"
+#include "../../Headers/indexedHeap.h"
+
+
+static
+void* _csr_malloc(size_t size)
+{
+  void *new = malloc(size ? size : 1);
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
+
+static
+graph_csr_t* _csr_init(unsigned int list_size, unsigned int num_vertex, uint64_t num_edge, bool weighted)
+{
+  graph_csr_t *new = (graph_csr_t*)_csr_malloc(sizeof(*new));
+  new->numVertex  = num_vertex;
+  new->listSize   = list_size;
+  new->numEdge    = num_edge;
+  new->weighted   = weighted;
+  new->vertex_ids = (uint32_t*)_csr_malloc(sizeof(uint32_t) * num_vertex);
+  new->offsets    = (uint64_t*)_csr_malloc(sizeof(uint64_t) * ((size_t)list_size + 1));
+  new->targets    = (uint32_t*)_csr_malloc(sizeof(uint32_t) * num_edge);
+  new->weights    = (int32_t*) _csr_malloc(sizeof(int32_t)  * num_edge);
+  new->mapping    = NULL;
+  new->mapping_size = 0;
+  return new;
+}
+
+
+/*                                  */
+/*       Building snapshots         */
+/*                                  */
+
+graph_csr_t* graphFreeze(graph_t *graph)
+{
+  // count edges first so that every array is allocated exactly once
+  uint64_t num_edge = 0;
+  for (size_t i = 0; i < graph->listSize; i++) {
+    adjacencyListNode_t *edge = graph->list[i];
+    while (edge) { num_edge++; edge = edge->next; }
+  }
+  graph_csr_t *csr = _csr_init(graph->listSize, graph->numVertex, num_edge, graph->weighted);
+
+  u_int i = 0;
+  graph_vertex *curr = graph->vertex_head;
+  while (curr) {
+    csr->vertex_ids[i++] = curr->id;
+    curr = curr->next;
+  }
+
+  uint64_t pos = 0;
+  for (size_t v = 0; v < graph->listSize; v++) {
+    csr->offsets[v] = pos;
+    adjacencyListNode_t *edge = graph->list[v];
+    while (edge) {
+      csr->targets[pos] = edge->vertex->id;
+      csr->weights[pos] = edge->weight;
+      pos++;
+      edge = edge->next;
+    }
+  }
+  csr->offsets[graph->listSize] = pos;
+  return csr;
+}
+
+
+graph_csr_t* graphCSRTranspose(graph_csr_t *csr)
+{
+  graph_csr_t *transpose = _csr_init(csr->listSize, csr->numVertex, csr->numEdge, csr->weighted);
+  memcpy(transpose->vertex_ids, csr->vertex_ids, sizeof(uint32_t) * csr->numVertex);
+
+  // in-degree of every vertex becomes its out-degree in the transpose
+  memset(transpose->offsets, 0, sizeof(uint64_t) * ((size_t)csr->listSize + 1));
+  for (uint64_t e = 0; e < csr->numEdge; e++) {
+    transpose->offsets[csr->targets[e] + 1]++;
+  }
+  for (size_t v = 0; v < csr->listSize; v++) {
+    transpose->offsets[v + 1] += transpose->offsets[v];
+  }
+
+  // place each edge at the next free slot of its destination's group
+  uint64_t *cursor = (uint64_t*)_csr_malloc(sizeof(uint64_t) * (csr->listSize ? csr->listSize : 1));
+  memcpy(cursor, transpose->offsets, sizeof(uint64_t) * csr->listSize);
+  for (size_t v = 0; v < csr->listSize; v++) {
+    for (uint64_t e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+      uint64_t slot = cursor[csr->targets[e]]++;
+      transpose->targets[slot] = v;
+      transpose->weights[slot] = csr->weights[e];
+    }
+  }
+  free(cursor);
+  return transpose;
+}
+
+
+void graphCSRFree(graph_csr_t *csr)
+{
+  if (csr->mapping) {           // arrays live in the file mapping, see graphBinary.c
+    munmap(csr->mapping, csr->mapping_size);
+    free(csr);
+    return;
+  }
+  free(csr->vertex_ids);
+  free(csr->offsets);
+  free(csr->targets);
+  free(csr->weights);
+  free(csr);
+}
+
+
+/*                                  */
+/*       Breadth-First Search       */
+/*                                  */
+
+hashTable* breadthFirstSearchCSR(graph_csr_t *csr, unsigned int source)
+{
+  // each vertex enters the queue at most once: a flat array suffices
+  uint32_t *queue = (uint32_t*)_csr_malloc(sizeof(uint32_t) * csr->listSize);
+  int      *depth = (int*)     _csr_malloc(sizeof(int) * csr->listSize);
+  int      *pred  = (int*)     _csr_malloc(sizeof(int) * csr->listSize);
+  for (size_t i = 0; i < csr->listSize; i++) { depth[i] = -1; }
+
+  size_t head = 0, tail = 0;
+  queue[tail++] = source;
+  depth[source] = 0;
+  pred[source]  = -1;
+  GRAPH_STAT_ADD(vertices_visited, 1);
+
+  while (head < tail) {
+    uint32_t current = queue[head++];
+    for (uint64_t e = csr->offsets[current]; e < csr->offsets[current + 1]; e++) {
+      uint32_t next = csr->targets[e];
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (depth[next] == -1) {
+	GRAPH_STAT_ADD(vertices_visited, 1);
+	depth[next] = depth[current] + 1;
+	pred[next]  = current;
+	queue[tail++] = next;
+      }
+    }
+  }
+
+  hashTable *seen = hashTableBuild();
+  for (size_t i = 0; i < tail; i++) {
+    hashTableInsertNode(&seen, nodeHashTable_int(queue[i], depth[queue[i]], pred[queue[i]]));
+  }
+  free(queue); free(depth); free(pred);
+  return seen;
+}
+
+
+/*                                  */
+/*       Depth-First Search         */
+/*                                  */
+
+// iterative DFS from root: the frame of each vertex on the stack remembers the next
+// edge it has to explore, so vertices are discovered in the same order as recursion would.
+// post (when non-NULL) receives vertices in the order in which they finish.
+static
+void _csr_dfs_visit(graph_csr_t *csr, uint32_t root, int *parent, uint32_t *stack,
+		    uint64_t *cursor, uint32_t *post, size_t *num_post)
+{
+  size_t top = 0;
+  stack[top] = root;  cursor[top] = csr->offsets[root];  top++;
+  GRAPH_STAT_ADD(vertices_visited, 1);
+
+  while (top > 0) {
+    uint32_t vertex = stack[top - 1];
+    if (cursor[top - 1] < csr->offsets[vertex + 1]) {
+      uint32_t next = csr->targets[cursor[top - 1]++];
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (parent[next] == -2) {
+	GRAPH_STAT_ADD(vertices_visited, 1);
+	parent[next] = vertex;
+	stack[top] = next;  cursor[top] = csr->offsets[next];  top++;
+      }
+    } else {
+      if (post) { post[(*num_post)++] = vertex; }
+      top--;
+    }
+  }
+}
+
+
+hashTable* depthFirstSearchCSR(graph_csr_t *csr)
+{
+  int      *parent = (int*)     _csr_malloc(sizeof(int) * csr->listSize);
+  uint32_t *stack  = (uint32_t*)_csr_malloc(sizeof(uint32_t) * csr->listSize);
+  uint64_t *cursor = (uint64_t*)_csr_malloc(sizeof(uint64_t) * csr->listSize);
+  for (size_t i = 0; i < csr->listSize; i++) { parent[i] = -2; }  // -2: not yet discovered
+
+  for (size_t i = 0; i < csr->numVertex; i++) {
+    uint32_t root = csr->vertex_ids[i];
+    if (parent[root] == -2) {
+      parent[root] = -1;
+      _csr_dfs_visit(csr, root, parent, stack, cursor, NULL, NULL);
+    }
+  }
+
+  hashTable *forest = hashTableBuild();
+  for (size_t i = 0; i < csr->numVertex; i++) {
+    uint32_t id = csr->vertex_ids[i];
+    hashTableInsertNode(&forest, nodeHashTable_int(id, parent[id], parent[id]));
+  }
+  free(parent); free(stack); free(cursor);
+  return forest;
+}
+
+
+/*                                     */
+/*   Strongly Connected Components     */
+/*                                     */
+
+// Kosaraju, as in depthFirstSearch.c: the finishing order of the first pass is recorded
+// in an array so that the second pass can enter vertices in reverse order directly.
+hashTable* stronglyConnectedComponentsCSR(graph_csr_t *csr)
+{
+  int      *parent   = (int*)     _csr_malloc(sizeof(int) * csr->listSize);
+  uint32_t *stack    = (uint32_t*)_csr_malloc(sizeof(uint32_t) * csr->listSize);
+  uint64_t *cursor   = (uint64_t*)_csr_malloc(sizeof(uint64_t) * csr->listSize);
+  uint32_t *finished = (uint32_t*)_csr_malloc(sizeof(uint32_t) * csr->numVertex);
+  size_t num_finished = 0;
+  for (size_t i = 0; i < csr->listSize; i++) { parent[i] = -2; }
+
+  // DFS of original snapshot in order to find order of finishing times
+  for (size_t i = 0; i < csr->numVertex; i++) {
+    uint32_t root = csr->vertex_ids[i];
+    if (parent[root] == -2) {
+      parent[root] = -1;
+      _csr_dfs_visit(csr, root, parent, stack, cursor, finished, &num_finished);
+    }
+  }
+
+  // DFS of the transpose, entering vertices by decreasing finishing time
+  graph_csr_t *transpose = graphCSRTranspose(csr);
+  for (size_t i = 0; i < csr->listSize; i++) { parent[i] = -2; }
+  for (size_t i = num_finished; i > 0; i--) {
+    uint32_t root = finished[i - 1];
+    if (parent[root] == -2) {
+      parent[root] = -1;
+      _csr_dfs_visit(transpose, root, parent, stack, cursor, NULL, NULL);
+    }
+  }
+  graphCSRFree(transpose);
+
+  hashTable *forest = hashTableBuild();
+  for (size_t i = 0; i < csr->numVertex; i++) {
+    uint32_t id = csr->vertex_ids[i];
+    hashTableInsertNode(&forest, nodeHashTable_int(id, parent[id], parent[id]));
+  }
+  free(parent); free(stack); free(cursor); free(finished);
+  return forest;
+}
+
+
+/*                                  */
+/*       Dijkstra                   */
+/*                                  */
+
+hashTable* singleSourceShortestPath_dijkstraCSR(graph_csr_t *csr, unsigned int source)
+{
+  int *dist = (int*)_csr_malloc(sizeof(int) * csr->listSize);
+  int *pred = (int*)_csr_malloc(sizeof(int) * csr->listSize);
+  for (size_t i = 0; i < csr->listSize; i++) { dist[i] = INT_MAX;  pred[i] = -1; }
+  indexedHeap heap;
+  indexedHeapInit(&heap, csr->listSize);
+
+  // only discovered vertices are placed in the heap
+  dist[source] = 0;
+  indexedHeapPush(&heap, source, 0);
+
+  while (!indexedHeapIsEmpty(&heap)) {
+    uint32_t vertex = indexedHeapExtractMin(&heap).id;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+
+    for (uint64_t e = csr->offsets[vertex]; e < csr->offsets[vertex + 1]; e++) {
+      uint32_t next = csr->targets[e];
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (dist[next] > dist[vertex] + csr->weights[e]) {
+	dist[next] = dist[vertex] + csr->weights[e];
+	GRAPH_STAT_ADD(relaxations, 1);
+	pred[next] = vertex;
+	indexedHeapPush(&heap, next, dist[next]);
+      }
+    }
+  }
+
+  hashTable *paths = hashTableBuild();
+  for (size_t i = 0; i < csr->numVertex; i++) {
+    uint32_t id = csr->vertex_ids[i];
+    hashTableInsertNode(&paths, nodeHashTable_int(id, dist[id], pred[id]));
+  }
+  free(dist); free(pred);
+  indexedHeapDestroy(&heap);
+  return paths;
+}
@@ -0,0 +1,76 @@
+/*
+  Dense results
+  Vertex ids are indexes into the graph's adjacency list, so the ids of a graph are
+  already a dense range [0, listSize). Traversals can therefore keep their per-vertex
+  bookkeeping (depth, distance, predecessor, visited) in plain arrays indexed by id.
+  Compared to the hash table used by the older functions, a lookup is a single load:
+  no key conversion, no allocation, no hashing and no walking of chains.
+  The visited set is a bitset: one bit per vertex id, 64 ids to a word.
+
+  graphDenseToHashTable converts a result to the hash table form, which remains the
+  return type of breadthFirstSearch, depthFirstSearch and the shortest path functions.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "../../Headers/graph.h"
+#include "../../Headers/Graphs/hashTables.h"
+
+
+graph_dense_t* graphDenseBuild(unsigned int size)
+{
+  size_t words = ((size_t)size + 63) / 64;
+  graph_dense_t *new = (graph_dense_t*)malloc(sizeof(*new));
+  if (new) {
+    new->dist    = (int*)malloc(sizeof(int) * (size ? size : 1));
+    new->pred    = (int*)malloc(sizeof(int) * (size ? size : 1));
+    new->visited = (uint64_t*)calloc(words ? words : 1, sizeof(uint64_t));
+  }
+  if (!new || !new->dist || !new->pred || !new->visited) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  new->size = size;
+  for (size_t i = 0; i < size; i++) {
+    new->dist[i] = INT_MAX;
+    new->pred[i] = -1;
+  }
+  return new;
+}
+
+
+void graphDenseFree(graph_dense_t *result)
+{
+  free(result->dist);
+  free(result->pred);
+  free(result->visited);
+  free(result);
+}
+
+
+hashTable* graphDenseToHashTable(graph_dense_t *result, graph_t *graph)
+{
+  hashTable *table = hashTableBuild();
+
+  if (!graph) {                  // visited vertices only
+    for (size_t i = 0; i < result->size; i++) {
+      if (graphDenseVisited(result, i)) {
+	hashTableInsertNode(&table, nodeHashTable_int(i, result->dist[i], result->pred[i]));
+      }
+    }
+  } else {                       // every vertex of graph
+    graph_vertex *curr = graph->vertex_head;
+    while (curr) {
+      if (curr->id < result->size) {
+	hashTableInsertNode(&table, nodeHashTable_int(curr->id, result->dist[curr->id], result->pred[curr->id]));
+      } else {
+	hashTableInsertNode(&table, nodeHashTable_int(curr->id, INT_MAX, -1));
+      }
+      curr = curr->next;
+    }
+  }
+  return table;
+}
@@ -0,0 +1,555 @@
+/*
+  Reading edge lists
+  The usual way graphs are exchanged (SNAP, KONECT, most benchmark suites) is a text file of
+  edges, one per line: the source id, the destination id and optionally a weight, separated
+  by blanks, tabs or commas. Lines starting with '#' or '%' are comments. Files of this kind
+  run to billions of lines, often gzip'd, so they are read here as a stream, never whole.
+
+  The file is read in large buffers by a background thread while the calling thread parses
+  the buffers already read: reading (or decompressing) and parsing overlap. The reader cuts
+  every buffer after its last complete line and carries the rest over to the front of the
+  next buffer, so the parser never sees a line cut in two. Only a few buffers exist at a
+  time; the reader waits for the parser to give one back before it reads any further.
+  The parser does not use scanf and friends: it walks the buffer once, building each number
+  from its digits as it goes. A '\n' placed past the end of every buffer stops it without a
+  bounds check in the inner loops.
+
+  Parsed edges are handed to a callback in batches of arrays, the form graphBuildFromEdgeList
+  takes, so memory use is bounded by the buffers and one batch whatever the size of the file.
+  Whether the edges are weighted is decided by the first edge: if it has a weight every edge
+  is expected to have one (a missing weight is 0, as with graphAddEdgeD), otherwise weights
+  are ignored throughout.
+
+  Gzip'd input is read through zlib, which also reads uncompressed files as they are, when
+  the library is built with GRAPH_ZLIB defined (see the Makefile). Without it gzip'd files are
+  recognized by their first two bytes and refused.
+
+  Converting to a binary graph file (graphConvertEdgeList) never holds the edges in memory:
+  the file is read twice. The first pass counts the out-degree of every id, which gives the
+  CSR offsets and the sizes of the binary file (see graphBinary.c). The file is created at its
+  final size and mapped, and the second pass writes each edge straight to its place in the
+  mapping. Memory: O(V), plus whatever part of the output the operating system keeps cached.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef GRAPH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "../../Headers/graph.h"
+
+
+#define EDGE_LIST_BUFFER_SIZE (4u << 20)    // bytes read at a time
+#define EDGE_LIST_BUFFERS     3             // read ahead by the I/O thread
+#define EDGE_LIST_BATCH       65536         // edges per callback
+
+
+typedef struct edge_list_buffer_t {
+  char   *data;                // EDGE_LIST_BUFFER_SIZE + 1 bytes, room for the sentinel
+  size_t  size;
+} edge_list_buffer_t;
+
+/* State shared by the I/O thread, which fills buffers, and the parsing thread. */
+typedef struct edge_list_stream_t {
+  const char        *path;
+#ifdef GRAPH_ZLIB
+  gzFile             gz;
+#else
+  int                fd;
+#endif
+  edge_list_buffer_t buffers[EDGE_LIST_BUFFERS];
+  size_t             head;     // next buffer to be parsed
+  size_t             count;    // buffers read and not yet parsed
+  bool               eof;      // no buffers will be added
+  bool               failed;   // I/O thread could not read
+  bool               stop;     // parser wants no more buffers
+  pthread_mutex_t    lock;
+  pthread_cond_t     filled;
+  pthread_cond_t     emptied;
+} edge_list_stream_t;
+
+
+static
+void* _edge_list_malloc(size_t size)
+{
+  void *new = malloc(size ? size : 1);
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
+
+
+/*                      */
+/*      I/O thread      */
+/*                      */
+
+// reads up to size bytes; @return bytes read, or -1 on error
+static
+long _edge_list_read(edge_list_stream_t *stream, char *data, size_t size)
+{
+  size_t total = 0;
+  while (total < size) {
+#ifdef GRAPH_ZLIB
+    int got = gzread(stream->gz, data + total, size - total);
+#else
+    ssize_t got = read(stream->fd, data + total, size - total);
+#endif
+    if (got < 0) return -1;
+    if (got == 0) break;
+    total += got;
+  }
+  return total;
+}
+
+static
+void* _edge_list_io(void *arg)
+{
+  edge_list_stream_t *stream = (edge_list_stream_t*)arg;
+  char  *carry = (char*)_edge_list_malloc(EDGE_LIST_BUFFER_SIZE);
+  size_t carry_size = 0;
+  bool   eof = false, failed = false;
+
+  while (!eof && !failed) {
+    pthread_mutex_lock(&stream->lock);
+    while (stream->count == EDGE_LIST_BUFFERS && !stream->stop) {
+      pthread_cond_wait(&stream->emptied, &stream->lock);
+    }
+    bool stop = stream->stop;
+    edge_list_buffer_t *buffer = &stream->buffers[(stream->head + stream->count) % EDGE_LIST_BUFFERS];
+    pthread_mutex_unlock(&stream->lock);
+    if (stop) break;
+
+    // the incomplete line left over from the last buffer comes first
+    memcpy(buffer->data, carry, carry_size);
+    long got = _edge_list_read(stream, buffer->data + carry_size, EDGE_LIST_BUFFER_SIZE - carry_size);
+    if (got < 0) {
+      fprintf(stderr, "%s: read error\n", stream->path);
+      failed = true;
+      break;
+    }
+    size_t size = carry_size + got;
+    eof = size < EDGE_LIST_BUFFER_SIZE;
+
+    // cut after the last complete line
+    buffer->size = size;
+    carry_size = 0;
+    if (!eof) {
+      char *last = buffer->data + size - 1;
+      while (last >= buffer->data && *last != '\n') last--;
+      if (last < buffer->data) {
+	fprintf(stderr, "%s: line longer than %u bytes\n", stream->path, EDGE_LIST_BUFFER_SIZE);
+	failed = true;
+	break;
+      }
+      buffer->size = last + 1 - buffer->data;
+      carry_size = size - buffer->size;
+      memcpy(carry, last + 1, carry_size);
+    }
+    buffer->data[buffer->size] = '\n';           // sentinel
+
+    pthread_mutex_lock(&stream->lock);
+    stream->count++;
+    pthread_cond_signal(&stream->filled);
+    pthread_mutex_unlock(&stream->lock);
+  }
+
+  pthread_mutex_lock(&stream->lock);
+  stream->eof = true;
+  stream->failed = failed;
+  pthread_cond_signal(&stream->filled);
+  pthread_mutex_unlock(&stream->lock);
+  free(carry);
+  return NULL;
+}
+
+
+/*                      */
+/*      Parsing         */
+/*                      */
+
+typedef struct edge_list_parser_t {
+  const char *path;
+  size_t      line;
+  int         weighted;       // -1 until the first edge was seen
+  uint32_t   *src;
+  uint32_t   *dst;
+  int        *weights;
+  size_t      size;           // edges in batch
+  uint64_t    edges;          // edges parsed so far
+  void      (*batch)(const uint32_t*, const uint32_t*, const int*, size_t, void*);
+  void       *arg;
+} edge_list_parser_t;
+
+
+static inline
+bool _is_blank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+static inline
+bool _is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// parses an id at *p; @return false if there is none or it does not fit in 32 bits
+static inline
+bool _parse_id(const char **p, uint32_t *id)
+{
+  const char *c = *p;
+  if (!_is_digit(*c)) return false;
+  uint64_t value = 0;
+  while (_is_digit(*c)) {
+    value = value * 10 + (*c++ - '0');
+    if (value >= UINT32_MAX) return false;
+  }
+  *id = value;
+  *p = c;
+  return true;
+}
+
+static inline
+bool _parse_weight(const char **p, int *weight)
+{
+  const char *c = *p;
+  bool negative = *c == '-';
+  if (negative || *c == '+') c++;
+  if (!_is_digit(*c)) return false;
+  int64_t value = 0;
+  while (_is_digit(*c)) {
+    value = value * 10 + (*c++ - '0');
+    if (value > (int64_t)INT32_MAX + 1) return false;
+  }
+  if (negative) value = -value;
+  if (value > INT32_MAX) return false;
+  *weight = value;
+  *p = c;
+  return true;
+}
+
+static
+void _edge_list_flush(edge_list_parser_t *parser)
+{
+  if (parser->size) {
+    parser->batch(parser->src, parser->dst, parser->weighted == 1 ? parser->weights : NULL,
+		  parser->size, parser->arg);
+  }
+  parser->size = 0;
+}
+
+// parses one buffer of complete lines, terminated by the sentinel; @return false on error
+static
+bool _edge_list_parse(edge_list_parser_t *parser, const char *p, const char *end)
+{
+  while (p < end) {
+    parser->line++;
+    while (_is_blank(*p)) p++;
+    if (*p == '\n') { p++;  continue; }
+    if (*p == '#' || *p == '%') {
+      while (*p != '\n') p++;
+      p++;
+      continue;
+    }
+
+    uint32_t src, dst;
+    int weight = 0;
+    bool valid = _parse_id(&p, &src);
+    while (valid && _is_blank(*p)) p++;
+    valid = valid && _parse_id(&p, &dst);
+    while (valid && _is_blank(*p)) p++;
+    if (valid && *p != '\n') {
+      if (parser->weighted == -1) parser->weighted = 1;
+      if (parser->weighted == 1) valid = _parse_weight(&p, &weight);
+    }
+    if (!valid) {
+      fprintf(stderr, "%s:%zu: expected \"source destination [weight]\"\n", parser->path, parser->line);
+      return false;
+    }
+    if (parser->weighted == -1) parser->weighted = 0;
+
+    parser->src[parser->size]     = src;
+    parser->dst[parser->size]     = dst;
+    parser->weights[parser->size] = weight;
+    parser->edges++;
+    if (++parser->size == EDGE_LIST_BATCH) _edge_list_flush(parser);
+
+    while (*p != '\n') p++;                    // further columns are ignored
+    p++;
+  }
+  return true;
+}
+
+
+int graphReadEdgeList(const char *path,
+		      void (*batch)(const uint32_t*, const uint32_t*, const int*, size_t, void*), void *arg)
+{
+  edge_list_stream_t stream;
+  memset(&stream, 0, sizeof(stream));
+  stream.path = path;
+
+#ifdef GRAPH_ZLIB
+  stream.gz = gzopen(path, "rb");
+  if (!stream.gz) { perror("gzopen");  return 1; }
+  gzbuffer(stream.gz, 1u << 17);
+#else
+  stream.fd = open(path, O_RDONLY);
+  if (stream.fd == -1) { perror("open");  return 1; }
+  unsigned char magic[2];
+  if (pread(stream.fd, magic, 2, 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    fprintf(stderr, "%s: gzip'd input needs the library built with GRAPH_ZLIB\n", path);
+    close(stream.fd);
+    return 1;
+  }
+#endif
+
+  for (size_t i = 0; i < EDGE_LIST_BUFFERS; i++) {
+    stream.buffers[i].data = (char*)_edge_list_malloc(EDGE_LIST_BUFFER_SIZE + 1);
+  }
+  pthread_mutex_init(&stream.lock, NULL);
+  pthread_cond_init(&stream.filled, NULL);
+  pthread_cond_init(&stream.emptied, NULL);
+
+  edge_list_parser_t parser;
+  memset(&parser, 0, sizeof(parser));
+  parser.path     = path;
+  parser.weighted = -1;
+  parser.src      = (uint32_t*)_edge_list_malloc(sizeof(uint32_t) * EDGE_LIST_BATCH);
+  parser.dst      = (uint32_t*)_edge_list_malloc(sizeof(uint32_t) * EDGE_LIST_BATCH);
+  parser.weights  = (int*)_edge_list_malloc(sizeof(int) * EDGE_LIST_BATCH);
+  parser.batch    = batch;
+  parser.arg      = arg;
+
+  pthread_t io;
+  if (pthread_create(&io, NULL, _edge_list_io, &stream)) {
+    perror("pthread_create");  exit(EXIT_FAILURE);
+  }
+
+  bool failed = false;
+  for (;;) {
+    pthread_mutex_lock(&stream.lock);
+    while (stream.count == 0 && !stream.eof) pthread_cond_wait(&stream.filled, &stream.lock);
+    if (stream.count == 0) {
+      failed = stream.failed;
+      pthread_mutex_unlock(&stream.lock);
+      break;
+    }
+    edge_list_buffer_t *buffer = &stream.buffers[stream.head];
+    pthread_mutex_unlock(&stream.lock);
+
+    bool parsed = _edge_list_parse(&parser, buffer->data, buffer->data + buffer->size);
+
+    pthread_mutex_lock(&stream.lock);
+    stream.head = (stream.head + 1) % EDGE_LIST_BUFFERS;
+    stream.count--;
+    if (!parsed) stream.stop = true;
+    pthread_cond_signal(&stream.emptied);
+    pthread_mutex_unlock(&stream.lock);
+    if (!parsed) { failed = true;  break; }
+  }
+  pthread_join(io, NULL);
+  if (!failed) _edge_list_flush(&parser);
+
+#ifdef GRAPH_ZLIB
+  gzclose(stream.gz);
+#else
+  close(stream.fd);
+#endif
+  for (size_t i = 0; i < EDGE_LIST_BUFFERS; i++) { free(stream.buffers[i].data); }
+  pthread_mutex_destroy(&stream.lock);
+  pthread_cond_destroy(&stream.filled);
+  pthread_cond_destroy(&stream.emptied);
+  free(parser.src);
+  free(parser.dst);
+  free(parser.weights);
+  return failed;
+}
+
+
+/*                      */
+/*   Loading a graph    */
+/*                      */
+
+typedef struct edge_list_arrays_t {
+  uint32_t *src;
+  uint32_t *dst;
+  int      *weights;
+  bool      weighted;
+  size_t    size;
+  size_t    capacity;
+} edge_list_arrays_t;
+
+static
+void _edge_list_append(const uint32_t *src, const uint32_t *dst, const int *weights, size_t m, void *arg)
+{
+  edge_list_arrays_t *arrays = (edge_list_arrays_t*)arg;
+  if (arrays->size + m > arrays->capacity) {
+    while (arrays->size + m > arrays->capacity) arrays->capacity = arrays->capacity ? arrays->capacity * 2 : m;
+    arrays->src     = (uint32_t*)realloc(arrays->src, sizeof(uint32_t) * arrays->capacity);
+    arrays->dst     = (uint32_t*)realloc(arrays->dst, sizeof(uint32_t) * arrays->capacity);
+    arrays->weights = (int*)realloc(arrays->weights, sizeof(int) * arrays->capacity);
+    if (!arrays->src || !arrays->dst || !arrays->weights) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+  }
+  memcpy(arrays->src + arrays->size, src, sizeof(uint32_t) * m);
+  memcpy(arrays->dst + arrays->size, dst, sizeof(uint32_t) * m);
+  if (weights) memcpy(arrays->weights + arrays->size, weights, sizeof(int) * m);
+  arrays->weighted = weights != NULL;
+  arrays->size += m;
+}
+
+
+graph_t* graphLoadEdgeList(const char *path, unsigned int flags)
+{
+  edge_list_arrays_t arrays;
+  memset(&arrays, 0, sizeof(arrays));
+
+  graph_t *graph = NULL;
+  if (graphReadEdgeList(path, _edge_list_append, &arrays) == 0) {
+    graph = graphBuildFromEdgeList(arrays.src, arrays.dst, arrays.weighted ? arrays.weights : NULL,
+				   arrays.size, flags);
+  }
+  free(arrays.src);
+  free(arrays.dst);
+  free(arrays.weights);
+  return graph;
+}
+
+
+/*                      */
+/*    Converting        */
+/*                      */
+
+typedef struct edge_list_convert_t {
+  bool         undirected;
+  uint64_t    *degree;        // pass one: out-degree of each id; pass two: next free slot
+  uint64_t    *member;        // bitset of ids that are endpoints of an edge
+  size_t       capacity;      // ids degree and member have room for (multiple of 64)
+  size_t       num_ids;       // largest id seen + 1
+  uint64_t     edges;
+  bool         weighted;
+  graph_csr_t *csr;           // pass two
+} edge_list_convert_t;
+
+static
+void _convert_grow(edge_list_convert_t *convert, uint32_t id)
+{
+  if (id >= convert->num_ids) convert->num_ids = (size_t)id + 1;
+  if (id < convert->capacity) return;
+
+  size_t capacity = convert->capacity ? convert->capacity : 1024;
+  while (capacity <= id) capacity *= 2;
+  convert->degree = (uint64_t*)realloc(convert->degree, sizeof(uint64_t) * capacity);
+  convert->member = (uint64_t*)realloc(convert->member, sizeof(uint64_t) * (capacity / 64));
+  if (!convert->degree || !convert->member) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  memset(convert->degree + convert->capacity, 0, sizeof(uint64_t) * (capacity - convert->capacity));
+  memset(convert->member + convert->capacity / 64, 0, sizeof(uint64_t) * (capacity - convert->capacity) / 64);
+  convert->capacity = capacity;
+}
+
+static
+void _convert_count(const uint32_t *src, const uint32_t *dst, const int *weights, size_t m, void *arg)
+{
+  edge_list_convert_t *convert = (edge_list_convert_t*)arg;
+  for (size_t i = 0; i < m; i++) {
+    _convert_grow(convert, src[i]);
+    _convert_grow(convert, dst[i]);
+    convert->member[src[i] >> 6] |= UINT64_C(1) << (src[i] & 63);
+    convert->member[dst[i] >> 6] |= UINT64_C(1) << (dst[i] & 63);
+    convert->degree[src[i]]++;
+    if (convert->undirected) convert->degree[dst[i]]++;
+  }
+  convert->edges += convert->undirected ? 2 * m : m;
+  convert->weighted = weights != NULL;
+}
+
+static
+void _convert_place(const uint32_t *src, const uint32_t *dst, const int *weights, size_t m, void *arg)
+{
+  edge_list_convert_t *convert = (edge_list_convert_t*)arg;
+  graph_csr_t *csr = convert->csr;
+  for (size_t i = 0; i < m; i++) {
+    int weight = weights ? weights[i] : 0;
+    // an id beyond those of pass one means the file changed in between: caught by the count
+    if (src[i] >= csr->listSize || dst[i] >= csr->listSize) { convert->edges++;  continue; }
+
+    uint64_t slot = convert->degree[src[i]]++;
+    if (slot < csr->offsets[src[i] + 1]) { csr->targets[slot] = dst[i];  csr->weights[slot] = weight; }
+    if (convert->undirected) {
+      slot = convert->degree[dst[i]]++;
+      if (slot < csr->offsets[dst[i] + 1]) { csr->targets[slot] = src[i];  csr->weights[slot] = weight; }
+    }
+  }
+  convert->edges += convert->undirected ? 2 * m : m;
+}
+
+
+int graphConvertEdgeList(const char *path, const char *out, unsigned int flags)
+{
+  edge_list_convert_t convert;
+  memset(&convert, 0, sizeof(convert));
+  convert.undirected = flags & GRAPH_EDGES_UNDIRECTED;
+
+  // pass one: degrees and members
+  if (graphReadEdgeList(path, _convert_count, &convert)) {
+    free(convert.degree);
+    free(convert.member);
+    return 1;
+  }
+  if (convert.num_ids > UINT32_MAX) {
+    fprintf(stderr, "%s: too many vertex ids\n", path);
+    free(convert.degree);
+    free(convert.member);
+    return 1;
+  }
+  unsigned int list_size = convert.num_ids;
+  if (convert.capacity == 0) _convert_grow(&convert, 0);     // arrays exist even without edges
+  unsigned int num_vertex = 0;
+  for (size_t w = 0; w < (list_size + 63) / 64; w++) { num_vertex += __builtin_popcountll(convert.member[w]); }
+
+  graph_csr_t *csr = graphCreateBinary(out, list_size, num_vertex, convert.edges, convert.weighted);
+  if (!csr) {
+    free(convert.degree);
+    free(convert.member);
+    return 1;
+  }
+  size_t next = 0;
+  for (size_t id = 0; id < list_size; id++) {
+    if ((convert.member[id >> 6] >> (id & 63)) & 1) csr->vertex_ids[next++] = id;
+  }
+  uint64_t total = 0;
+  for (size_t id = 0; id < list_size; id++) {
+    csr->offsets[id] = total;
+    total += convert.degree[id];
+    convert.degree[id] = csr->offsets[id];
+  }
+  csr->offsets[list_size] = total;
+
+  // pass two: every edge straight to its slot in the file
+  uint64_t expected = convert.edges;
+  convert.csr   = csr;
+  convert.edges = 0;
+  int failed = graphReadEdgeList(path, _convert_place, &convert);
+  if (!failed && convert.edges != expected) {
+    fprintf(stderr, "%s: file changed while being read\n", path);
+    failed = 1;
+  }
+  if (!failed) failed = graphFinishBinary(csr);
+  graphCSRFree(csr);
+  if (failed) unlink(out);
+
+  free(convert.degree);
+  free(convert.member);
+  return failed;
+}
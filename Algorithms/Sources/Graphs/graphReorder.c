@@ -0,0 +1,369 @@
+/*
+  Vertex Reordering
+  Vertex ids index the adjacency arrays directly, and a traversal touches the entries of
+  the vertices it meets in an order set by the graph's edges. If ids were handed out with no
+  regard for the edges (in the order the vertices were read, say), neighbours are scattered
+  across memory and nearly every edge followed costs a cache miss, or a TLB miss on large
+  graphs. Renumbering the vertices so that neighbours get nearby ids makes the same traversal
+  touch fewer lines and pages. The renumbering is a permutation, computed once, and applied
+  by rebuilding the graph, or a CSR snapshot, in the new order.
+
+  Orderings:
+  - Reverse Cuthill-McKee (RCM): a BFS of the graph with its edges taken in both directions,
+    in which the neighbours of each vertex are queued by increasing degree, and the order
+    reversed at the end (Cuthill and McKee, 1969; George, 1971). It keeps the ids of the two
+    ends of every edge close: the bandwidth of the adjacency matrix is small. Each connected
+    piece starts from a pseudo-peripheral vertex, one far from the others: BFS is run again
+    from a vertex of least degree in the last level of the previous BFS, for as long as that
+    makes the BFS deeper (George and Liu, 1979). From there the BFS levels are many and
+    narrow. Best for meshes, grids and road networks.
+  - Degree: vertices by decreasing degree (in plus out). The hubs of a power-law graph get the
+    lowest ids, so the entries touched most often share a few cache lines.
+  - BFS: the order in which a BFS from a given root discovers the vertices (then from each
+    vertex not yet discovered, in turn). Vertices are numbered in the order a BFS traversal
+    will meet them, which suits graphs traversed from the same few sources.
+  Time: O(V + E) for BFS, O(V + E + max degree) for Degree, and O(V + E) per BFS for RCM:
+  a few of them per connected piece, plus the sorting of each vertex's neighbours by degree.
+
+  The new ids are dense: the member vertices get the ids 0 to numVertex-1, so holes left in
+  the id range by removed vertices are closed. The permutation maps both ways, so results
+  computed on the reordered graph (indexed by new id) can be translated back.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../Headers/graph.h"
+
+
+static
+void* _reorder_malloc(size_t size)
+{
+  void *new = malloc(size ? size : 1);
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
+
+static
+graph_permutation_t* _permutation_init(unsigned int size, unsigned int count)
+{
+  graph_permutation_t *new = (graph_permutation_t*)_reorder_malloc(sizeof(*new));
+  new->size       = size;
+  new->count      = count;
+  new->old_to_new = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * size);
+  new->new_to_old = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * count);
+  return new;
+}
+
+
+/*                      */
+/*     Orderings        */
+/*                      */
+
+// in (when transpose is given) plus out-degree of each id
+static
+uint32_t* _reorder_degrees(graph_csr_t *csr, graph_csr_t *transpose)
+{
+  uint32_t *degree = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * csr->listSize);
+  for (size_t v = 0; v < csr->listSize; v++) {
+    degree[v] = csr->offsets[v + 1] - csr->offsets[v];
+    if (transpose) degree[v] += transpose->offsets[v + 1] - transpose->offsets[v];
+  }
+  return degree;
+}
+
+// queues the out-neighbours (and, with transpose, in-neighbours) of vertex not yet seen
+static
+size_t _reorder_expand(graph_csr_t *csr, graph_csr_t *transpose, uint32_t vertex,
+		       uint32_t *queue, size_t tail, uint32_t *seen, uint32_t mark)
+{
+  for (uint64_t e = csr->offsets[vertex]; e < csr->offsets[vertex + 1]; e++) {
+    uint32_t next = csr->targets[e];
+    if (seen[next] != mark) { seen[next] = mark;  queue[tail++] = next; }
+  }
+  if (!transpose) return tail;
+  for (uint64_t e = transpose->offsets[vertex]; e < transpose->offsets[vertex + 1]; e++) {
+    uint32_t next = transpose->targets[e];
+    if (seen[next] != mark) { seen[next] = mark;  queue[tail++] = next; }
+  }
+  return tail;
+}
+
+
+static
+void _reorder_bfs(graph_csr_t *csr, unsigned int root, graph_permutation_t *perm)
+{
+  uint32_t *seen  = (uint32_t*)calloc(csr->listSize ? csr->listSize : 1, sizeof(uint32_t));
+  uint32_t *queue = perm->new_to_old;          // the discovery order is the new order
+  if (!seen) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  bool member = false;
+  for (unsigned int i = 0; i < csr->numVertex && !member; i++) { member = csr->vertex_ids[i] == root; }
+
+  // from the root first, then from every vertex not yet discovered, in turn
+  size_t head = 0, tail = 0;
+  for (unsigned int i = member ? 0 : 1; i <= csr->numVertex; i++) {
+    uint32_t start = i == 0 ? root : csr->vertex_ids[i - 1];
+    if (seen[start]) continue;
+    seen[start] = 1;
+    queue[tail++] = start;
+    while (head < tail) {
+      GRAPH_STAT_ADD(vertices_visited, 1);
+      tail = _reorder_expand(csr, NULL, queue[head++], queue, tail, seen, 1);
+    }
+  }
+  free(seen);
+}
+
+
+static
+void _reorder_degree(graph_csr_t *csr, graph_permutation_t *perm)
+{
+  graph_csr_t *transpose = graphCSRTranspose(csr);
+  uint32_t *degree = _reorder_degrees(csr, transpose);
+  graphCSRFree(transpose);
+
+  // counting sort, by decreasing degree, stable
+  uint32_t max = 0;
+  for (unsigned int i = 0; i < csr->numVertex; i++) {
+    if (degree[csr->vertex_ids[i]] > max) max = degree[csr->vertex_ids[i]];
+  }
+  size_t *start = (size_t*)calloc((size_t)max + 2, sizeof(size_t));
+  if (!start) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (unsigned int i = 0; i < csr->numVertex; i++) { start[max - degree[csr->vertex_ids[i]] + 1]++; }
+  for (uint32_t d = 0; d <= max; d++) { start[d + 1] += start[d]; }
+  for (unsigned int i = 0; i < csr->numVertex; i++) {
+    uint32_t id = csr->vertex_ids[i];
+    perm->new_to_old[start[max - degree[id]]++] = id;
+  }
+  free(start);
+  free(degree);
+}
+
+
+// BFS of the undirected graph from start, over vertices not yet numbered:
+// the vertices reached are queue[0..return); depth of last level in *depth
+static
+size_t _reorder_levels(graph_csr_t *csr, graph_csr_t *transpose, uint32_t start, uint32_t *queue,
+		       uint32_t *seen, uint32_t mark, unsigned int *depth, size_t *last)
+{
+  size_t head = 0, tail = 0, level_end;
+  seen[start] = mark;
+  queue[tail++] = start;
+  *depth = 0;
+  *last = 0;
+  while (head < tail) {
+    level_end = tail;
+    *last = head;
+    while (head < level_end) {
+      tail = _reorder_expand(csr, transpose, queue[head++], queue, tail, seen, mark);
+    }
+    if (tail > level_end) (*depth)++;
+  }
+  return tail;
+}
+
+static
+void _reorder_rcm(graph_csr_t *csr, graph_permutation_t *perm)
+{
+  graph_csr_t *transpose = graphCSRTranspose(csr);
+  uint32_t *degree = _reorder_degrees(csr, transpose);
+  // seen[v] is the mark of the last BFS that met v; numbered vertices have mark 1
+  uint32_t *seen  = (uint32_t*)calloc(csr->listSize ? csr->listSize : 1, sizeof(uint32_t));
+  uint32_t *queue = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * csr->numVertex);
+  uint32_t *order = perm->new_to_old;
+  if (!seen) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  uint32_t mark = 1;
+  size_t count = 0;
+
+  for (unsigned int i = 0; i < csr->numVertex; i++) {
+    if (seen[csr->vertex_ids[i]] == 1) continue;
+
+    // pseudo-peripheral: BFS again from a least degree vertex of the last level, while
+    // that makes the BFS deeper
+    uint32_t start = csr->vertex_ids[i];
+    unsigned int depth, best = 0;
+    size_t last;
+    for (;;) {
+      size_t size = _reorder_levels(csr, transpose, start, queue, seen, ++mark, &depth, &last);
+      if (best && depth <= best) break;
+      best = depth;
+      uint32_t next = queue[last];
+      for (size_t k = last + 1; k < size; k++) {
+	if (degree[queue[k]] < degree[next]) next = queue[k];
+      }
+      if (next == start) break;
+      start = next;
+    }
+
+    // Cuthill-McKee from start: the neighbours of each vertex queued by increasing degree
+    size_t head = count, tail = count;
+    seen[start] = 1;
+    order[tail++] = start;
+    while (head < tail) {
+      GRAPH_STAT_ADD(vertices_visited, 1);
+      size_t first = tail;
+      tail = _reorder_expand(csr, transpose, order[head++], order, tail, seen, 1);
+      for (size_t k = first + 1; k < tail; k++) {        // insertion sort: neighbours are few
+	uint32_t id = order[k];
+	size_t j = k;
+	while (j > first && degree[order[j - 1]] > degree[id]) { order[j] = order[j - 1];  j--; }
+	order[j] = id;
+      }
+    }
+    count = tail;
+  }
+
+  for (size_t k = 0; k < count / 2; k++) {
+    uint32_t tmp = order[k];
+    order[k] = order[count - 1 - k];
+    order[count - 1 - k] = tmp;
+  }
+  free(queue);
+  free(seen);
+  free(degree);
+  graphCSRFree(transpose);
+}
+
+
+graph_permutation_t* graphCSROrdering(graph_csr_t *csr, unsigned int strategy, unsigned int root)
+{
+  graph_permutation_t *perm = _permutation_init(csr->listSize, csr->numVertex);
+  switch (strategy) {
+  case GRAPH_REORDER_RCM:    _reorder_rcm(csr, perm);  break;
+  case GRAPH_REORDER_DEGREE: _reorder_degree(csr, perm);  break;
+  case GRAPH_REORDER_BFS:    _reorder_bfs(csr, root, perm);  break;
+  default:
+    fprintf(stderr, "Unknown vertex ordering %u\n", strategy);  exit(EXIT_FAILURE);
+  }
+
+  for (size_t v = 0; v < perm->size; v++) { perm->old_to_new[v] = UINT32_MAX; }
+  for (unsigned int i = 0; i < perm->count; i++) { perm->old_to_new[perm->new_to_old[i]] = i; }
+  return perm;
+}
+
+
+void graphPermutationFree(graph_permutation_t *perm)
+{
+  free(perm->old_to_new);
+  free(perm->new_to_old);
+  free(perm);
+}
+
+
+/*                      */
+/*     Rebuilding       */
+/*                      */
+
+// orders the edges of one vertex by new destination, ties by position
+static
+int _reorder_key_cmp(const void *one, const void *two)
+{
+  uint64_t a = *(const uint64_t*)one;
+  uint64_t b = *(const uint64_t*)two;
+  return (a > b) - (a < b);
+}
+
+
+graph_csr_t* graphCSRPermute(graph_csr_t *csr, graph_permutation_t *perm)
+{
+  graph_csr_t *new = (graph_csr_t*)_reorder_malloc(sizeof(*new));
+  new->numVertex  = perm->count;
+  new->listSize   = perm->count;
+  new->numEdge    = csr->numEdge;
+  new->weighted   = csr->weighted;
+  new->vertex_ids = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * perm->count);
+  new->offsets    = (uint64_t*)_reorder_malloc(sizeof(uint64_t) * ((size_t)perm->count + 1));
+  new->targets    = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * csr->numEdge);
+  new->weights    = (int32_t*) _reorder_malloc(sizeof(int32_t)  * csr->numEdge);
+  new->mapping    = NULL;
+  new->mapping_size = 0;
+
+  uint64_t max_degree = 0;
+  for (unsigned int i = 0; i < perm->count; i++) {
+    uint32_t old = perm->new_to_old[i];
+    uint64_t degree = csr->offsets[old + 1] - csr->offsets[old];
+    if (degree > max_degree) max_degree = degree;
+  }
+  uint64_t *keys = (uint64_t*)_reorder_malloc(sizeof(uint64_t) * max_degree);
+
+  uint64_t pos = 0;
+  for (unsigned int i = 0; i < perm->count; i++) {
+    uint32_t old = perm->new_to_old[i];
+    uint64_t begin = csr->offsets[old], degree = csr->offsets[old + 1] - begin;
+    new->vertex_ids[i] = i;
+    new->offsets[i] = pos;
+    for (uint64_t k = 0; k < degree; k++) {
+      keys[k] = (uint64_t)perm->old_to_new[csr->targets[begin + k]] << 32 | k;
+    }
+    qsort(keys, degree, sizeof(uint64_t), _reorder_key_cmp);
+    for (uint64_t k = 0; k < degree; k++) {
+      new->targets[pos] = keys[k] >> 32;
+      new->weights[pos] = csr->weights[begin + (keys[k] & 0xffffffff)];
+      pos++;
+    }
+  }
+  new->offsets[perm->count] = pos;
+  free(keys);
+  return new;
+}
+
+
+graph_csr_t* graphCSRReorder(graph_csr_t *csr, unsigned int strategy, unsigned int root,
+			     graph_permutation_t **perm)
+{
+  graph_permutation_t *order = graphCSROrdering(csr, strategy, root);
+  graph_csr_t *new = graphCSRPermute(csr, order);
+  if (perm) *perm = order;
+  else      graphPermutationFree(order);
+  return new;
+}
+
+
+graph_t* graphReorder(graph_t *graph, unsigned int strategy, unsigned int root, graph_permutation_t **perm)
+{
+  graph_csr_t *csr = graphFreeze(graph);
+  graph_permutation_t *order = graphCSROrdering(csr, strategy, root);
+
+  // the edges in new ids; built as a MultiGraph, so that every edge is kept as it is
+  uint32_t *src = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * csr->numEdge);
+  uint32_t *dst = (uint32_t*)_reorder_malloc(sizeof(uint32_t) * csr->numEdge);
+  for (size_t v = 0; v < csr->listSize; v++) {
+    for (uint64_t e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+      src[e] = order->old_to_new[v];
+      dst[e] = order->old_to_new[csr->targets[e]];
+    }
+  }
+  unsigned int flags = GRAPH_EDGES_MULTIGRAPH | (graph->pseudoGraph ? GRAPH_EDGES_PSEUDOGRAPH : 0);
+  graph_t *new = graphBuildFromEdgeList(src, dst, csr->weights, csr->numEdge, flags);
+  free(src);
+  free(dst);
+  graphCSRFree(csr);
+
+  new->multiGraph = graph->multiGraph;
+  new->weighted   = graph->weighted;
+  for (unsigned int i = 0; i < order->count; i++) {     // with the values, and vertices without edges
+    graph_vertex *old = graph->vertex_index[order->new_to_old[i]];
+    graph_vertex *vertex = i < new->listSize ? new->vertex_index[i] : NULL;
+    if (!vertex) {
+      vertex = graphArenaVertexNew(new, i, old->value);
+      graphAddVertex(&new, vertex);
+    }
+    vertex->value = old->value;
+  }
+  if (graph->reverse) graphEnableReverse(new);
+  if (graph->matrix)  graphEnableMatrix(new);
+
+  if (perm) *perm = order;
+  else      graphPermutationFree(order);
+  return new;
+}
@@ -56,7 +56,10 @@
  This is achiavable because DAGs do NOT have cycles. We can therefore lay them out in a
  linear manner and relax all outgoing edges, beginning at the start of that ordering and
  continuing until we have relaxed all outgoing edges of all vertices in the graph.
- We flatten the graph, ordering it, using topologial sort.
+ We flatten the graph, ordering it, using topologial sort (Kahn's algorithm, which writes
+ the order to a flat array of ids, see depthFirstSearch.c). The vertices also fall into
+ levels, or wavefronts: those of one level have no edges between them, so the out-edges of a
+ whole level can be relaxed by several threads at once (see singleSourceShortestPathParallel.c).
  Application: analyzing PERT charts (used for project scheduling) - we can easily compute
   minimum time for project completion (or task completion). Find maximal times by negating
   the edges. (Negative edges are okay in DAGs.)
@@ -67,15 +70,19 @@
  This is a "greedy" algorithm and it requires the use of a priority queue.
  The running time above is achieved when we implement the priority queue with a binary heap.
  If instead an array is used the running time becomes O(V^2).
+ In the implementation the heap is 4-ary (see Headers/indexedHeap.h): every node has four
+ children. This halves the depth of the heap, making decrease_key (by far the more frequent
+ operation) cheaper, at the price of more comparisons per level in extract_min.
  The heap is a min-heap and its keys are the vertice's distances. The greedy algorithm then
  extracts from the heap (initially containing all vertices) the min vertex, loops through
  all its outgoing edges, relaxing them. Then it extracts the new minimum from the heap, and
- repeats until the heap is empty.
+ repeats until the heap is empty. (Vertices at infinity can't be extracted usefully, so the
+ implementation only inserts a vertex into the heap once an edge to it is first relaxed.)
  Implementation detail: make sure that if an relaxation event occured that you maintain the
-  heap invariant. This can be done with a modified decrease_key function. Unlike its standard
-  implementation, it needs not update the key (done by relax), just needs to consider calling
-  heapify from the position of the updated vertex. The vertex struct is updated to contain a
-  property that carries the vertex's heap position at all times.
+  heap invariant. This is done with decrease_key: the heap keeps each key inline next to its
+  vertex id, and an array, indexed by vertex id, that carries each vertex's heap position at
+  all times. As that array belongs to the heap and not to the vertices, several searches may
+  run on the same graph at the same time.
 
  Bellman-Ford:  O(VE)
  Solves the single-source problem in the general case, where there may be edges with negative
@@ -96,6 +103,22 @@
  otherwise.
  In the cases where part 2 above identifies a negative cycle, the algorithm returns false and
  no distances or paths are returned. In this implementation the hash table returned is empty.
+ Most passes over every edge do nothing: an edge can only relax if the distance of its source
+ changed since the edge was last looked at. The implementation (bellmanFordDense) is therefore
+ the queue-based variant, sometimes called SPFA: a FIFO queue holds the vertices whose distance
+ changed, and only their outgoing edges are relaxed. A vertex already waiting in the queue is
+ not added again. The search has converged when the queue is empty, which on most graphs
+ happens after a few rounds rather than after V-1. The worst case is still O(VE).
+ Part two becomes a count: every vertex also keeps the number of edges on the best path found
+ to it so far. A shortest path has at most V-1 edges, so a path of V edges repeats a vertex,
+ and the cycle it goes around must be negative for the path to have improved by taking it.
+ Distances and predecessors live in arrays indexed by id (graph_dense_t) rather than in the
+ hash table, so a relaxation costs no lookups and allocates nothing.
+
+ Delta-Stepping:  (see singleSourceShortestPathParallel.c)
+ A multithreaded alternative to Dijkstra for non-negative weights, over CSR snapshots.
+ The same file runs whole Dijkstra searches from many sources side by side, filling a
+ distance matrix (singleSourceShortestPath_batch).
 
  Speeding up Dijkstra:
  Besides using a Fibonacci heap rather than a binary one, there are other means of getting
@@ -103,7 +126,7 @@
  One:
  If we wish to find the distance and path to a particular target vertex, t, we can run
  dijkstra as before but terminate the moment we extract t from the min-heap. At that point
- we will already have the optimum distance and path to t.
+ we will already have the optimum distance and path to t. (shortestPath_dijkstraTarget)
  Two:
  An even better improvement, if we want path, again to a particular target, t, is to do a
  bi-directional search. You basically do two dijkstra searches, one forward from source, the
@@ -113,6 +136,11 @@
  Then the shortest path is that from source to w plus the best from target to w.
  Warning: its possible that w is not on the shortest path; a simple correction is used for
    for this, it involves a final check that a better middle vertex does not exist.
+   (shortestPath_bidirectional) In this implementation the side whose heap has the smaller
+   minimum takes the next step, and the best path seen so far, mu, is updated whenever an
+   edge is scanned that connects to a vertex already reached by the other side. The search
+   stops once the minimums of the two heaps add up to at least mu: no undiscovered path can
+   be shorter than that, which is the correction mentioned above.
  Three:
  Using Potential Functions to modify the weight along the edges. Important that what was the
  shortest path to all destinations remains the same after applying the function, you merely
@@ -123,273 +151,621 @@
  You know you must go through landmark so algorithm can find fastest way from source to it,
  and from destination to landmark. Example: traveling from Maine to Huston, landmark being
  some place in the middle of the US that any good path must go through.
+ (shortestPath_ALT) The implementation uses landmarks differently, as the ALT method (A*,
+ Landmarks, Triangle inequality) does. Landmarks are picked ahead of time and the distances
+ from and to each are stored for every vertex. By the triangle inequality, for landmark L:
+   dist(v,t) >= dist(v,L) - dist(t,L)   and   dist(v,t) >= dist(L,t) - dist(L,v)
+ The largest of these bounds over all landmarks is the potential of v. A* search is Dijkstra
+ where the heap key of v is its distance plus its potential: vertices that seem to lead
+ towards t are extracted first. The potentials are consistent (they never overestimate,
+ and differ by no more than an edge's weight across that edge), so no vertex needs to be
+ extracted twice and the search can stop when it extracts t. Landmarks at the "edge" of the
+ graph give the best bounds, so each new landmark is the vertex farthest from those already
+ picked. The tables take 2 * k * V ints and can be saved to a file, see graphLandmarksSave.
 */
 
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
 
 #include "../../Headers/graph.h"
 #include "../../Headers/Graphs/hashTables.h"
+#include "../../Headers/indexedHeap.h"
 
 
 /*                         */
-/*    Heap for Dijkstra    */
+/*    helper functions     */
 /*                         */
 
-static
-int _parent_pos(int vertex)
+void singleSourceShortestPath_print(hashTable *paths, int dest)
 {
-  return (vertex - 1) / 2;
+  if (hashTableIsEmpty(paths)) {
+    printf("A negative weighted cycle exists in the graph.");
+    printf(" Distances are undefined!\n");
+  }
+  else if (hashTableSearchNode(paths, &dest, keyConvertFromInt)->value == INT_MAX) {
+    printf("Destination vertex is not reachable from source.\n");
+  }
+  else {
+    int parent = hashTableSearchNode(paths, &dest, keyConvertFromInt)->graph_predecessor;
+    if (parent == -1) {
+      printf("%d ", dest);
+    } else {
+      singleSourceShortestPath_print(paths, parent);
+      printf("%d ", dest);
+    }
+  }
 }
 
-static
-int _left_pos(int vertex)
-{
-  return (vertex * 2) + 1;
-}
 
-static
-int _right_pos(int vertex)
-{
-  return (vertex * 2) + 2;
-}
+/*                      */
+/*     DAGs             */
+/*                      */
 
-static
-void _heapify(graph_vertex **heap_array, hashTable *paths, int heap_size, int heap_pos)
+hashTable* singleSourceShortestPath_DAG(graph_t *graph, graph_vertex *source)
 {
-  int l = _left_pos(heap_pos);
-  int r = _right_pos(heap_pos);
-  int smallest = heap_pos;
-
-  int heap_pos_dist = hashTableSearchNode(paths, &heap_array[heap_pos]->id, keyConvertFromInt)->value;
-  if (l < heap_size) {
-    int l_dist = hashTableSearchNode(paths, &heap_array[l]->id, keyConvertFromInt)->value;
-    if (l_dist < heap_pos_dist) { smallest = l; }
+  graph_dense_t *dense = graphDenseBuild(graph->listSize);
+  uint32_t *order = (uint32_t*)malloc(sizeof(uint32_t) * (graph->numVertex ? graph->numVertex : 1));
+  if (!order) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
   }
-  int smallest_dist = hashTableSearchNode(paths, &heap_array[smallest]->id, keyConvertFromInt)->value;
-  if (r < heap_size) {
-    int r_dist = hashTableSearchNode(paths, &heap_array[r]->id, keyConvertFromInt)->value;
-    if (r_dist < smallest_dist) { smallest = r; }
+  unsigned int count = graphTopologicalOrder(graph, order);
+  dense->dist[source->id] = 0;
+  graphDenseMarkVisited(dense, source->id);
+
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int vertex = order[i];
+    GRAPH_STAT_ADD(vertices_visited, 1);
+    if (dense->dist[vertex] == INT_MAX) continue;      // its in-edges are all relaxed: unreachable
+
+    // relax all outgoing edges
+    adjacencyListNode_t *edge = graph->list[vertex];
+    while (edge) {
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (dense->dist[next] > dense->dist[vertex] + edge->weight) {
+	dense->dist[next] = dense->dist[vertex] + edge->weight;
+	GRAPH_STAT_ADD(relaxations, 1);
+	dense->pred[next] = vertex;
+	graphDenseMarkVisited(dense, next);
+      }
+      edge = edge->next;
+    }
   }
+  free(order);
+
+  hashTable *paths = graphDenseToHashTable(dense, graph);
+  graphDenseFree(dense);
+  return paths;
+}
+
 
-  if (smallest != heap_pos) {
-    // swap vertices position in heap
-    graph_vertex *tmp = heap_array[heap_pos];
-    heap_array[heap_pos] = heap_array[smallest];
-    heap_array[smallest] = tmp;
+/*                      */
+/*     Dijkstra         */
+/*                      */
+
+graph_dense_t* dijkstraDense(graph_t *graph, graph_vertex *source)
+{
+  graph_dense_t *paths = graphDenseBuild(graph->listSize);
+  indexedHeap heap;
+  indexedHeapInit(&heap, graph->listSize);
 
-    // swap vertices heap position struct property
-    int tmp1 = heap_array[heap_pos]->heap_pos;
-    heap_array[heap_pos]->heap_pos = heap_array[smallest]->heap_pos;
-    heap_array[smallest]->heap_pos = tmp1;
+  // vertices enter the heap when first discovered rather than all up front
+  paths->dist[source->id] = 0;
+  graphDenseMarkVisited(paths, source->id);
+  indexedHeapPush(&heap, source->id, 0);
 
-    _heapify(heap_array, paths, heap_size, smallest);
+  while (!indexedHeapIsEmpty(&heap)) {
+    unsigned int vertex = indexedHeapExtractMin(&heap).id;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+
+    adjacencyListNode_t *edge = graph->list[vertex];
+    while (edge) {
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (paths->dist[next] > paths->dist[vertex] + edge->weight) {
+	paths->dist[next] = paths->dist[vertex] + edge->weight;
+	GRAPH_STAT_ADD(relaxations, 1);
+	paths->pred[next] = vertex;
+	graphDenseMarkVisited(paths, next);
+	indexedHeapPush(&heap, next, paths->dist[next]);
+      }
+      edge = edge->next;
+    }
   }
+  indexedHeapDestroy(&heap);
+  return paths;
 }
 
-static
-void _heap_build(graph_t *graph, hashTable *paths, graph_vertex **heap_array)
+
+hashTable* singleSourceShortestPath_dijkstra(graph_t *graph, graph_vertex *source)
 {
-  // place each vertex in heap
-  graph_vertex *curr = graph->vertex_head;
-  u_int i = 0;
-  while (curr) {
-    heap_array[i] = curr;
-    curr->heap_pos = i;
-    curr = curr->next; i++;
+  graph_dense_t *dense = dijkstraDense(graph, source);
+  hashTable *paths = graphDenseToHashTable(dense, graph);
+  graphDenseFree(dense);
+  return paths;
+}
+
+
+/*                      */
+/*     Bellman-Ford     */
+/*                      */
+
+graph_dense_t* bellmanFordDense(graph_t *graph, graph_vertex *source)
+{
+  graph_dense_t *paths = graphDenseBuild(graph->listSize);
+  unsigned int size = graph->listSize;
+
+  // queue of vertices whose distance changed, a ring as no vertex is in it twice
+  unsigned int *queue  = (unsigned int*)malloc(sizeof(unsigned int) * (size ? size : 1));
+  unsigned int *length = (unsigned int*)calloc(size ? size : 1, sizeof(unsigned int));
+  bool         *queued = (bool*)calloc(size ? size : 1, sizeof(bool));
+  if (!queue || !length || !queued) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  unsigned int head = 0, count = 0;
+  bool negative_cycle = false;
+
+  paths->dist[source->id] = 0;
+  graphDenseMarkVisited(paths, source->id);
+  queue[0] = source->id;
+  queued[source->id] = true;
+  count = 1;
+
+  while (count && !negative_cycle) {
+    unsigned int vertex = queue[head];
+    head = (head + 1) % size;
+    count--;
+    queued[vertex] = false;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+
+    adjacencyListNode_t *edge = graph->list[vertex];
+    while (edge) {
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (paths->dist[next] > paths->dist[vertex] + edge->weight) {
+	paths->dist[next] = paths->dist[vertex] + edge->weight;
+	GRAPH_STAT_ADD(relaxations, 1);
+	paths->pred[next] = vertex;
+	graphDenseMarkVisited(paths, next);
+
+	// a path of numVertex edges goes around a cycle, which must be negative
+	length[next] = length[vertex] + 1;
+	if (length[next] >= graph->numVertex) { negative_cycle = true;  break; }
+	if (!queued[next]) {
+	  queue[(head + count) % size] = next;
+	  queued[next] = true;
+	  count++;
+	}
+      }
+      edge = edge->next;
+    }
   }
+  free(queue);
+  free(length);
+  free(queued);
 
-  // call heapify on top half (reverse order) of heap to establish invariant
-  for (int j = graph->numVertex / 2; j >= 0; j--) {
-    _heapify(heap_array, paths, graph->numVertex, j);
+  if (negative_cycle) {
+    graphDenseFree(paths);
+    return NULL;
   }
+  return paths;
 }
 
-static
-graph_vertex* _heap_extract_min(graph_vertex **heap_array, hashTable *paths, int heap_size)
+
+hashTable* singleSourceShortestPath_bellmanFord(graph_t *graph, graph_vertex *source)
 {
-  graph_vertex *min = heap_array[0];
-  heap_array[0] = heap_array[heap_size - 1];
-  heap_array[0]->heap_pos = 0;
-  _heapify(heap_array, paths, heap_size - 1, 0);
-  return min;
+  graph_dense_t *dense = bellmanFordDense(graph, source);
+  if (!dense) return hashTableBuild();        // negative cycle: empty table
+
+  hashTable *paths = graphDenseToHashTable(dense, graph);
+  graphDenseFree(dense);
+  return paths;
 }
 
+
+
+/*                      */
+/*   Point-to-Point     */
+/*                      */
+
+// builds the path ending at target by following pred back to a vertex with no predecessor.
+// when succ is given the path continues from target by following succ (bidirectional search).
 static
-void _heap_decrease_key(graph_vertex **heap_array, hashTable *paths, int heap_size, int heap_pos)
+graph_path_t* _build_path(int dist, unsigned int target, int *pred, int *succ)
 {
-  int vertex      = heap_array[heap_pos]->id;
-  int curr_dist   = hashTableSearchNode(paths, &vertex, keyConvertFromInt)->value;
-  int parent      = heap_array[_parent_pos(heap_pos)]->id;
-  int parent_dist = hashTableSearchNode(paths, &parent, keyConvertFromInt)->value;
-
-  while (parent_dist > curr_dist) {
-    _heapify(heap_array, paths, heap_size, _parent_pos(heap_pos));
-    heap_pos = _parent_pos(heap_pos);
-
-    vertex      = heap_array[heap_pos]->id;
-    curr_dist   = hashTableSearchNode(paths, &vertex, keyConvertFromInt)->value;
-    parent      = heap_array[_parent_pos(heap_pos)]->id;
-    parent_dist = hashTableSearchNode(paths, &parent, keyConvertFromInt)->value;
+  graph_path_t *path = (graph_path_t*)malloc(sizeof(*path));
+  if (!path) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
   }
+  path->dist = dist;
+  path->length = 0;
+  path->vertices = NULL;
+  if (dist == INT_MAX) return path;
+
+  unsigned int length = 1;
+  for (int v = pred[target]; v != -1; v = pred[v]) length++;
+  if (succ) { for (int v = succ[target]; v != -1; v = succ[v]) length++; }
+
+  path->vertices = (unsigned int*)malloc(sizeof(unsigned int) * length);
+  if (!path->vertices) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  path->length = length;
+
+  unsigned int i = 0;
+  for (int v = target; v != -1; v = pred[v]) i++;
+  unsigned int mid = i - 1;
+  for (int v = target; v != -1; v = pred[v]) path->vertices[--i] = v;
+  if (succ) {
+    i = mid + 1;
+    for (int v = succ[target]; v != -1; v = succ[v]) path->vertices[i++] = v;
+  }
+  return path;
 }
 
 
-/*                         */
-/*    helper functions     */
-/*                         */
-
-static
-void _free_linked_list(graph_vertex *head)
+graph_path_t* shortestPath_dijkstraTarget(graph_t *graph, graph_vertex *source, graph_vertex *target)
 {
-  while (head) {
-    graph_vertex *tmp = head;
-    head = head->next;
-    free(tmp);
+  int *dist = (int*)malloc(sizeof(int) * graph->listSize);
+  int *pred = (int*)malloc(sizeof(int) * graph->listSize);
+  if (!dist || !pred) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < graph->listSize; i++) { dist[i] = INT_MAX;  pred[i] = -1; }
+  indexedHeap heap;
+  indexedHeapInit(&heap, graph->listSize);
+
+  dist[source->id] = 0;
+  indexedHeapPush(&heap, source->id, 0);
+
+  while (!indexedHeapIsEmpty(&heap)) {
+    unsigned int vertex = indexedHeapExtractMin(&heap).id;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+    if (vertex == target->id) break;     // target's distance is now final
+
+    adjacencyListNode_t *edge = graph->list[vertex];
+    while (edge) {
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (dist[next] > dist[vertex] + edge->weight) {
+	dist[next] = dist[vertex] + edge->weight;
+	GRAPH_STAT_ADD(relaxations, 1);
+	pred[next] = vertex;
+	indexedHeapPush(&heap, next, dist[next]);
+      }
+      edge = edge->next;
+    }
   }
+
+  graph_path_t *path = _build_path(dist[target->id], target->id, pred, NULL);
+  indexedHeapDestroy(&heap);
+  free(dist);
+  free(pred);
+  return path;
 }
 
+
+// one side of the bi-directional search
+typedef struct search_side_t {
+  graph_t    *graph;
+  int        *dist;
+  int        *pred;
+  indexedHeap heap;
+} search_side_t;
+
 static
-hashTable* _single_source_initialize(graph_t *graph, graph_vertex *source)
+void _search_side_init(search_side_t *side, graph_t *graph, size_t size, unsigned int root)
 {
-  hashTable *forest = hashTableBuild();
-
-  graph_vertex *curr = graph->vertex_head;
-  while (curr) {
-    hashTableInsertNode(&forest, nodeHashTable_int(curr->id, INT_MAX, -1));
-    curr = curr->next;
+  side->graph = graph;
+  side->dist = (int*)malloc(sizeof(int) * size);
+  side->pred = (int*)malloc(sizeof(int) * size);
+  if (!side->dist || !side->pred) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
   }
-  hashTableInsertNode(&forest, nodeHashTable_int(source->id, 0, -1));
+  for (size_t i = 0; i < size; i++) { side->dist[i] = INT_MAX;  side->pred[i] = -1; }
+  indexedHeapInit(&side->heap, size);
 
-  return forest;
+  side->dist[root] = 0;
+  indexedHeapPush(&side->heap, root, 0);
 }
 
 static
-bool _relax_edge(int alt_path, adjacencyListNode_t *edge, hashTable **forest)
+void _search_side_destroy(search_side_t *side)
 {
-  int cur_path_dist = hashTableSearchNode( (*forest), &edge->vertex->id, keyConvertFromInt)->value;
-  int alt_path_dist = hashTableSearchNode( (*forest), &alt_path, keyConvertFromInt)->value;
+  free(side->dist);
+  free(side->pred);
+  indexedHeapDestroy(&side->heap);
+}
 
-  if (alt_path_dist != INT_MAX) {
-    if (cur_path_dist > alt_path_dist + edge->weight) {
-      hashTableInsertNode( &(*forest), nodeHashTable_int(edge->vertex->id, alt_path_dist + edge->weight, alt_path));
-      return true;
+// settles the minimum of side's heap, relaxing its edges; updates the best meeting point
+static
+void _search_side_step(search_side_t *side, search_side_t *other, long long *mu, int *meet)
+{
+  unsigned int vertex = indexedHeapExtractMin(&side->heap).id;
+  GRAPH_STAT_ADD(vertices_visited, 1);
+
+  adjacencyListNode_t *edge = side->graph->list[vertex];
+  while (edge) {
+    unsigned int next = edge->vertex->id;
+    GRAPH_STAT_ADD(edges_scanned, 1);
+    long long through = (long long)side->dist[vertex] + edge->weight;
+    if (side->dist[next] > through) {
+      side->dist[next] = through;
+      GRAPH_STAT_ADD(relaxations, 1);
+      side->pred[next] = vertex;
+      indexedHeapPush(&side->heap, next, side->dist[next]);
+    }
+    if (other->dist[next] != INT_MAX && through + other->dist[next] < *mu) {
+      *mu = through + other->dist[next];
+      *meet = next;
     }
+    edge = edge->next;
   }
-  return false;
 }
 
-void singleSourceShortestPath_print(hashTable *paths, int dest)
+
+graph_path_t* shortestPath_bidirectional(graph_t *graph, graph_t *transpose,
+					 graph_vertex *source, graph_vertex *target)
 {
-  if (hashTableIsEmpty(paths)) {
-    printf("A negative weighted cycle exists in the graph.");
-    printf(" Distances are undefined!\n");
+  size_t size = graph->listSize > transpose->listSize ? graph->listSize : transpose->listSize;
+  search_side_t forward, backward;
+  _search_side_init(&forward,  graph,     size, source->id);
+  _search_side_init(&backward, transpose, size, target->id);
+
+  long long mu = INT_MAX;
+  int meet = -1;
+  if (source->id == target->id) { mu = 0;  meet = source->id; }
+
+  while (!indexedHeapIsEmpty(&forward.heap) && !indexedHeapIsEmpty(&backward.heap)) {
+    int top_forward  = indexedHeapPeek(&forward.heap).key;
+    int top_backward = indexedHeapPeek(&backward.heap).key;
+    if ((long long)top_forward + top_backward >= mu) break;
+
+    if (top_forward <= top_backward) { _search_side_step(&forward, &backward, &mu, &meet); }
+    else                             { _search_side_step(&backward, &forward, &mu, &meet); }
   }
-  else if (hashTableSearchNode(paths, &dest, keyConvertFromInt)->value == INT_MAX) {
+
+  graph_path_t *path;
+  if (meet == -1) { path = _build_path(INT_MAX, target->id, forward.pred, NULL); }
+  else            { path = _build_path((int)mu, meet, forward.pred, backward.pred); }
+  _search_side_destroy(&forward);
+  _search_side_destroy(&backward);
+  return path;
+}
+
+
+void graphPathPrint(graph_path_t *path)
+{
+  if (path->dist == INT_MAX) {
     printf("Destination vertex is not reachable from source.\n");
+    return;
   }
-  else {
-    int parent = hashTableSearchNode(paths, &dest, keyConvertFromInt)->graph_predecessor;
-    if (parent == -1) {
-      printf("%d ", dest);
-    } else {
-      singleSourceShortestPath_print(paths, parent);
-      printf("%d ", dest);
-    }
+  printf("distance %d: ", path->dist);
+  for (unsigned int i = 0; i < path->length; i++) {
+    printf("%u ", path->vertices[i]);
   }
+  printf("\n");
+}
+
+
+void graphPathFree(graph_path_t *path)
+{
+  free(path->vertices);
+  free(path);
 }
 
 
 /*                      */
-/*     DAGs             */
+/*   Landmarks (ALT)    */
 /*                      */
 
-hashTable* singleSourceShortestPath_DAG(graph_t *graph, graph_vertex *source)
+static
+graph_landmarks_t* _landmarks_init(unsigned int count, unsigned int size)
 {
-  hashTable *paths = _single_source_initialize(graph, source);
-  graph_vertex *sorted_vertex = topologicalSort(graph);
+  graph_landmarks_t *new = (graph_landmarks_t*)malloc(sizeof(*new));
+  if (new) {
+    new->count = count;
+    new->size = size;
+    new->ids      = (unsigned int*)malloc(sizeof(unsigned int) * (count ? count : 1));
+    new->forward  = (int*)malloc(sizeof(int) * ((size_t)count * size + 1));
+    new->backward = (int*)malloc(sizeof(int) * ((size_t)count * size + 1));
+  }
+  if (!new || !new->ids || !new->forward || !new->backward) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
 
-  graph_vertex *vertex = sorted_vertex;
-  while (vertex) {
 
-    // relax all outgoing edges
-    adjacencyListNode_t *edge = graph->list[vertex->id];
-    while (edge) {
-      _relax_edge(vertex->id, edge, &paths);
-      edge = edge->next;
-    }
-    vertex = vertex->next;
+graph_landmarks_t* graphLandmarksBuild(graph_t *graph, graph_t *transpose, unsigned int count)
+{
+  if (count > graph->numVertex) count = graph->numVertex;
+  unsigned int size = graph->listSize;
+  graph_landmarks_t *landmarks = _landmarks_init(count, size);
+
+  // closest[v] is v's distance from the nearest landmark picked so far (either direction)
+  long long *closest = (long long*)malloc(sizeof(long long) * (size ? size : 1));
+  if (!closest) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
   }
+  for (size_t i = 0; i < size; i++) { closest[i] = LLONG_MAX; }
 
-  _free_linked_list(sorted_vertex);
-  return paths;
+  graph_vertex *pick = graph->vertex_head;
+  for (unsigned int l = 0; l < count; l++) {
+    landmarks->ids[l] = pick->id;
+
+    // the same vertex in the transpose is a different struct with the same id
+    graph_vertex  *pick_transpose = graphVertexById(transpose, pick->id);
+    graph_dense_t *from = dijkstraDense(graph, pick);
+    graph_dense_t *to   = dijkstraDense(transpose, pick_transpose);
+
+    for (size_t v = 0; v < size; v++) {
+      int forward  = v < from->size ? from->dist[v] : INT_MAX;
+      int backward = v < to->size   ? to->dist[v]   : INT_MAX;
+      landmarks->forward [(size_t)l * size + v] = forward;
+      landmarks->backward[(size_t)l * size + v] = backward;
+
+      int nearest = forward < backward ? forward : backward;
+      if (nearest != INT_MAX && nearest < closest[v]) closest[v] = nearest;
+    }
+    graphDenseFree(from);
+    graphDenseFree(to);
+
+    // next landmark: vertex farthest from all landmarks; unconnected ones first
+    graph_vertex *curr = graph->vertex_head;
+    pick = NULL;
+    while (curr) {
+      if (!pick || closest[curr->id] > closest[pick->id]) pick = curr;
+      curr = curr->next;
+    }
+  }
+  free(closest);
+  return landmarks;
 }
 
 
-/*                      */
-/*     Dijkstra         */
-/*                      */
+#define LANDMARK_FILE_MAGIC   0x4b4d4c47u   // "GLMK"
+#define LANDMARK_FILE_VERSION 1u
 
-hashTable* singleSourceShortestPath_dijkstra(graph_t *graph, graph_vertex *source)
+int graphLandmarksSave(graph_landmarks_t *landmarks, const char *path)
 {
-  hashTable *paths = _single_source_initialize(graph, source);
-  int heap_size = graph->numVertex;
-  graph_vertex *heap[heap_size];
-  _heap_build(graph, paths, heap);
+  FILE *file = fopen(path, "wb");
+  if (!file) { perror("fopen");  return 1; }
+
+  size_t entries = (size_t)landmarks->count * landmarks->size;
+  uint32_t header[4] = { LANDMARK_FILE_MAGIC, LANDMARK_FILE_VERSION, landmarks->count, landmarks->size };
+  int failed = fwrite(header, sizeof(header), 1, file) != 1
+    || fwrite(landmarks->ids,      sizeof(unsigned int), landmarks->count, file) != landmarks->count
+    || fwrite(landmarks->forward,  sizeof(int), entries, file) != entries
+    || fwrite(landmarks->backward, sizeof(int), entries, file) != entries;
+  if (fclose(file) != 0) failed = 1;
+  return failed;
+}
 
-  while (heap_size > 0) {
-    graph_vertex *vertex = _heap_extract_min(heap, paths, heap_size);
-    heap_size--;
 
-    adjacencyListNode_t *edge = graph->list[vertex->id];
-    while (edge) {
-      bool relaxed = _relax_edge(vertex->id, edge, &paths);
-      if (relaxed) {
-	_heap_decrease_key(heap, paths, heap_size, edge->vertex->heap_pos);
-      }
-      edge = edge->next;
-    }
+graph_landmarks_t* graphLandmarksLoad(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (!file) { perror("fopen");  return NULL; }
+
+  uint32_t header[4];
+  if (fread(header, sizeof(header), 1, file) != 1
+      || header[0] != LANDMARK_FILE_MAGIC || header[1] != LANDMARK_FILE_VERSION) {
+    fprintf(stderr, "%s: not a landmark file of a supported version\n", path);
+    fclose(file);
+    return NULL;
   }
-  return paths;
+
+  // the header's sizes must add up to the size of the file, before they are allocated
+  uint64_t entries = (uint64_t)header[2] * header[3];
+  uint64_t expected = sizeof(header) + (uint64_t)header[2] * sizeof(uint32_t);
+  off_t length = -1;
+  if (fseeko(file, 0, SEEK_END) == 0) length = ftello(file);
+  if (entries > (UINT64_MAX - expected) / (2 * sizeof(int))
+      || length < 0 || (uint64_t)length != expected + entries * 2 * sizeof(int)
+      || fseeko(file, sizeof(header), SEEK_SET) != 0) {
+    fprintf(stderr, "%s: landmark file is truncated or corrupt\n", path);
+    fclose(file);
+    return NULL;
+  }
+
+  graph_landmarks_t *landmarks = _landmarks_init(header[2], header[3]);
+  if (fread(landmarks->ids,      sizeof(unsigned int), landmarks->count, file) != landmarks->count
+      || fread(landmarks->forward,  sizeof(int), entries, file) != entries
+      || fread(landmarks->backward, sizeof(int), entries, file) != entries) {
+    fprintf(stderr, "%s: landmark file is truncated\n", path);
+    graphLandmarksFree(landmarks);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  return landmarks;
 }
 
 
-/*                      */
-/*     Bellman-Ford     */
-/*                      */
+void graphLandmarksFree(graph_landmarks_t *landmarks)
+{
+  free(landmarks->ids);
+  free(landmarks->forward);
+  free(landmarks->backward);
+  free(landmarks);
+}
 
-hashTable* singleSourceShortestPath_bellmanFord(graph_t *graph, graph_vertex *source)
+
+// lower bound on dist(vertex, target) from the triangle inequality over every landmark
+static
+int _landmark_potential(graph_landmarks_t *landmarks, unsigned int vertex, unsigned int target)
 {
-  hashTable *paths = _single_source_initialize(graph, source);
-
-  // relax all edges in graph as many times as there are vertices in graph (minus 1)
-  for (size_t i = 0; i < graph->numVertex - 1; i++) {
-    graph_vertex *vertex = graph->vertex_head;
-    while (vertex) {
-      adjacencyListNode_t *edge = graph->list[vertex->id];
-      while (edge) {
-	_relax_edge(vertex->id, edge, &paths);
-	edge = edge->next;
-      }
-      vertex = vertex->next;
+  if (vertex >= landmarks->size || target >= landmarks->size) return 0;
+
+  long long best = 0;
+  for (unsigned int l = 0; l < landmarks->count; l++) {
+    int *forward  = landmarks->forward  + (size_t)l * landmarks->size;
+    int *backward = landmarks->backward + (size_t)l * landmarks->size;
+
+    // dist(v,t) >= dist(v,L) - dist(t,L)
+    if (backward[vertex] != INT_MAX && backward[target] != INT_MAX
+	&& (long long)backward[vertex] - backward[target] > best) {
+      best = (long long)backward[vertex] - backward[target];
+    }
+    // dist(v,t) >= dist(L,t) - dist(L,v)
+    if (forward[vertex] != INT_MAX && forward[target] != INT_MAX
+	&& (long long)forward[target] - forward[vertex] > best) {
+      best = (long long)forward[target] - forward[vertex];
     }
   }
-  // identify negative cycles in graph by relaxing all edges again
-  graph_vertex *vertex = graph->vertex_head;
-  while (vertex) {
-    adjacencyListNode_t *edge = graph->list[vertex->id];
+  return best;
+}
+
+
+graph_path_t* shortestPath_ALT(graph_t *graph, graph_landmarks_t *landmarks,
+			       graph_vertex *source, graph_vertex *target)
+{
+  int *dist      = (int*)malloc(sizeof(int) * graph->listSize);
+  int *pred      = (int*)malloc(sizeof(int) * graph->listSize);
+  int *potential = (int*)malloc(sizeof(int) * graph->listSize);
+  if (!dist || !pred || !potential) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < graph->listSize; i++) { dist[i] = INT_MAX;  pred[i] = -1;  potential[i] = -1; }
+  indexedHeap heap;
+  indexedHeapInit(&heap, graph->listSize);
+
+  // heap key is distance so far plus the lower bound on the distance that remains
+  dist[source->id] = 0;
+  potential[source->id] = _landmark_potential(landmarks, source->id, target->id);
+  indexedHeapPush(&heap, source->id, potential[source->id]);
+
+  while (!indexedHeapIsEmpty(&heap)) {
+    unsigned int vertex = indexedHeapExtractMin(&heap).id;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+    if (vertex == target->id) break;
+
+    adjacencyListNode_t *edge = graph->list[vertex];
     while (edge) {
-      bool relaxed = _relax_edge(vertex->id, edge, &paths);
-      if (relaxed) {
-	hashTableEmpty(&paths);
-	return paths;
+      unsigned int next = edge->vertex->id;
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (dist[next] > dist[vertex] + edge->weight) {
+	dist[next] = dist[vertex] + edge->weight;
+	GRAPH_STAT_ADD(relaxations, 1);
+	pred[next] = vertex;
+	if (potential[next] == -1) {
+	  potential[next] = _landmark_potential(landmarks, next, target->id);
+	}
+	long long key = (long long)dist[next] + potential[next];
+	indexedHeapPush(&heap, next, key > INT_MAX ? INT_MAX : (int)key);
       }
       edge = edge->next;
     }
-    vertex = vertex->next;
   }
-  return paths;
-}
 
+  graph_path_t *path = _build_path(dist[target->id], target->id, pred, NULL);
+  indexedHeapDestroy(&heap);
+  free(dist);
+  free(pred);
+  free(potential);
+  return path;
+}
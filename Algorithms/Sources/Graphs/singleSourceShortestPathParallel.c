@@ -0,0 +1,719 @@
+/*
+  Parallel Single-Source Shortest Paths: Delta-Stepping (Meyer and Sanders, 2003)
+  Dijkstra's algorithm settles one vertex at a time, always the one nearest to the source, and
+  so leaves nothing for a second thread to do. Bellman-Ford relaxes every edge at once, which
+  parallelizes well, but may relax each edge many times over. Delta-stepping sits in between.
+
+  Vertices that have been reached are kept in buckets by distance: bucket i holds the vertices
+  with a distance in [i * delta, (i+1) * delta). The lowest non-empty bucket is emptied and all
+  its vertices have their out-edges relaxed at the same time, spread over the threads. Relaxing
+  an edge may put its destination in a later bucket, or back into the current one (an edge
+  lighter than delta); the current bucket is emptied again and again until it stays empty.
+  Only then are the distances within it final, and the search moves on to the next bucket.
+  With delta = 1 (and integer weights) this is Dijkstra, one distance at a time. With delta at
+  infinity it is Bellman-Ford, a single bucket holding everything. In between, the larger delta
+  the more work each bucket offers the threads, but the more often a vertex is relaxed before
+  its distance is final. The average edge weight is a good start, and is the default.
+  Weights must not be negative: a bucket must never receive a vertex closer than its own.
+
+  Concurrency:
+  Several threads may improve the distance of the same vertex at the same time. A vertex's
+  distance and predecessor are packed into one 64 bit word (distance in the high half) and
+  updated together by compare-and-swap, only ever to a smaller distance. The thread whose swap
+  succeeds puts the vertex in a bucket of its own: each thread has its own array of buckets,
+  so adding to one needs no lock. Between rounds the calling thread (the leader), alone, takes
+  the lowest non-empty bucket of every thread; the threads then claim chunks of these as work.
+  A vertex may sit in a bucket it no longer belongs to, once a later relaxation has moved it to
+  a lower one. It is skipped when met there. (The edges of vertices in the same bucket are all
+  relaxed in the same way; the original algorithm relaxes heavy edges only once per bucket.)
+
+  Running time: O(V + E + L/delta) work for random weights, L being the largest distance.
+
+  Batches of sources:
+  When distances are needed from many sources (all of them, for all-pairs on a small graph),
+  there is more to be gained by running whole searches side by side than by splitting any one
+  of them. singleSourceShortestPath_batch gives each thread one heap, its workspace, that it
+  reuses for every source it claims; a search ends with its heap empty, so nothing needs to be
+  reset in between. Distances are written straight into the caller's matrix, one row per
+  source, so no memory at all is allocated per source. Each search is Dijkstra's algorithm.
+  Running time: O(n E lg V) work for n sources, shared by the threads.
+
+  DAG wavefronts:
+  In a DAG the vertices fall into levels: level 0 holds the vertices without in-edges, level
+  i + 1 those whose in-edges all come from levels up to i, at least one from level i. No edge
+  joins two vertices of the same level, so once the levels before are done, the distances of
+  a whole level are final, and the out-edges of all its vertices can be relaxed at once.
+  graphCSRTopologicalLevels finds the levels by Kahn's algorithm, one level per round: the
+  threads claim chunks of the current level and take one off the in-degree of every target,
+  with an atomic decrement; the thread that brings it to 0 adds the target to its own list
+  for the next level, and the leader joins the lists between rounds. The in-degrees are
+  counted the same way, by all threads, in a first round.
+  singleSourceShortestPath_DAGParallel then relaxes the levels in turn, from the source's,
+  with a barrier in between. As in delta-stepping, distance and predecessor are packed in one
+  word and lowered by compare-and-swap; the predecessor takes part in the comparison, so that
+  of equal distances the smallest predecessor wins, whatever the timing. Longest paths are
+  shortest paths with the weights negated, which is safe as a DAG has no cycle to go round.
+  The work is O(V + E); the threads only help when the levels are wide, as they are in build
+  dependency graphs and project schedules, and not at all in a single long chain.
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../../Headers/graph.h"
+#include "../../Headers/indexedHeap.h"
+
+
+/*                      */
+/*    Delta-Stepping    */
+/*                      */
+
+#define SSSP_CHUNK   64                  // bucket entries claimed by a thread at a time
+#define SSSP_NONE    UINT32_MAX          // packed predecessor of a vertex that has none
+#define SSSP_INFINITY ((uint64_t)INT_MAX)
+
+
+/* A bucket: ids of vertices, possibly already moved to a lower bucket */
+typedef struct sssp_bucket_t {
+  uint32_t *items;
+  size_t    size;
+  size_t    capacity;
+} sssp_bucket_t;
+
+/* The buckets of one thread. Only that thread adds to them, except for the
+ * leader between rounds, while every other thread waits at the barrier.
+ */
+typedef struct sssp_local_t {
+  sssp_bucket_t *buckets;
+  size_t         num_buckets;
+  size_t         lowest;         // buckets below this one are empty
+  sssp_bucket_t  taken;          // bucket being relaxed this round
+} sssp_local_t;
+
+typedef struct sssp_shared_t {
+  graph_csr_t   *csr;
+  uint64_t      *state;          // distance << 32 | predecessor, of every vertex
+  uint64_t       delta;
+  unsigned int   threads;
+  sssp_local_t  *locals;
+  pthread_barrier_t barrier;
+  bool           done;
+  size_t         bucket;         // index of bucket being relaxed
+  size_t        *offsets;        // threads + 1: start of each thread's taken bucket in the round
+  size_t         claim;          // start of the next piece of work to be claimed
+} sssp_shared_t;
+
+typedef struct sssp_worker_t {
+  sssp_shared_t *shared;
+  unsigned int   index;
+} sssp_worker_t;
+
+
+static
+void* _sssp_malloc(size_t size)
+{
+  void *new = malloc(size ? size : 1);
+  if (!new) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  return new;
+}
+
+static
+void _sssp_bucket_push(sssp_bucket_t *bucket, uint32_t id)
+{
+  if (bucket->size == bucket->capacity) {
+    bucket->capacity = bucket->capacity ? bucket->capacity * 2 : 16;
+    bucket->items = (uint32_t*)realloc(bucket->items, sizeof(uint32_t) * bucket->capacity);
+    if (!bucket->items) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+  }
+  bucket->items[bucket->size++] = id;
+}
+
+static
+void _sssp_local_push(sssp_local_t *local, size_t index, uint32_t id)
+{
+  if (index >= local->num_buckets) {
+    size_t num = local->num_buckets ? local->num_buckets * 2 : 64;
+    if (num <= index) num = index + 1;
+    local->buckets = (sssp_bucket_t*)realloc(local->buckets, sizeof(sssp_bucket_t) * num);
+    if (!local->buckets) {
+      perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+    }
+    memset(local->buckets + local->num_buckets, 0, sizeof(sssp_bucket_t) * (num - local->num_buckets));
+    local->num_buckets = num;
+  }
+  _sssp_bucket_push(&local->buckets[index], id);
+  if (index < local->lowest) local->lowest = index;
+}
+
+
+// relaxes the out-edges of a vertex taken from the current bucket
+static
+void _sssp_relax(sssp_shared_t *shared, sssp_local_t *local, uint32_t vertex)
+{
+  graph_csr_t *csr = shared->csr;
+  uint64_t dist = __atomic_load_n(&shared->state[vertex], __ATOMIC_RELAXED) >> 32;
+  if (dist / shared->delta != shared->bucket) return;     // moved to a lower bucket since
+  GRAPH_STAT_ADD(vertices_visited, 1);
+
+  for (uint64_t e = csr->offsets[vertex]; e < csr->offsets[vertex + 1]; e++) {
+    uint32_t next = csr->targets[e];
+    GRAPH_STAT_ADD(edges_scanned, 1);
+    uint64_t alt  = dist + (uint64_t)csr->weights[e];
+    if (alt >= SSSP_INFINITY) continue;
+
+    uint64_t packed = alt << 32 | vertex;
+    uint64_t old = __atomic_load_n(&shared->state[next], __ATOMIC_RELAXED);
+    while ((old >> 32) > alt) {
+      if (__atomic_compare_exchange_n(&shared->state[next], &old, packed, true,
+				      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	GRAPH_STAT_ADD(relaxations, 1);
+	_sssp_local_push(local, alt / shared->delta, next);
+	break;
+      }
+    }
+  }
+}
+
+
+static
+void _sssp_step(sssp_shared_t *shared, sssp_local_t *local)
+{
+  size_t total = shared->offsets[shared->threads];
+  unsigned int owner = 0;
+
+  for (;;) {
+    size_t begin = __atomic_fetch_add(&shared->claim, SSSP_CHUNK, __ATOMIC_RELAXED);
+    if (begin >= total) break;
+    size_t end = begin + SSSP_CHUNK < total ? begin + SSSP_CHUNK : total;
+
+    // the chunk may span the taken buckets of several threads
+    for (size_t i = begin; i < end; i++) {
+      while (i >= shared->offsets[owner + 1]) owner++;
+      _sssp_relax(shared, local, shared->locals[owner].taken.items[i - shared->offsets[owner]]);
+    }
+  }
+}
+
+
+// leader only: takes the lowest non-empty bucket of every thread as the next round's work
+static
+void _sssp_next_bucket(sssp_shared_t *shared)
+{
+  size_t next = SIZE_MAX;
+  for (unsigned int t = 0; t < shared->threads; t++) {
+    sssp_local_t *local = &shared->locals[t];
+    while (local->lowest < local->num_buckets && local->buckets[local->lowest].size == 0) local->lowest++;
+    if (local->lowest < local->num_buckets && local->lowest < next) next = local->lowest;
+  }
+  if (next == SIZE_MAX) { shared->done = true;  return; }
+
+  size_t total = 0;
+  for (unsigned int t = 0; t < shared->threads; t++) {
+    sssp_local_t *local = &shared->locals[t];
+    shared->offsets[t] = total;
+    local->taken.size = 0;
+    if (next < local->num_buckets) {
+      // swap, so the bucket keeps the memory of the one taken last round
+      sssp_bucket_t tmp = local->taken;
+      local->taken = local->buckets[next];
+      local->buckets[next] = tmp;
+    }
+    total += local->taken.size;
+  }
+  shared->offsets[shared->threads] = total;
+  shared->bucket = next;
+  shared->claim  = 0;
+}
+
+
+static
+void _sssp_run(sssp_shared_t *shared, unsigned int index)
+{
+  for (;;) {
+    pthread_barrier_wait(&shared->barrier);      // round starts
+    if (shared->done) return;
+    _sssp_step(shared, &shared->locals[index]);
+    pthread_barrier_wait(&shared->barrier);      // round ends
+    if (index == 0) _sssp_next_bucket(shared);
+  }
+}
+
+static
+void* _sssp_worker(void *worker)
+{
+  _sssp_run(((sssp_worker_t*)worker)->shared, ((sssp_worker_t*)worker)->index);
+  return NULL;
+}
+
+
+graph_dense_t* singleSourceShortestPath_deltaStepping(graph_csr_t *csr, unsigned int source,
+						       int delta, unsigned int threads)
+{
+  graph_dense_t *result = graphDenseBuild(csr->listSize);
+  if (source >= csr->listSize) return result;
+
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+  if (delta <= 0) {
+    uint64_t sum = 0;
+    for (uint64_t e = 0; e < csr->numEdge; e++) { sum += csr->weights[e]; }
+    delta = csr->numEdge && sum / csr->numEdge ? sum / csr->numEdge : 1;
+  }
+
+  sssp_shared_t shared;
+  memset(&shared, 0, sizeof(shared));
+  shared.csr     = csr;
+  shared.delta   = delta;
+  shared.threads = threads;
+  shared.state   = (uint64_t*)_sssp_malloc(sizeof(uint64_t) * csr->listSize);
+  shared.locals  = (sssp_local_t*)calloc(threads, sizeof(sssp_local_t));
+  shared.offsets = (size_t*)_sssp_malloc(sizeof(size_t) * (threads + 1));
+  if (!shared.locals) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < csr->listSize; i++) { shared.state[i] = SSSP_INFINITY << 32 | SSSP_NONE; }
+
+  shared.state[source] = SSSP_NONE;              // distance 0
+  _sssp_local_push(&shared.locals[0], 0, source);
+  _sssp_next_bucket(&shared);
+
+  pthread_barrier_init(&shared.barrier, NULL, threads);
+  pthread_t     *workers = (pthread_t*)_sssp_malloc(sizeof(pthread_t) * threads);
+  sssp_worker_t *args    = (sssp_worker_t*)_sssp_malloc(sizeof(sssp_worker_t) * threads);
+  for (unsigned int t = 1; t < threads; t++) {
+    args[t].shared = &shared;
+    args[t].index  = t;
+    if (pthread_create(&workers[t], NULL, _sssp_worker, &args[t])) {
+      perror("pthread_create");  exit(EXIT_FAILURE);
+    }
+  }
+  _sssp_run(&shared, 0);
+  for (unsigned int t = 1; t < threads; t++) { pthread_join(workers[t], NULL); }
+  pthread_barrier_destroy(&shared.barrier);
+
+  for (size_t i = 0; i < csr->listSize; i++) {
+    uint64_t dist = shared.state[i] >> 32;
+    if (dist == SSSP_INFINITY) continue;
+    uint32_t pred = (uint32_t)shared.state[i];
+    result->dist[i] = (int)dist;
+    result->pred[i] = pred == SSSP_NONE ? -1 : (int)pred;
+    graphDenseMarkVisited(result, i);
+  }
+
+  for (unsigned int t = 0; t < threads; t++) {
+    for (size_t b = 0; b < shared.locals[t].num_buckets; b++) { free(shared.locals[t].buckets[b].items); }
+    free(shared.locals[t].buckets);
+    free(shared.locals[t].taken.items);
+  }
+  free(shared.locals);
+  free(shared.offsets);
+  free(shared.state);
+  free(workers);
+  free(args);
+  return result;
+}
+
+
+
+/*                      */
+/*    Batch Dijkstra    */
+/*                      */
+
+typedef struct sssp_batch_t {
+  graph_csr_t        *csr;
+  const unsigned int *sources;   // NULL: row i is source i
+  size_t              num_sources;
+  int                *matrix;
+  size_t              claim;     // next row to be claimed
+} sssp_batch_t;
+
+
+// one row of the matrix: Dijkstra from source, with a heap that is empty before and after
+static
+void _sssp_batch_row(graph_csr_t *csr, unsigned int source, int *dist, indexedHeap *heap)
+{
+  for (size_t i = 0; i < csr->listSize; i++) { dist[i] = INT_MAX; }
+  if (source >= csr->listSize) return;
+
+  dist[source] = 0;
+  indexedHeapPush(heap, source, 0);
+
+  while (!indexedHeapIsEmpty(heap)) {
+    uint32_t vertex = indexedHeapExtractMin(heap).id;
+    GRAPH_STAT_ADD(vertices_visited, 1);
+
+    for (uint64_t e = csr->offsets[vertex]; e < csr->offsets[vertex + 1]; e++) {
+      uint32_t next = csr->targets[e];
+      GRAPH_STAT_ADD(edges_scanned, 1);
+      if (dist[next] > dist[vertex] + csr->weights[e]) {
+	dist[next] = dist[vertex] + csr->weights[e];
+	GRAPH_STAT_ADD(relaxations, 1);
+	indexedHeapPush(heap, next, dist[next]);
+      }
+    }
+  }
+}
+
+static
+void* _sssp_batch_worker(void *arg)
+{
+  sssp_batch_t *batch = (sssp_batch_t*)arg;
+  graph_csr_t  *csr = batch->csr;
+  indexedHeap heap;
+  indexedHeapInit(&heap, csr->listSize);
+
+  for (;;) {
+    size_t row = __atomic_fetch_add(&batch->claim, 1, __ATOMIC_RELAXED);
+    if (row >= batch->num_sources) break;
+    unsigned int source = batch->sources ? batch->sources[row] : row;
+    _sssp_batch_row(csr, source, batch->matrix + row * csr->listSize, &heap);
+  }
+  indexedHeapDestroy(&heap);
+  return NULL;
+}
+
+
+void singleSourceShortestPath_batch(graph_csr_t *csr, const unsigned int *sources, size_t num_sources,
+				    unsigned int threads, int *matrix)
+{
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+  if (threads > num_sources) threads = num_sources ? num_sources : 1;
+
+  sssp_batch_t batch;
+  batch.csr         = csr;
+  batch.sources     = sources;
+  batch.num_sources = num_sources;
+  batch.matrix      = matrix;
+  batch.claim       = 0;
+
+  pthread_t *workers = (pthread_t*)_sssp_malloc(sizeof(pthread_t) * threads);
+  for (unsigned int t = 1; t < threads; t++) {
+    if (pthread_create(&workers[t], NULL, _sssp_batch_worker, &batch)) {
+      perror("pthread_create");  exit(EXIT_FAILURE);
+    }
+  }
+  _sssp_batch_worker(&batch);
+  for (unsigned int t = 1; t < threads; t++) { pthread_join(workers[t], NULL); }
+  free(workers);
+}
+
+
+
+/*                      */
+/*    DAG Wavefronts    */
+/*                      */
+
+enum { LEVELS_COUNT, LEVELS_SEED, LEVELS_PEEL };
+
+typedef struct sssp_levels_t {
+  graph_csr_t      *csr;
+  graph_levels_t   *levels;
+  uint32_t         *degree;      // listSize: in-edges not yet taken off
+  unsigned int      threads;
+  sssp_bucket_t    *found;       // threads: vertices each thread found for the next level
+  pthread_barrier_t barrier;
+  int               phase;
+  size_t            begin;       // the round's work: ids, members or members of a level
+  size_t            end;
+  size_t            claim;       // start of the next chunk, relative to begin
+  bool              done;
+} sssp_levels_t;
+
+typedef struct sssp_levels_worker_t {
+  sssp_levels_t *shared;
+  unsigned int   index;
+} sssp_levels_worker_t;
+
+
+static
+void _sssp_levels_step(sssp_levels_t *shared, sssp_bucket_t *found)
+{
+  graph_csr_t *csr = shared->csr;
+  size_t total = shared->end - shared->begin;
+
+  for (;;) {
+    size_t begin = __atomic_fetch_add(&shared->claim, SSSP_CHUNK, __ATOMIC_RELAXED);
+    if (begin >= total) break;
+    size_t end = begin + SSSP_CHUNK < total ? begin + SSSP_CHUNK : total;
+
+    for (size_t i = shared->begin + begin; i < shared->begin + end; i++) {
+      switch (shared->phase) {
+      case LEVELS_COUNT:
+	for (uint64_t e = csr->offsets[i]; e < csr->offsets[i + 1]; e++) {
+	  __atomic_fetch_add(&shared->degree[csr->targets[e]], 1, __ATOMIC_RELAXED);
+	}
+	break;
+      case LEVELS_SEED:
+	if (shared->degree[csr->vertex_ids[i]] == 0) _sssp_bucket_push(found, csr->vertex_ids[i]);
+	break;
+      case LEVELS_PEEL: {
+	uint32_t vertex = shared->levels->order[i];
+	GRAPH_STAT_ADD(vertices_visited, 1);
+	for (uint64_t e = csr->offsets[vertex]; e < csr->offsets[vertex + 1]; e++) {
+	  GRAPH_STAT_ADD(edges_scanned, 1);
+	  if (__atomic_sub_fetch(&shared->degree[csr->targets[e]], 1, __ATOMIC_RELAXED) == 0) {
+	    _sssp_bucket_push(found, csr->targets[e]);
+	  }
+	}
+	break;
+      }
+      }
+    }
+  }
+}
+
+
+// leader only: appends the vertices found in the round as the next level
+static
+void _sssp_levels_next(sssp_levels_t *shared)
+{
+  graph_levels_t *levels = shared->levels;
+  shared->claim = 0;
+  if (shared->phase == LEVELS_COUNT) {
+    shared->phase = LEVELS_SEED;
+    shared->begin = 0;
+    shared->end   = shared->csr->numVertex;
+    return;
+  }
+
+  size_t start = levels->count;
+  for (unsigned int t = 0; t < shared->threads; t++) {
+    if (shared->found[t].size == 0) continue;
+    memcpy(levels->order + levels->count, shared->found[t].items, sizeof(uint32_t) * shared->found[t].size);
+    levels->count += shared->found[t].size;
+    shared->found[t].size = 0;
+  }
+  if (levels->count == start) { shared->done = true;  return; }
+
+  levels->offsets[++levels->numLevels] = levels->count;
+  shared->phase = LEVELS_PEEL;
+  shared->begin = start;
+  shared->end   = levels->count;
+}
+
+
+static
+void _sssp_levels_run(sssp_levels_t *shared, unsigned int index)
+{
+  for (;;) {
+    pthread_barrier_wait(&shared->barrier);      // round starts
+    if (shared->done) return;
+    _sssp_levels_step(shared, &shared->found[index]);
+    pthread_barrier_wait(&shared->barrier);      // round ends
+    if (index == 0) _sssp_levels_next(shared);
+  }
+}
+
+static
+void* _sssp_levels_worker(void *worker)
+{
+  _sssp_levels_run(((sssp_levels_worker_t*)worker)->shared, ((sssp_levels_worker_t*)worker)->index);
+  return NULL;
+}
+
+
+graph_levels_t* graphCSRTopologicalLevels(graph_csr_t *csr, unsigned int threads)
+{
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+
+  graph_levels_t *levels = (graph_levels_t*)_sssp_malloc(sizeof(graph_levels_t));
+  levels->count     = 0;
+  levels->numLevels = 0;
+  levels->order     = (uint32_t*)_sssp_malloc(sizeof(uint32_t) * csr->numVertex);
+  levels->offsets   = (uint32_t*)_sssp_malloc(sizeof(uint32_t) * (csr->numVertex + 1));
+  levels->offsets[0] = 0;
+
+  sssp_levels_t shared;
+  memset(&shared, 0, sizeof(shared));
+  shared.csr     = csr;
+  shared.levels  = levels;
+  shared.threads = threads;
+  shared.degree  = (uint32_t*)calloc(csr->listSize ? csr->listSize : 1, sizeof(uint32_t));
+  shared.found   = (sssp_bucket_t*)calloc(threads, sizeof(sssp_bucket_t));
+  if (!shared.degree || !shared.found) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  shared.phase = LEVELS_COUNT;
+  shared.begin = 0;
+  shared.end   = csr->listSize;
+
+  pthread_barrier_init(&shared.barrier, NULL, threads);
+  pthread_t            *workers = (pthread_t*)_sssp_malloc(sizeof(pthread_t) * threads);
+  sssp_levels_worker_t *args    = (sssp_levels_worker_t*)_sssp_malloc(sizeof(sssp_levels_worker_t) * threads);
+  for (unsigned int t = 1; t < threads; t++) {
+    args[t].shared = &shared;
+    args[t].index  = t;
+    if (pthread_create(&workers[t], NULL, _sssp_levels_worker, &args[t])) {
+      perror("pthread_create");  exit(EXIT_FAILURE);
+    }
+  }
+  _sssp_levels_run(&shared, 0);
+  for (unsigned int t = 1; t < threads; t++) { pthread_join(workers[t], NULL); }
+  pthread_barrier_destroy(&shared.barrier);
+
+  for (unsigned int t = 0; t < threads; t++) { free(shared.found[t].items); }
+  free(shared.found);
+  free(shared.degree);
+  free(workers);
+  free(args);
+  return levels;
+}
+
+
+void graphLevelsFree(graph_levels_t *levels)
+{
+  free(levels->order);
+  free(levels->offsets);
+  free(levels);
+}
+
+
+#define SSSP_DAG_BIAS      (INT64_C(1) << 31)   // added to distances, to order them as unsigned
+#define SSSP_DAG_UNREACHED ((uint64_t)UINT32_MAX)
+
+typedef struct sssp_dag_t {
+  graph_csr_t      *csr;
+  graph_levels_t   *levels;
+  uint64_t         *state;       // (distance + bias) << 32 | predecessor, of every vertex
+  bool              longest;
+  unsigned int      first;       // level of the source
+  size_t           *claims;      // numLevels: start of the next chunk of each level
+  pthread_barrier_t barrier;
+} sssp_dag_t;
+
+
+// relaxes the out-edges of a vertex of the current level; its distance is final
+static
+void _sssp_dag_relax(sssp_dag_t *shared, uint32_t vertex)
+{
+  graph_csr_t *csr = shared->csr;
+  uint64_t key = __atomic_load_n(&shared->state[vertex], __ATOMIC_RELAXED) >> 32;
+  if (key == SSSP_DAG_UNREACHED) return;
+  int64_t dist = (int64_t)key - SSSP_DAG_BIAS;
+  GRAPH_STAT_ADD(vertices_visited, 1);
+
+  for (uint64_t e = csr->offsets[vertex]; e < csr->offsets[vertex + 1]; e++) {
+    uint32_t next = csr->targets[e];
+    GRAPH_STAT_ADD(edges_scanned, 1);
+    int64_t alt = shared->longest ? dist - csr->weights[e] : dist + csr->weights[e];
+    if (alt >= INT_MAX || alt <= INT_MIN) continue;     // the distance would not fit an int
+
+    uint64_t packed = (uint64_t)(alt + SSSP_DAG_BIAS) << 32 | vertex;
+    uint64_t old = __atomic_load_n(&shared->state[next], __ATOMIC_RELAXED);
+    while (old > packed) {
+      if (__atomic_compare_exchange_n(&shared->state[next], &old, packed, true,
+				      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	GRAPH_STAT_ADD(relaxations, 1);
+	break;
+      }
+    }
+  }
+}
+
+static
+void _sssp_dag_run(sssp_dag_t *shared)
+{
+  graph_levels_t *levels = shared->levels;
+
+  for (unsigned int l = shared->first; l < levels->numLevels; l++) {
+    size_t total = levels->offsets[l + 1] - levels->offsets[l];
+    for (;;) {
+      size_t begin = __atomic_fetch_add(&shared->claims[l], SSSP_CHUNK, __ATOMIC_RELAXED);
+      if (begin >= total) break;
+      size_t end = begin + SSSP_CHUNK < total ? begin + SSSP_CHUNK : total;
+      for (size_t i = levels->offsets[l] + begin; i < levels->offsets[l] + end; i++) {
+	_sssp_dag_relax(shared, levels->order[i]);
+      }
+    }
+    pthread_barrier_wait(&shared->barrier);      // level done: the next one's distances are final
+  }
+}
+
+static
+void* _sssp_dag_worker(void *shared)
+{
+  _sssp_dag_run((sssp_dag_t*)shared);
+  return NULL;
+}
+
+
+graph_dense_t* singleSourceShortestPath_DAGParallel(graph_csr_t *csr, graph_levels_t *levels,
+						     unsigned int source, bool longest, unsigned int threads)
+{
+  graph_dense_t *result = graphDenseBuild(csr->listSize);
+  if (source >= csr->listSize) return result;
+
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+  graph_levels_t *own = levels ? NULL : graphCSRTopologicalLevels(csr, threads);
+  if (own) levels = own;
+
+  sssp_dag_t shared;
+  memset(&shared, 0, sizeof(shared));
+  shared.csr     = csr;
+  shared.levels  = levels;
+  shared.longest = longest;
+  shared.state   = (uint64_t*)_sssp_malloc(sizeof(uint64_t) * csr->listSize);
+  shared.claims  = (size_t*)calloc(levels->numLevels ? levels->numLevels : 1, sizeof(size_t));
+  if (!shared.claims) {
+    perror("malloc");  fprintf(stderr, "failed to allocate memory\n");  exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < csr->listSize; i++) { shared.state[i] = SSSP_DAG_UNREACHED << 32 | SSSP_NONE; }
+  shared.state[source] = (uint64_t)SSSP_DAG_BIAS << 32 | SSSP_NONE;    // distance 0
+
+  // vertices before the source's level can't be reached from it; a source that
+  // is in no level (it is on a cycle) reaches nothing
+  shared.first = levels->numLevels;
+  for (unsigned int i = 0; i < levels->count; i++) {
+    if (levels->order[i] != source) continue;
+    shared.first = 0;
+    while (levels->offsets[shared.first + 1] <= i) shared.first++;
+    break;
+  }
+
+  pthread_barrier_init(&shared.barrier, NULL, threads);
+  pthread_t *workers = (pthread_t*)_sssp_malloc(sizeof(pthread_t) * threads);
+  for (unsigned int t = 1; t < threads; t++) {
+    if (pthread_create(&workers[t], NULL, _sssp_dag_worker, &shared)) {
+      perror("pthread_create");  exit(EXIT_FAILURE);
+    }
+  }
+  _sssp_dag_run(&shared);
+  for (unsigned int t = 1; t < threads; t++) { pthread_join(workers[t], NULL); }
+  pthread_barrier_destroy(&shared.barrier);
+
+  for (size_t i = 0; i < csr->listSize; i++) {
+    uint64_t key = shared.state[i] >> 32;
+    if (key == SSSP_DAG_UNREACHED) continue;
+    int dist = (int)((int64_t)key - SSSP_DAG_BIAS);
+    uint32_t pred = (uint32_t)shared.state[i];
+    result->dist[i] = longest ? -dist : dist;
+    result->pred[i] = pred == SSSP_NONE ? -1 : (int)pred;
+    graphDenseMarkVisited(result, i);
+  }
+
+  if (own) graphLevelsFree(own);
+  free(shared.claims);
+  free(shared.state);
+  free(workers);
+  return result;
+}
@@ -0,0 +1,560 @@
+/*
+ * Counted B+ Tree - balanced search tree of wide nodes
+ *
+ * An AVL tree (avlTree.c) keeps one key per node, so a lookup in a tree of a million keys
+ * follows some 20 pointers to nodes scattered over the heap, each one likely a cache miss.
+ * A B+ tree of order m keeps up to m keys per node, sorted in an array: a lookup reads a
+ * node's keys, which are adjacent in memory, follows one pointer down, and reaches a leaf
+ * after log_m(n) levels, 4 instead of 20 for a million keys and m = 32.
+ *
+ * All keys and their values sit in the leaves, which are linked in order so that range
+ * scans step along a leaf's array and then to the next leaf. Internal nodes hold only
+ * separators: child i has keys <= keys[i] <= the keys of child i+1 (duplicates of a
+ * separator may sit on either side of it). Every node but the root holds at least
+ * (m-1)/2 keys, so the tree stays balanced with all leaves at the same depth.
+ *
+ * Counts:
+ * Next to each child pointer an internal node stores the number of keys under that child.
+ * Rank (keys smaller than a key) sums the counts of the children left of the path down,
+ * and select (key of a rank) descends by subtracting counts; both take O(lg n) and read
+ * only the nodes on one path. Inserts and deletes adjust the counts on the path they
+ * walk anyway.
+ *
+ * Insertion and deletion are one pass from the root down. Insert splits any full node
+ * before descending into it, so a split never has to travel back up; delete likewise
+ * tops up any minimal node before descending into it, borrowing a key from a sibling or
+ * merging with one. The tree grows and shrinks at the root.
+ *
+ * Bulk building from a sorted array needs no splits at all: fill the leaves evenly, then
+ * each level of parents over them, in O(n).
+ *
+ * Searching a node is a branch free binary search of its key array: the few dozen keys of a node lie in
+ * one to four adjacent cache lines, so the search costs a handful of comparisons and at
+ * most one or two misses, against one miss per comparison going down an AVL tree.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "../Headers/bTree.h"
+
+
+typedef struct BTreeNode {
+  int num;                          // keys in node; an internal node has num+1 children
+  bool leaf;
+  struct BTreeNode *next, *prev;    // leaves: neighbours in key order
+  struct BTreeNode **children;      // internal: order+1 children
+  size_t *counts;                   // internal: number of keys under each child
+  int *keys;                        // order keys, or separators
+  int *values;                      // leaves: value of each key
+} BTreeNode;
+
+
+struct BTree {
+  BTreeNode *root;
+  size_t size;
+  int order;                        // most keys in a node
+  int min;                          // fewest keys in a node other than root
+};
+
+
+// allocates a node with its arrays in the same block
+static BTreeNode* allocateNode(BTree *tree, bool leaf)
+{
+  size_t m = tree->order;
+  size_t size = sizeof(BTreeNode) + ((m * sizeof(int) + 7) & ~(size_t)7);
+  size += leaf ? m * sizeof(int) : (m+1) * (sizeof(BTreeNode*) + sizeof(size_t));
+
+  BTreeNode *node = malloc(size);
+  if (!node) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  char *arrays = (char*)(node + 1);
+  node->num = 0;
+  node->leaf = leaf;
+  node->next = node->prev = NULL;
+  if (leaf) {
+    node->children = NULL;
+    node->counts = NULL;
+    node->keys = (int*)arrays;
+    node->values = node->keys + m;
+  } else {
+    // keys first so that they share the header's cache line; pointers 8 byte aligned after
+    node->keys = (int*)arrays;
+    node->children = (BTreeNode**)(arrays + ((m * sizeof(int) + 7) & ~(size_t)7));
+    node->counts = (size_t*)(node->children + m+1);
+    node->values = NULL;
+  }
+  return node;
+}
+
+static void freeNodes(BTreeNode *node)
+{
+  if (!node->leaf) {
+    for (int i = 0; i <= node->num; i++) freeNodes(node->children[i]);
+  }
+  free(node);
+}
+
+static BTree* allocateTree(unsigned int order)
+{
+  BTree *tree = malloc(sizeof(*tree));
+  if (!tree) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  if (order == 0) order = BTREE_DEFAULT_ORDER;
+  if (order < BTREE_MIN_ORDER) order = BTREE_MIN_ORDER;
+  if (order > BTREE_MAX_ORDER) order = BTREE_MAX_ORDER;
+  tree->order = order;
+  tree->min = (order - 1) / 2;
+  tree->size = 0;
+  tree->root = NULL;
+  return tree;
+}
+
+// number of keys of node smaller than key, found without branches the CPU could mispredict
+static inline int lowerIndex(BTreeNode *node, int key)
+{
+  const int *base = node->keys;
+  int n = node->num;
+
+  if (n == 0) return 0;
+  while (n > 1) {
+    int half = n / 2;
+    base = base[half-1] < key ? base + half : base;
+    n -= half;
+  }
+  return (base - node->keys) + (*base < key);
+}
+
+// number of keys of node smaller than or equal to key
+static inline int upperIndex(BTreeNode *node, int key)
+{
+  const int *base = node->keys;
+  int n = node->num;
+
+  if (n == 0) return 0;
+  while (n > 1) {
+    int half = n / 2;
+    base = base[half-1] <= key ? base + half : base;
+    n -= half;
+  }
+  return (base - node->keys) + (*base <= key);
+}
+
+
+/*                                */
+/*      SPLITTING AND MERGING     */
+/*                                */
+
+// splits the full child i of parent in two halves, the right one becoming child i+1
+static void splitChild(BTree *tree, BTreeNode *parent, int i)
+{
+  BTreeNode *child = parent->children[i];
+  BTreeNode *right = allocateNode(tree, child->leaf);
+  int half = tree->order / 2;
+  size_t right_count = 0;
+  int separator;
+
+  if (child->leaf) {
+    right->num = child->num - half;
+    memcpy(right->keys, child->keys + half, right->num * sizeof(int));
+    memcpy(right->values, child->values + half, right->num * sizeof(int));
+    right->next = child->next;
+    right->prev = child;
+    if (child->next) child->next->prev = right;
+    child->next = right;
+    separator = right->keys[0];
+    right_count = right->num;
+  } else {
+    // keys[half] moves up; the right node takes the keys after it and their children
+    right->num = child->num - half - 1;
+    memcpy(right->keys, child->keys + half+1, right->num * sizeof(int));
+    memcpy(right->children, child->children + half+1, (right->num+1) * sizeof(BTreeNode*));
+    memcpy(right->counts, child->counts + half+1, (right->num+1) * sizeof(size_t));
+    separator = child->keys[half];
+    for (int j = 0; j <= right->num; j++) right_count += right->counts[j];
+  }
+  child->num = half;
+
+  memmove(parent->keys + i+1, parent->keys + i, (parent->num - i) * sizeof(int));
+  memmove(parent->children + i+2, parent->children + i+1, (parent->num - i) * sizeof(BTreeNode*));
+  memmove(parent->counts + i+2, parent->counts + i+1, (parent->num - i) * sizeof(size_t));
+  parent->keys[i] = separator;
+  parent->children[i+1] = right;
+  parent->counts[i+1] = right_count;
+  parent->counts[i] -= right_count;
+  parent->num++;
+}
+
+// moves the first key of child i+1 to the end of child i
+static void borrowRight(BTreeNode *parent, int i)
+{
+  BTreeNode *child = parent->children[i];
+  BTreeNode *right = parent->children[i+1];
+  size_t moved = 1;
+
+  if (child->leaf) {
+    child->keys[child->num] = right->keys[0];
+    child->values[child->num] = right->values[0];
+    memmove(right->keys, right->keys + 1, (right->num - 1) * sizeof(int));
+    memmove(right->values, right->values + 1, (right->num - 1) * sizeof(int));
+    parent->keys[i] = right->keys[0];
+  } else {
+    moved = right->counts[0];
+    child->keys[child->num] = parent->keys[i];
+    child->children[child->num+1] = right->children[0];
+    child->counts[child->num+1] = moved;
+    parent->keys[i] = right->keys[0];
+    memmove(right->keys, right->keys + 1, (right->num - 1) * sizeof(int));
+    memmove(right->children, right->children + 1, right->num * sizeof(BTreeNode*));
+    memmove(right->counts, right->counts + 1, right->num * sizeof(size_t));
+  }
+  child->num++;
+  right->num--;
+  parent->counts[i] += moved;
+  parent->counts[i+1] -= moved;
+}
+
+// moves the last key of child i-1 to the front of child i
+static void borrowLeft(BTreeNode *parent, int i)
+{
+  BTreeNode *child = parent->children[i];
+  BTreeNode *left = parent->children[i-1];
+  size_t moved = 1;
+
+  memmove(child->keys + 1, child->keys, child->num * sizeof(int));
+  if (child->leaf) {
+    memmove(child->values + 1, child->values, child->num * sizeof(int));
+    child->keys[0] = left->keys[left->num-1];
+    child->values[0] = left->values[left->num-1];
+    parent->keys[i-1] = child->keys[0];
+  } else {
+    memmove(child->children + 1, child->children, (child->num+1) * sizeof(BTreeNode*));
+    memmove(child->counts + 1, child->counts, (child->num+1) * sizeof(size_t));
+    moved = left->counts[left->num];
+    child->keys[0] = parent->keys[i-1];
+    child->children[0] = left->children[left->num];
+    child->counts[0] = moved;
+    parent->keys[i-1] = left->keys[left->num-1];
+  }
+  child->num++;
+  left->num--;
+  parent->counts[i] += moved;
+  parent->counts[i-1] -= moved;
+}
+
+// merges child i+1 into child i, removing separator i from parent
+static void mergeChildren(BTreeNode *parent, int i)
+{
+  BTreeNode *left = parent->children[i];
+  BTreeNode *right = parent->children[i+1];
+
+  if (left->leaf) {
+    memcpy(left->keys + left->num, right->keys, right->num * sizeof(int));
+    memcpy(left->values + left->num, right->values, right->num * sizeof(int));
+    left->num += right->num;
+    left->next = right->next;
+    if (right->next) right->next->prev = left;
+  } else {
+    left->keys[left->num] = parent->keys[i];
+    memcpy(left->keys + left->num+1, right->keys, right->num * sizeof(int));
+    memcpy(left->children + left->num+1, right->children, (right->num+1) * sizeof(BTreeNode*));
+    memcpy(left->counts + left->num+1, right->counts, (right->num+1) * sizeof(size_t));
+    left->num += right->num + 1;
+  }
+  free(right);
+
+  parent->counts[i] += parent->counts[i+1];
+  memmove(parent->keys + i, parent->keys + i+1, (parent->num - i - 1) * sizeof(int));
+  memmove(parent->children + i+1, parent->children + i+2, (parent->num - i - 1) * sizeof(BTreeNode*));
+  memmove(parent->counts + i+1, parent->counts + i+2, (parent->num - i - 1) * sizeof(size_t));
+  parent->num--;
+}
+
+// gives the minimal child i of parent a key more, from a sibling or by merging with one
+static void fixChild(BTree *tree, BTreeNode *parent, int i)
+{
+  if (i > 0 && parent->children[i-1]->num > tree->min) {
+    borrowLeft(parent, i);
+  } else if (i < parent->num && parent->children[i+1]->num > tree->min) {
+    borrowRight(parent, i);
+  } else if (i < parent->num) {
+    mergeChildren(parent, i);
+  } else {
+    mergeChildren(parent, i-1);
+  }
+}
+
+// descends to the leaf holding the key of a rank, setting pos to its position there
+static BTreeNode* findRank(BTree *tree, size_t rank, int *pos)
+{
+  BTreeNode *node = tree->root;
+  while (!node->leaf) {
+    int i = 0;
+    while (i < node->num && rank >= node->counts[i]) {
+      rank -= node->counts[i];
+      i++;
+    }
+    node = node->children[i];
+  }
+  *pos = (int)rank;
+  return node;
+}
+
+// removes and returns the key of a rank < tree->size
+static void deleteRank(BTree *tree, size_t rank, int *key, int *value)
+{
+  BTreeNode *node = tree->root;
+
+  while (!node->leaf) {
+    size_t r = rank;
+    int i = 0;
+    while (i < node->num && r >= node->counts[i]) {
+      r -= node->counts[i];
+      i++;
+    }
+    if (node->children[i]->num <= tree->min) {
+      fixChild(tree, node, i);
+      if (node->num == 0) {                       // root merged its only two children
+	tree->root = node->children[0];
+	free(node);
+	node = tree->root;
+      }
+      continue;                                   // the rank may now lie under another index
+    }
+    node->counts[i]--;
+    rank = r;
+    node = node->children[i];
+  }
+
+  int pos = (int)rank;
+  if (key) *key = node->keys[pos];
+  if (value) *value = node->values[pos];
+  memmove(node->keys + pos, node->keys + pos+1, (node->num - pos - 1) * sizeof(int));
+  memmove(node->values + pos, node->values + pos+1, (node->num - pos - 1) * sizeof(int));
+  node->num--;
+  tree->size--;
+}
+
+
+/*                                */
+/*      B+ TREE FUNCTIONS         */
+/*                                */
+
+BTree* BTreeBuild(unsigned int order)
+{
+  BTree *tree = allocateTree(order);
+  tree->root = allocateNode(tree, true);
+  return tree;
+}
+
+
+BTree* BTreeBuildSorted(const int *keys, const int *values, size_t n, unsigned int order)
+{
+  BTree *tree = allocateTree(order);
+  size_t m = tree->order;
+
+  for (size_t i = 1; i < n; i++) {
+    if (keys[i] < keys[i-1]) {
+      fprintf(stderr, "BTreeBuildSorted: keys are not sorted\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (n == 0) {
+    tree->root = allocateNode(tree, true);
+    return tree;
+  }
+
+  // leaves, sizes spread evenly so every leaf holds at least m/2 keys
+  size_t width = (n + m - 1) / m;
+  BTreeNode **level = malloc(width * sizeof(*level));
+  int *low = malloc(width * sizeof(*low));            // smallest key under each node
+  size_t *count = malloc(width * sizeof(*count));     // keys under each node
+  if (!level || !low || !count) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t at = 0;
+  for (size_t j = 0; j < width; j++) {
+    BTreeNode *leaf = allocateNode(tree, true);
+    leaf->num = n / width + (j < n % width);
+    memcpy(leaf->keys, keys + at, leaf->num * sizeof(int));
+    for (int k = 0; k < leaf->num; k++) leaf->values[k] = values ? values[at+k] : (int)(at+k);
+    if (j > 0) {
+      leaf->prev = level[j-1];
+      level[j-1]->next = leaf;
+    }
+    level[j] = leaf;
+    low[j] = leaf->keys[0];
+    count[j] = leaf->num;
+    at += leaf->num;
+  }
+
+  // parents over each level, in place: parent p only reads entries at or after p
+  while (width > 1) {
+    size_t parents = (width + m) / (m+1);
+    size_t child = 0;
+    for (size_t p = 0; p < parents; p++) {
+      BTreeNode *node = allocateNode(tree, false);
+      int fanout = width / parents + (p < width % parents);
+      size_t total = 0;
+      int first_low = low[child];
+      node->num = fanout - 1;
+      for (int c = 0; c < fanout; c++, child++) {
+	node->children[c] = level[child];
+	node->counts[c] = count[child];
+	if (c > 0) node->keys[c-1] = low[child];
+	total += count[child];
+      }
+      level[p] = node;
+      low[p] = first_low;
+      count[p] = total;
+    }
+    width = parents;
+  }
+
+  tree->root = level[0];
+  tree->size = n;
+  free(level);
+  free(low);
+  free(count);
+  return tree;
+}
+
+
+void BTreeFree(BTree *tree)
+{
+  freeNodes(tree->root);
+  free(tree);
+}
+
+
+size_t BTreeSize(BTree *tree)
+{
+  return tree->size;
+}
+
+
+int BTreeSearch(BTree *tree, int key, int *value)
+{
+  BTreeIterator it;
+  int found;
+
+  BTreeSeek(tree, key, &it);
+  if (!BTreeIteratorNext(&it, &found, value)) return 0;
+  return found == key;
+}
+
+
+void BTreeInsert(BTree *tree, int key, int value)
+{
+  if (tree->root->num == tree->order) {
+    BTreeNode *root = allocateNode(tree, false);
+    root->children[0] = tree->root;
+    root->counts[0] = tree->size;
+    splitChild(tree, root, 0);
+    tree->root = root;
+  }
+
+  BTreeNode *node = tree->root;
+  while (!node->leaf) {
+    int i = upperIndex(node, key);
+    if (node->children[i]->num == tree->order) {
+      splitChild(tree, node, i);
+      if (key >= node->keys[i]) i++;
+    }
+    node->counts[i]++;
+    node = node->children[i];
+  }
+
+  int pos = upperIndex(node, key);
+  memmove(node->keys + pos+1, node->keys + pos, (node->num - pos) * sizeof(int));
+  memmove(node->values + pos+1, node->values + pos, (node->num - pos) * sizeof(int));
+  node->keys[pos] = key;
+  node->values[pos] = value;
+  node->num++;
+  tree->size++;
+}
+
+
+int BTreeDelete(BTree *tree, int key, int *value)
+{
+  size_t rank = BTreeRank(tree, key);
+  int found;
+
+  if (!BTreeSelect(tree, rank, &found, NULL) || found != key) return 0;
+  deleteRank(tree, rank, NULL, value);
+  return 1;
+}
+
+
+size_t BTreeRank(BTree *tree, int key)
+{
+  BTreeNode *node = tree->root;
+  size_t rank = 0;
+
+  while (!node->leaf) {
+    int i = lowerIndex(node, key);
+    for (int j = 0; j < i; j++) rank += node->counts[j];
+    node = node->children[i];
+  }
+  return rank + lowerIndex(node, key);
+}
+
+
+int BTreeSelect(BTree *tree, size_t rank, int *key, int *value)
+{
+  if (rank >= tree->size) return 0;
+
+  int pos;
+  BTreeNode *leaf = findRank(tree, rank, &pos);
+  if (key) *key = leaf->keys[pos];
+  if (value) *value = leaf->values[pos];
+  return 1;
+}
+
+
+void BTreeSeek(BTree *tree, int key, BTreeIterator *it)
+{
+  BTreeNode *node = tree->root;
+  while (!node->leaf) {
+    node = node->children[lowerIndex(node, key)];
+  }
+  it->leaf = node;
+  it->pos = lowerIndex(node, key);
+}
+
+
+void BTreeSeekRank(BTree *tree, size_t rank, BTreeIterator *it)
+{
+  if (rank >= tree->size) {                       // past the end
+    it->leaf = NULL;
+    it->pos = 0;
+    return;
+  }
+  it->leaf = findRank(tree, rank, &it->pos);
+}
+
+
+int BTreeIteratorNext(BTreeIterator *it, int *key, int *value)
+{
+  while (it->leaf && it->pos >= it->leaf->num) {  // the first key >= a bound may start the next leaf
+    it->leaf = it->leaf->next;
+    it->pos = 0;
+  }
+  if (!it->leaf) return 0;
+
+  if (key) *key = it->leaf->keys[it->pos];
+  if (value) *value = it->leaf->values[it->pos];
+  it->pos++;
+  return 1;
+}
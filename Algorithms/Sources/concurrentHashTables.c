@@ -0,0 +1,318 @@
+/*     HASH TABLES - sharded implementation for concurrent use
+  The tables of hashTables.c and intHashTables.c assume a single user: two threads
+  inserting at once can lose elements, and a search running while another thread resizes
+  walks freed memory. Wrapping such a table in one mutex makes it safe, but then every
+  thread waits for every other, even readers, so adding threads adds no throughput.
+
+  Shards:
+  The table is split into a fixed number of shards, each a complete chaining hash table
+  with its own bucket array, element count and lock. High bits of a key's hash choose the
+  shard, low bits the bucket within it, so keys spread evenly over both. Two threads only
+  contend when their keys fall in the same shard; with a few shards per processor that is
+  rare. Each shard sits in its own cache line so that the lock and count one thread writes
+  do not invalidate the line another thread is reading (false sharing).
+
+  Locking:
+  Every shard is guarded by a reader-writer lock. Searches take it shared, so any number
+  of readers proceed together, even in one shard; inserts, deletes and resizes take it
+  exclusive. Truly lock-free reads would need deleted nodes to outlive any reader still
+  walking them (hazard pointers, epochs), bookkeeping that costs more than an uncontended
+  read lock for a table of this size. Search copies the value out before unlocking and
+  never hands out a node, which another thread may free the moment the lock is released.
+
+  Insert-or-update:
+  A search followed by an insert is not atomic: two threads counting the same key can both
+  read 4 and both store 5. concurrentHashTableUpsert finds the key, calls the caller's
+  function on the current value, and stores the result all under the shard's write lock.
+
+  Resizing:
+  A shard doubles when it holds as many elements as buckets and halves when it falls under
+  a quarter (see hashTables.c's yo-yo'ing), each on its own: one shard's resize stalls only
+  the threads using that shard, and rehashes only that shard's elements, while a resize of
+  one big table would stop the world. Nodes cache their hash so rehashing never recomputes it.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../Headers/concurrentHashTables.h"
+#include "../Headers/graphStats.h"
+
+
+typedef struct concurrentHashNode {
+  struct concurrentHashNode *next;
+  uint64_t hash;
+  int      value;
+  char     key[];                             // nul terminated, allocated with the node
+} concurrentHashNode;
+
+
+typedef struct concurrentHashShard {
+  pthread_rwlock_t     lock;
+  concurrentHashNode **buckets;
+  size_t               tableSize;             // number of buckets, power of two
+  size_t               numElements;
+} __attribute__((aligned(64))) concurrentHashShard;
+
+
+struct concurrentHashTable {
+  concurrentHashShard *shards;
+  unsigned int         numShards;             // power of two
+  unsigned int         shardShift;            // 64 - log2(numShards)
+};
+
+
+#define CONCURRENT_HASH_MIN_SIZE 8
+#define CONCURRENT_HASH_SHARDS_PER_CPU 4
+
+
+/* djb2 hash algorithm by Dan Bernstein, multiplied by the golden ratio so that the high
+   bits, which choose the shard, depend on every character */
+static inline
+uint64_t hash(const char *str)
+{
+  uint64_t hash = 5381;
+  int c;
+
+  while ((c = (unsigned char)*str++)) {
+    hash = ((hash << 5) + hash) + c;
+  }
+  return hash * UINT64_C(0x9e3779b97f4a7c15);
+}
+
+static inline
+concurrentHashShard* shardOf(concurrentHashTable *table, uint64_t hash_value)
+{
+  if (table->numShards == 1) return table->shards;
+  return &table->shards[hash_value >> table->shardShift];
+}
+
+static void* allocOrDie(size_t size, int zero)
+{
+  void *p = zero ? calloc(1, size) : malloc(size);
+  if (!p) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  return p;
+}
+
+
+/*                            */
+/*    SHARD GROWTH            */
+/*                            */
+
+/* Rehash shard into size buckets. Caller holds the shard's write lock. */
+static void shard_resize(concurrentHashShard *shard, size_t size)
+{
+  concurrentHashNode **buckets = allocOrDie(sizeof(*buckets) * size, 1);
+  size_t mask = size - 1;
+
+  for (size_t i = 0; i < shard->tableSize; i++) {
+    concurrentHashNode *node = shard->buckets[i];
+    while (node) {
+      concurrentHashNode *next = node->next;
+      size_t slot = node->hash & mask;
+      node->next = buckets[slot];
+      buckets[slot] = node;
+      node = next;
+    }
+  }
+  free(shard->buckets);
+  shard->buckets = buckets;
+  GRAPH_STAT_ADD(hash_resizes, 1);
+  GRAPH_STAT_ADD(hash_rehashed, shard->numElements);
+  shard->tableSize = size;
+}
+
+/* Pointer to the link pointing at key's node, or to the NULL ending its chain.
+   Caller holds the shard's lock. */
+static concurrentHashNode** shard_find(concurrentHashShard *shard, const char *key, uint64_t hash_value)
+{
+  concurrentHashNode **link = &shard->buckets[hash_value & (shard->tableSize - 1)];
+  uint64_t probes = 0;
+
+  while (*link) {
+    probes++;
+    if ((*link)->hash == hash_value && strcmp((*link)->key, key) == 0) break;
+    link = &(*link)->next;
+  }
+  GRAPH_STAT_ADD(hash_lookups, 1);
+  GRAPH_STAT_ADD(hash_probes, probes);
+  GRAPH_STAT_MAX(hash_chain_max, probes);
+  return link;
+}
+
+/* Append a new node for key at link. Caller holds the shard's write lock. */
+static void shard_add(concurrentHashShard *shard, concurrentHashNode **link,
+		      const char *key, uint64_t hash_value, int value)
+{
+  size_t len = strlen(key) + 1;
+  concurrentHashNode *node = allocOrDie(sizeof(*node) + len, 0);
+
+  GRAPH_STAT_ADD(allocations, 1);
+  memcpy(node->key, key, len);
+  node->hash  = hash_value;
+  node->value = value;
+  node->next  = NULL;
+  *link = node;
+  if (++shard->numElements > shard->tableSize) shard_resize(shard, shard->tableSize * 2);
+}
+
+
+/*                            */
+/*    HASH TABLE FUNCTIONS    */
+/*                            */
+
+concurrentHashTable* concurrentHashTableBuild(unsigned int shards)
+{
+  concurrentHashTable *new = allocOrDie(sizeof(*new), 0);
+
+  if (shards == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    shards = CONCURRENT_HASH_SHARDS_PER_CPU * (unsigned int)(cpus > 0 ? cpus : 1);
+  }
+  new->numShards  = 1;
+  new->shardShift = 64;
+  while (new->numShards < shards) {
+    new->numShards <<= 1;
+    new->shardShift--;
+  }
+
+  if (posix_memalign((void**)&new->shards, 64, sizeof(concurrentHashShard) * new->numShards)) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for (unsigned int i = 0; i < new->numShards; i++) {
+    concurrentHashShard *shard = &new->shards[i];
+    pthread_rwlock_init(&shard->lock, NULL);
+    shard->buckets = allocOrDie(sizeof(*shard->buckets) * CONCURRENT_HASH_MIN_SIZE, 1);
+    shard->tableSize = CONCURRENT_HASH_MIN_SIZE;
+    shard->numElements = 0;
+  }
+  return new;
+}
+
+
+void concurrentHashTableFree(concurrentHashTable *table)
+{
+  for (unsigned int i = 0; i < table->numShards; i++) {
+    concurrentHashShard *shard = &table->shards[i];
+    for (size_t j = 0; j < shard->tableSize; j++) {
+      concurrentHashNode *node = shard->buckets[j];
+      while (node) {
+	concurrentHashNode *next = node->next;
+	free(node);
+	node = next;
+      }
+    }
+    free(shard->buckets);
+    pthread_rwlock_destroy(&shard->lock);
+  }
+  free(table->shards);
+  free(table);
+}
+
+
+size_t concurrentHashTableSize(concurrentHashTable *table)
+{
+  size_t size = 0;
+
+  for (unsigned int i = 0; i < table->numShards; i++) {
+    concurrentHashShard *shard = &table->shards[i];
+    pthread_rwlock_rdlock(&shard->lock);
+    size += shard->numElements;
+    pthread_rwlock_unlock(&shard->lock);
+  }
+  return size;
+}
+
+
+int concurrentHashTableInsert(concurrentHashTable *table, const char *key, int value)
+{
+  uint64_t hash_value = hash(key);
+  concurrentHashShard *shard = shardOf(table, hash_value);
+  int inserted = 0;
+
+  pthread_rwlock_wrlock(&shard->lock);
+  concurrentHashNode **link = shard_find(shard, key, hash_value);
+  if (*link) {
+    (*link)->value = value;
+  } else {
+    shard_add(shard, link, key, hash_value, value);
+    inserted = 1;
+  }
+  pthread_rwlock_unlock(&shard->lock);
+  return inserted;
+}
+
+
+int concurrentHashTableSearch(concurrentHashTable *table, const char *key, int *value)
+{
+  uint64_t hash_value = hash(key);
+  concurrentHashShard *shard = shardOf(table, hash_value);
+  int found = 0;
+
+  pthread_rwlock_rdlock(&shard->lock);
+  concurrentHashNode *node = *shard_find(shard, key, hash_value);
+  if (node) {
+    if (value) *value = node->value;
+    found = 1;
+  }
+  pthread_rwlock_unlock(&shard->lock);
+  return found;
+}
+
+
+int concurrentHashTableDelete(concurrentHashTable *table, const char *key)
+{
+  uint64_t hash_value = hash(key);
+  concurrentHashShard *shard = shardOf(table, hash_value);
+  int deleted = 0;
+
+  pthread_rwlock_wrlock(&shard->lock);
+  concurrentHashNode **link = shard_find(shard, key, hash_value);
+  if (*link) {
+    concurrentHashNode *node = *link;
+    *link = node->next;
+    free(node);
+    deleted = 1;
+    shard->numElements--;
+    if (shard->tableSize > CONCURRENT_HASH_MIN_SIZE && shard->numElements < shard->tableSize / 4) {
+      shard_resize(shard, shard->tableSize / 2);
+    }
+  }
+  pthread_rwlock_unlock(&shard->lock);
+  return deleted;
+}
+
+
+int concurrentHashTableUpsert(concurrentHashTable *table, const char *key,
+			      int (*update)(int value, bool found, void *arg), void *arg, int *result)
+{
+  uint64_t hash_value = hash(key);
+  concurrentHashShard *shard = shardOf(table, hash_value);
+  int inserted = 0;
+  int value;
+
+  pthread_rwlock_wrlock(&shard->lock);
+  concurrentHashNode **link = shard_find(shard, key, hash_value);
+  if (*link) {
+    value = update((*link)->value, true, arg);
+    (*link)->value = value;
+  } else {
+    value = update(0, false, arg);
+    shard_add(shard, link, key, hash_value, value);
+    inserted = 1;
+  }
+  pthread_rwlock_unlock(&shard->lock);
+  if (result) *result = value;
+  return inserted;
+}
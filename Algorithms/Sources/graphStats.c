@@ -0,0 +1,40 @@
+/*
+  Instrumentation counters
+  Storage of the per-thread counters behind the GRAPH_STAT_* macros of graphStats.h. The hot
+  paths of the traversals, the shortest path searches, the indexed heap and the hash tables
+  increment them when the library is compiled with GRAPH_STATS; without it this file only
+  provides graphStatsRead, returning zeros, and graphStatsReset, doing nothing, so callers
+  need not be compiled differently from the library.
+  It lives next to hashTables.c rather than with the graph library, as the hash tables count
+  into these too: built with GRAPH_STATS, hashTables.c links with this file alone.
+*/
+
+
+#include <string.h>
+
+#include "../Headers/graphStats.h"
+
+
+#ifdef GRAPH_STATS
+__thread graph_stats_t graph_stats;
+#endif
+
+
+graph_stats_t graphStatsRead(void)
+{
+#ifdef GRAPH_STATS
+  return graph_stats;
+#else
+  graph_stats_t zero;
+  memset(&zero, 0, sizeof(zero));
+  return zero;
+#endif
+}
+
+
+void graphStatsReset(void)
+{
+#ifdef GRAPH_STATS
+  memset(&graph_stats, 0, sizeof(graph_stats));
+#endif
+}
@@ -22,20 +22,68 @@
   linked list. This process is slow but occurs seldom (as table doubles each time,
   growth is exponential and less likely to be needed as table grows), so we spread
   the costs of such re-sizeing accross all operations of the hash table.
+
+  Incremental resizing:
+  Amortized is not the same as always fast: the one operation that triggers a resize pays for
+  re-hashing the whole table, a pause proportional to its size. A table built with the flag
+  HASH_TABLE_INCREMENTAL instead keeps the old array alive next to the new one, and every
+  operation moves a few of its slots into the new array, freeing the old one once it is empty.
+  An operation on a key first moves over the one old slot the key hashes to, so it only ever
+  needs to look in the new array. How many slots an operation moves depends on how soon the
+  table could resize again: the slots left, divided by the inserts before it fills up or the
+  deletes before it drains to 1/4, whichever is fewer (and at least HASH_REHASH_BUCKETS). The
+  old array is then always empty before the next resize. A growth leaves S slots to move in S/2
+  inserts, 2 per operation; a shrink to S/2 slots leaves S slots to move in S/8 deletes, 8 per
+  operation. No operation moves more than that, however large the table. The arrays of such a
+  table (from 1 KB up) are mapped with mmap rather than allocated with calloc, which could stall
+  the one operation that resizes, see hashTable_init.
+  This means every operation writes to the table while a resize is in progress, searches
+  included: a table with this flag can not be searched by several threads at once, even with
+  no insert or delete among them.
+  Nodes cache the hash of their key (node->hash), so moving them does not hash their keys again.
+
+  Key arena:
+  hashTableInsert copies every key into its own malloc. With the flag HASH_TABLE_KEY_ARENA the
+  copies are carved from large chunks instead, one malloc per chunk, and hashTableFree and
+  hashTableEmpty release all keys a chunk at a time. The space of keys deleted from the table
+  is only reclaimed then. Nodes inserted with hashTableInsertNode keep the key they came with.
+
+  Compiled with GRAPH_STATS, lookups, the chain nodes they compare, resizes and
+  allocations are counted, see graphStats.h.
 */
 
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include "../Headers/hashTables.h"
+#include "../Headers/graphStats.h"
+
+
+#define HASH_REHASH_BUCKETS  4              // least slots moved by each operation during a resize
+#define HASH_MAP_MIN_BYTES   1024           // incremental tables this large are mapped, see hashTable_init
+#define HASH_KEY_FIRST_CHUNK (4 * 1024)
+#define HASH_KEY_MAX_CHUNK   (1024 * 1024)
 
 
+typedef struct hashKeyChunk {
+  struct hashKeyChunk *next;
+  size_t size;                   // in bytes, of data
+  size_t used;
+  char   data[];
+} hashKeyChunk;
+
 struct hashTable {
-  unsigned int numElements;
+  unsigned int numElements;      // in both arrays while a resize is in progress
   unsigned int tableSize;
   unsigned int structSize;
+  unsigned int flags;            // HASH_TABLE_* the table was built with
+  bool         mapped;           // from mmap rather than calloc, see hashTable_init
+  struct hashTable *old;         // incremental resize: table being moved into this one, or NULL
+  size_t       migrated;         // slots of old moved so far, in order
+  hashKeyChunk *keys;            // key arena, head is the chunk handed out from
   struct nodeHashTable* table[];
 };
 
@@ -54,32 +102,78 @@ unsigned long hash(char *str)
 }
 
 
+/* With GRAPH_STATS, counts a lookup in the slot whose chain starts at head and
+ * measures the chain; separate from the search loops so they stay unchanged.
+ */
+#ifdef GRAPH_STATS
+static void stat_lookup(nodeHashTable *head)
+{
+  uint64_t length = 0;
+  for (; head != NULL; head = head->next) { length++; }
+  GRAPH_STAT_ADD(hash_lookups, 1);
+  GRAPH_STAT_MAX(hash_chain_max, length);
+}
+#define HASH_STAT_LOOKUP(head) stat_lookup(head)
+#else
+#define HASH_STAT_LOOKUP(head) ((void)0)
+#endif
+
+
 /*                            */
 /*    TABLE DOUBLING          */
 /*                            */
 
-static hashTable* hashTable_init(u_int size)
+static hashTable* hashTable_init(u_int size, u_int flags)
 {
   // struct lives contigious in memory, flexible array member gets last bytes.
   // its size not explicit, this is why it must be declared last in struct!
-  hashTable *new = malloc(sizeof(*new) + sizeof(struct nodeHashTable*) * size);
+  // calloc: a large array comes zeroed (all slots NULL) from the system, without a pass over it.
+  // Not always: once many nodes have been freed, glibc first merges all its small free blocks
+  // to serve any request beyond its small bins (about 1 KB), a pause that grows with them:
+  // 68 ms after deleting 1.5M keys. Incremental tables, which must not pause, map such arrays
+  // straight from the system instead.
+  size_t bytes = sizeof(hashTable) + sizeof(struct nodeHashTable*) * size;
+  bool mapped = (flags & HASH_TABLE_INCREMENTAL) && bytes >= HASH_MAP_MIN_BYTES;
+  hashTable *new = NULL;
+  if (mapped) {
+    new = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (new == MAP_FAILED) new = NULL;
+  } else {
+    new = calloc(1, bytes);
+  }
+  GRAPH_STAT_ADD(allocations, 1);
+  if (new == NULL) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory");
+    exit(EXIT_FAILURE);
+  }
   new->numElements = 0;
   new->tableSize = size;
   new->structSize = (sizeof(*new) + sizeof(struct nodeHashTable*) * size);
-
-  for (size_t i = 0; i < size; i++) {
-    new->table[i] = NULL;
-  }
+  new->flags = flags;
+  new->mapped = mapped;
+  new->old = NULL;
+  new->migrated = 0;
+  new->keys = NULL;
   return new;
 }
 
 
-/* moves a node from one hashTable into hashTable identified in the parameter
+/* releases the memory of table itself, as hashTable_init got it */
+static void hashTable_release(hashTable *table)
+{
+  if (table->mapped) munmap(table, table->structSize);
+  else               free(table);
+}
+
+
+/* moves a node from one hashTable into hashTable identified in the parameter,
+ * which already counts it in numElements
  */
 static void moveNode(hashTable *table, nodeHashTable *node)
 {
-  unsigned long hash_value = hash(node->key);
-  unsigned int hash_pos = hash_value % table->tableSize;
+  unsigned int hash_pos = node->hash % table->tableSize;
+  GRAPH_STAT_ADD(hash_rehashed, 1);
 
   // node already exists in hash slot. Realize no duplicate keys are possible as
   // node comes from another, valid, hashTable
@@ -90,37 +184,131 @@ static void moveNode(hashTable *table, nodeHashTable *node)
     table->table[hash_pos] = node;
     node->next = head;
     node->prev = NULL;
-    table->numElements++;
 
   // no node exists at hash slot.
   } else {
     table->table[hash_pos] = node;
     node->next = node->prev = NULL;
-    table->numElements++;
   }
 }
 
 
-static void hashTable_resize(hashTable **table, size_t size)
+/* moves all nodes of slot i of the table being resized into the table */
+static void migrateSlot(hashTable *table, size_t i)
 {
-  hashTable *new_table = hashTable_init(size);
-
-  // rehash all nodes in existing table and place into new_table
-  for (size_t i = 0; i < (*table)->tableSize; i++) {
-    if ( (*table)->table[i]) {
-      nodeHashTable *curr = (*table)->table[i];
-      nodeHashTable *next;
-
-      while (curr != NULL) {
-	next = curr->next;
-	moveNode(new_table, curr);
-	curr = next;
-      }
-    }
+  nodeHashTable *curr = table->old->table[i];
+  nodeHashTable *next;
+  table->old->table[i] = NULL;
+
+  while (curr != NULL) {
+    next = curr->next;
+    moveNode(table, curr);
+    curr = next;
+  }
+}
+
+
+/* moves the next slots of the table being resized (all of them if all is set),
+ * freeing it once every slot has been moved. The share of one operation is the
+ * slots left divided by the operations left before the table could resize again
+ * (fills up, or drains to 1/4), at least HASH_REHASH_BUCKETS: the old array is
+ * always empty by then. After a shrink that is 8 slots per operation, the most.
+ */
+static void migrateStep(hashTable *table, int all)
+{
+  if (!table->old) return;
+
+  size_t end = table->old->tableSize;
+  size_t left = end - table->migrated;
+  size_t ops = table->tableSize - table->numElements;
+  if (table->tableSize > 8) {
+    size_t drain = table->numElements > table->tableSize / 4 ? table->numElements - table->tableSize / 4 : 0;
+    if (drain < ops) ops = drain;
+  }
+  size_t step = ops ? (left + ops - 1) / ops : left;
+  if (step < HASH_REHASH_BUCKETS) step = HASH_REHASH_BUCKETS;
+  if (!all && step < left) {
+    end = table->migrated + step;
+  }
+  while (table->migrated < end) {
+    migrateSlot(table, table->migrated++);
   }
+  if (table->migrated == table->old->tableSize) {
+    hashTable_release(table->old);
+    table->old = NULL;
+  }
+}
+
+
+/* to be called by operations on a key before they look at the slot of the key:
+ * moves the operation's share of slots, then the slot the key is in if it is
+ * still in the table being resized. Afterwards the key is found in table or not at all.
+ */
+static void migrateFor(hashTable *table, unsigned long hash_value)
+{
+  migrateStep(table, 0);
+  if (table->old) migrateSlot(table, hash_value % table->old->tableSize);
+}
+
+
+static void hashTable_resize(hashTable **table, size_t size)
+{
   hashTable *old_table = *table;
+  migrateStep(old_table, 1);          // in case a resize is still in progress: never, see migrateStep
+
+  hashTable *new_table = hashTable_init(size, old_table->flags);
+  GRAPH_STAT_ADD(hash_resizes, 1);
+  new_table->numElements = old_table->numElements;
+  new_table->keys = old_table->keys;  // the arena moves along with the keys
+  old_table->keys = NULL;
+
+  // rehash all nodes in existing table into new_table: now, or a few slots per operation
+  new_table->old = old_table;
+  if (!(new_table->flags & HASH_TABLE_INCREMENTAL)) {
+    migrateStep(new_table, 1);
+  }
   *table = new_table;
-  free(old_table);
+}
+
+
+/*                            */
+/*    KEY ARENA               */
+/*                            */
+
+/* @return size bytes for a key, from the table's arena; starts a new chunk if needed */
+static char* keyArenaAlloc(hashTable *table, size_t size)
+{
+  hashKeyChunk *chunk = table->keys;
+  if (!chunk || chunk->size - chunk->used < size) {
+    size_t chunk_size = chunk ? chunk->size * 2 : HASH_KEY_FIRST_CHUNK;
+    if (chunk_size > HASH_KEY_MAX_CHUNK) chunk_size = HASH_KEY_MAX_CHUNK;
+    if (chunk_size < size)               chunk_size = size;
+
+    chunk = malloc(sizeof(*chunk) + chunk_size);
+    GRAPH_STAT_ADD(allocations, 1);
+    if (chunk == NULL) {
+      perror("malloc");
+      fprintf(stderr, "failed to allocate memory");
+      exit(EXIT_FAILURE);
+    }
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    chunk->next = table->keys;
+    table->keys = chunk;
+  }
+  char *key = chunk->data + chunk->used;
+  chunk->used += size;
+  return key;
+}
+
+
+static void keyArenaFree(hashKeyChunk *chunk)
+{
+  while (chunk) {
+    hashKeyChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
 }
 
 
@@ -131,7 +319,13 @@ static void hashTable_resize(hashTable **table, size_t size)
 /* Creates a new hash table. Returns a pointer to table. */
 hashTable* hashTableBuild()
 {
-  return hashTable_init(8);
+  return hashTable_init(8, 0);
+}
+
+
+hashTable* hashTableBuildWith(unsigned int flags)
+{
+  return hashTable_init(8, flags);
 }
 
 
@@ -140,21 +334,32 @@ hashTable* hashTableBuild()
  */
 void hashTableInsert(hashTable **table, char *key, int value)
 {
+  size_t key_size = sizeof(*key) * (strlen(key) + 1);
+  bool in_arena = (*table)->flags & HASH_TABLE_KEY_ARENA;
   nodeHashTable *new = malloc(sizeof(*new));
-  new->key = malloc(sizeof(*key) * strlen(key));
+  if (new != NULL) {
+    new->key = in_arena ? keyArenaAlloc(*table, key_size) : malloc(key_size);
+  }
+  GRAPH_STAT_ADD(allocations, in_arena ? 1 : 2);
   if (new == NULL || new->key == NULL) {
     perror("malloc");
     fprintf(stderr, "failed to allocate memory");
     exit(EXIT_FAILURE);
   }
 
-  memcpy(new->key, key, sizeof(char) * strlen(key));
+  memcpy(new->key, key, key_size);
+  new->key_in_arena = in_arena;
   new->value = value;
   new->key_int = 0;
+  new->key_double = 0.0;
+  new->graph_predecessor = 0;
   new->prev = NULL;
 
   unsigned long hash_value = hash(key);
+  new->hash = hash_value;
+  migrateFor(*table, hash_value);
   unsigned int hash_pos = hash_value % (*table)->tableSize;
+  HASH_STAT_LOOKUP((*table)->table[hash_pos]);
 
   // prevent duplicate keys
   // replace node instead of changing its value: better in case the node struct changes
@@ -162,6 +367,7 @@ void hashTableInsert(hashTable **table, char *key, int value)
   nodeHashTable *head;
   if ( (head = (*table)->table[hash_pos]) != NULL) {
     while (head != NULL) {
+      GRAPH_STAT_ADD(hash_probes, 1);
       if (strcmp(head->key, key) == 0) {
 	if (prev == NULL) {
 	  (*table)->table[hash_pos] = new;
@@ -169,8 +375,7 @@ void hashTableInsert(hashTable **table, char *key, int value)
 	  prev->next = new;
 	}
 	new->next = head->next;
-	free(head->key);
-	free(head);
+	hashTableFreeNode(head);
 	return;
       }
       prev = head;
@@ -200,13 +405,16 @@ void hashTableInsert(hashTable **table, char *key, int value)
 nodeHashTable* hashTableSearch(hashTable *table, char *key)
 {
   unsigned long hash_value = hash(key);
+  migrateFor(table, hash_value);
   unsigned int hash_pos = hash_value % table->tableSize;
+  HASH_STAT_LOOKUP(table->table[hash_pos]);
 
   nodeHashTable *head;
   if ( (head = table->table[hash_pos]) == NULL) {
     return NULL;
   } else {
     while (head != NULL) {
+      GRAPH_STAT_ADD(hash_probes, 1);
       if (strcmp(head->key, key) == 0) {
 	return head;
       }
@@ -220,7 +428,9 @@ nodeHashTable* hashTableSearch(hashTable *table, char *key)
 int hashTableDelete(hashTable **table, char *key)
 {
   unsigned long hash_value = hash(key);
+  migrateFor(*table, hash_value);
   unsigned int hash_pos = hash_value % (*table)->tableSize;
+  HASH_STAT_LOOKUP((*table)->table[hash_pos]);
 
   nodeHashTable *head;
   nodeHashTable *prev = NULL;
@@ -228,6 +438,7 @@ int hashTableDelete(hashTable **table, char *key)
     return 0;
   } else {
     while (head != NULL) {
+      GRAPH_STAT_ADD(hash_probes, 1);
       if (strcmp(head->key, key) == 0) {
 	(*table)->numElements--;
 	if (prev == NULL) {
@@ -235,8 +446,7 @@ int hashTableDelete(hashTable **table, char *key)
 	} else {
 	  prev->next = head->next;
 	}
-	free(head->key);
-	free(head);
+	hashTableFreeNode(head);
 
 	// resize table if numElements <= 1/4 tableSize
 	if ((*table)->tableSize > 8
@@ -256,22 +466,26 @@ int hashTableDelete(hashTable **table, char *key)
 void hashTableInsertNode(hashTable **table, nodeHashTable *node)
 {
   unsigned long hash_value = hash(node->key);
+  node->hash = hash_value;
+  migrateFor(*table, hash_value);
   unsigned int hash_pos = hash_value % (*table)->tableSize;
+  HASH_STAT_LOOKUP((*table)->table[hash_pos]);
 
   // prevent duplicate keys, if duplicates exist: replace node with current
   nodeHashTable *prev = NULL;
   nodeHashTable *head;
   if ( (head = (*table)->table[hash_pos]) != NULL) {
     while (head != NULL) {
+      GRAPH_STAT_ADD(hash_probes, 1);
       if (strcmp(head->key, node->key) == 0) {
 	if (prev == NULL) {
 	  (*table)->table[hash_pos] = node;
-	  head->prev = node;
+	  node->prev = NULL;
 	} else {
 	  prev->next = node;
 	  node->prev = prev;
-	  if (head->next) { head->next->prev = node; }
 	}
+	if (head->next) { head->next->prev = node; }
 	node->next = head->next;
 	hashTableFreeNode(head);
 	return;
@@ -284,12 +498,14 @@ void hashTableInsertNode(hashTable **table, nodeHashTable *node)
     head = (*table)->table[hash_pos];
     (*table)->table[hash_pos] = node;
     node->next = head;
+    node->prev = NULL;
     head->prev = node;
     (*table)->numElements++;
 
   // no linked list yet in this slot
   } else {
     (*table)->table[hash_pos] = node;
+    node->next = node->prev = NULL;
     (*table)->numElements++;
   }
 
@@ -311,12 +527,15 @@ nodeHashTable* hashTableSearchNode(hashTable *table, void* key,
     hashable_key = (char*)key;
   }
   unsigned long hash_value = hash(hashable_key);
+  migrateFor(table, hash_value);
   unsigned int hash_pos = hash_value % table->tableSize;
+  HASH_STAT_LOOKUP(table->table[hash_pos]);
 
   nodeHashTable *head;
   if ( (head = table->table[hash_pos]) == NULL) {}
   else {
     while (head != NULL) {
+      GRAPH_STAT_ADD(hash_probes, 1);
       if (strcmp(head->key, hashable_key) == 0) {
 	if (keyConvert) { free(hashable_key); }
 	return head;
@@ -332,9 +551,9 @@ nodeHashTable* hashTableSearchNode(hashTable *table, void* key,
 /* fast implementation: does not check if node is in hashTable */
 void hashTableDeleteNode(hashTable **table, nodeHashTable *node)
 {
+  migrateFor(*table, node->hash);
   if (!node->prev) {
-    unsigned long hash_value = hash(node->key);
-    unsigned long hash_pos = hash_value % (*table)->tableSize;
+    unsigned long hash_pos = node->hash % (*table)->tableSize;
 
     (*table)->table[hash_pos] = node->next;
   } else {
@@ -353,7 +572,7 @@ void hashTableDeleteNode(hashTable **table, nodeHashTable *node)
 
 void hashTableEmpty(hashTable **table)
 {
-  hashTable *empty = hashTableBuild();
+  hashTable *empty = hashTableBuildWith((*table)->flags);
   hashTable *tmp = (*table);
   (*table) = empty;
   hashTableFree(tmp);
@@ -370,34 +589,32 @@ int hashTableIsEmpty(hashTable *table)
 /* frees table and all nodes within it */
 void hashTableFree(hashTable *table)
 {
+  if (table->old) hashTableFree(table->old);  // the remainder of a resize in progress
   for (size_t i = 0; i < table->tableSize; i++) {
     if (table->table[i] != NULL) {
       nodeHashTable *prev = NULL;
       nodeHashTable *head = table->table[i];
       while (head != NULL) {
-	free(head->key);
 	prev = head;
 	head = head->next;
-	free(prev);
+	hashTableFreeNode(prev);
       }
     }
   }
-  free(table);  // no need to free table->table; malloced together
+  keyArenaFree(table->keys);          // all keys of the arena at once
+  hashTable_release(table);  // no need to free table->table; allocated together
 }
 
 
 void hashTableFreeNode(nodeHashTable *node)
 {
-  free(node->key);
+  if (!node->key_in_arena) free(node->key);
   free(node);
 }
 
 
-void hashTablePrint(hashTable *table)
+static void printSlots(hashTable *table)
 {
-  printf("tbl_size: %d; num_elements: %d; struct_size: %d\n",
-	 table->tableSize, table->numElements, table->structSize);
-
   for (size_t i = 0; i < table->tableSize; i++) {
     if (table->table[i] != NULL) {
       nodeHashTable *head = table->table[i];
@@ -410,3 +627,15 @@ void hashTablePrint(hashTable *table)
   }
 }
 
+
+void hashTablePrint(hashTable *table)
+{
+  printf("tbl_size: %d; num_elements: %d; struct_size: %d\n",
+	 table->tableSize, table->numElements, table->structSize);
+  printSlots(table);
+  if (table->old) {
+    printf("resizing from tbl_size: %d; slots moved: %zu\n", table->old->tableSize, table->migrated);
+    printSlots(table->old);
+  }
+}
+
@@ -0,0 +1,284 @@
+/*     HASH TABLES - open addressing implementation for integer keys
+  The chaining table in hashTables.c only hashes strings, so integer keys must first be
+  printed into a string (see keyConvertFromInt). It also allocates a node per element
+  such that every lookup walks one or more pointers to memory far from the table.
+
+  Open addressing stores the elements themselves in one flat array of slots. To insert,
+  hash the key to a slot; if that slot is taken, try the next one, and so on (linear
+  probing) until a free slot is found. Search follows the same sequence of slots. As the
+  slots probed are adjacent, a search will usually touch just one or two cache lines.
+
+  Robin Hood hashing:
+  Each element remembers how far it sits from the slot its key hashed to (its probe
+  distance). While inserting, if we come upon an element that is closer to its home than
+  the element we are placing, we swap the two and continue placing the displaced element.
+  ("take from the rich, give to the poor"). This keeps probe distances short and even. It
+  also lets search stop early: once the distance of a stored element is smaller than the
+  distance we have probed, the key cannot be further along.
+
+  Deletion without tombstones:
+  Emptying a slot would break the probe sequence of the elements after it. Instead of
+  leaving a marker, slide the following elements back by one slot until we reach an empty
+  slot or an element that is already at its home (backward-shift deletion). Searches never
+  have to skip over deleted slots, and the table does not fill up with them over time.
+
+  Resizing:
+  The number of slots is always a power of two so a hash maps to a slot with a mask. The
+  table doubles when it becomes 7/8 full. It never shrinks on delete (see hashTables.c's
+  yo-yo'ing), and intHashTableReserve allocates for a known number of elements up front so
+  that no rehashing happens at all while the table is being filled.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "../Headers/intHashTables.h"
+
+
+typedef struct intHashSlot {
+  uint64_t key;
+  int64_t  value;
+} intHashSlot;
+
+
+struct intHashTable {
+  size_t       numElements;
+  size_t       tableSize;       // number of slots, power of two
+  intHashSlot *slots;
+  uint8_t     *dist;            // probe distance + 1 of each slot's element; 0 if slot empty
+};
+
+
+#define INT_HASH_MIN_SIZE 8
+#define INT_HASH_MAX_DIST 255
+
+
+/* 64 bit mixer (splitmix64 finalizer): spreads sequential ids over all slots */
+static inline
+uint64_t hash(uint64_t key)
+{
+  key ^= key >> 30;  key *= UINT64_C(0xbf58476d1ce4e5b9);
+  key ^= key >> 27;  key *= UINT64_C(0x94d049bb133111eb);
+  key ^= key >> 31;
+  return key;
+}
+
+static inline
+size_t max_elements(size_t table_size)
+{
+  return table_size - table_size / 8;
+}
+
+
+/*                            */
+/*    TABLE GROWTH            */
+/*                            */
+
+static void intHashTable_alloc(intHashTable *table, size_t size)
+{
+  table->slots = (intHashSlot*)malloc(sizeof(intHashSlot) * size);
+  table->dist  = (uint8_t*)calloc(size, sizeof(uint8_t));
+  if (!table->slots || !table->dist) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory");
+    exit(EXIT_FAILURE);
+  }
+  table->tableSize = size;
+  table->numElements = 0;
+}
+
+static void intHashTable_resize(intHashTable *table, size_t size);
+
+/* Robin Hood placement of an element known not to be in table. */
+static void place(intHashTable *table, uint64_t key, int64_t value)
+{
+  size_t  mask = table->tableSize - 1;
+  size_t  pos  = hash(key) & mask;
+  uint8_t dist = 1;
+
+  for (;;) {
+    if (table->dist[pos] == 0) {
+      table->slots[pos].key   = key;
+      table->slots[pos].value = value;
+      table->dist[pos] = dist;
+      table->numElements++;
+      return;
+    }
+    if (table->dist[pos] < dist) {      // resident is richer: it gives up its slot
+      intHashSlot tmp = table->slots[pos];
+      uint8_t tmp_dist = table->dist[pos];
+      table->slots[pos].key   = key;
+      table->slots[pos].value = value;
+      table->dist[pos] = dist;
+      key = tmp.key;  value = tmp.value;  dist = tmp_dist;
+    }
+    pos = (pos + 1) & mask;
+    if (++dist == INT_HASH_MAX_DIST) {  // pathological clustering: spread out and retry
+      intHashTable_resize(table, table->tableSize * 2);
+      place(table, key, value);
+      return;
+    }
+  }
+}
+
+static void intHashTable_resize(intHashTable *table, size_t size)
+{
+  intHashSlot *old_slots = table->slots;
+  uint8_t     *old_dist  = table->dist;
+  size_t       old_size  = table->tableSize;
+
+  intHashTable_alloc(table, size);
+  for (size_t i = 0; i < old_size; i++) {
+    if (old_dist[i]) { place(table, old_slots[i].key, old_slots[i].value); }
+  }
+  free(old_slots);
+  free(old_dist);
+}
+
+
+/*                            */
+/*    HASH TABLE FUNCTIONS    */
+/*                            */
+
+intHashTable* intHashTableBuild()
+{
+  intHashTable *new = (intHashTable*)malloc(sizeof(*new));
+  if (!new) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory");
+    exit(EXIT_FAILURE);
+  }
+  intHashTable_alloc(new, INT_HASH_MIN_SIZE);
+  return new;
+}
+
+
+void intHashTableReserve(intHashTable *table, size_t num_elements)
+{
+  size_t size = table->tableSize;
+  while (max_elements(size) < num_elements) { size *= 2; }
+  if (size != table->tableSize) { intHashTable_resize(table, size); }
+}
+
+
+size_t intHashTableCapacity(intHashTable *table)
+{
+  return max_elements(table->tableSize);
+}
+
+
+size_t intHashTableSize(intHashTable *table)
+{
+  return table->numElements;
+}
+
+
+int intHashTableIsEmpty(intHashTable *table)
+{
+  if (table->numElements == 0) return 1;
+  return 0;
+}
+
+
+void intHashTableEmpty(intHashTable *table)
+{
+  memset(table->dist, 0, table->tableSize);
+  table->numElements = 0;
+}
+
+
+void intHashTableFree(intHashTable *table)
+{
+  free(table->slots);
+  free(table->dist);
+  free(table);
+}
+
+
+int64_t* intHashTableSearch(intHashTable *table, uint64_t key)
+{
+  size_t  mask = table->tableSize - 1;
+  size_t  pos  = hash(key) & mask;
+  uint8_t dist = 1;
+
+  // stop at empty slot or at an element closer to home than we have probed
+  while (table->dist[pos] >= dist) {
+    if (table->slots[pos].key == key) { return &table->slots[pos].value; }
+    pos = (pos + 1) & mask;
+    dist++;
+  }
+  return NULL;
+}
+
+
+int intHashTableInsert(intHashTable *table, uint64_t key, int64_t value)
+{
+  int64_t *found = intHashTableSearch(table, key);
+  if (found) {
+    *found = value;
+    return 0;
+  }
+  if (table->numElements + 1 > max_elements(table->tableSize)) {
+    intHashTable_resize(table, table->tableSize * 2);
+  }
+  place(table, key, value);
+  return 1;
+}
+
+
+int intHashTableDelete(intHashTable *table, uint64_t key)
+{
+  size_t  mask = table->tableSize - 1;
+  size_t  pos  = hash(key) & mask;
+  uint8_t dist = 1;
+
+  while (table->dist[pos] >= dist) {
+    if (table->slots[pos].key == key) {
+
+      // backward shift: pull following elements one slot closer to their home
+      size_t next = (pos + 1) & mask;
+      while (table->dist[next] > 1) {
+	table->slots[pos] = table->slots[next];
+	table->dist[pos]  = table->dist[next] - 1;
+	pos  = next;
+	next = (next + 1) & mask;
+      }
+      table->dist[pos] = 0;
+      table->numElements--;
+      return 1;
+    }
+    pos = (pos + 1) & mask;
+    dist++;
+  }
+  return 0;
+}
+
+
+int intHashTableNext(intHashTable *table, size_t *iter, uint64_t *key, int64_t *value)
+{
+  while (*iter < table->tableSize) {
+    size_t i = (*iter)++;
+    if (table->dist[i]) {
+      *key   = table->slots[i].key;
+      *value = table->slots[i].value;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+void intHashTablePrint(intHashTable *table)
+{
+  printf("tbl_size: %zu; num_elements: %zu\n", table->tableSize, table->numElements);
+
+  for (size_t i = 0; i < table->tableSize; i++) {
+    if (table->dist[i]) {
+      printf("[%" PRIu64 ":%" PRId64 "] (probe %d)\n",
+	     table->slots[i].key, table->slots[i].value, table->dist[i] - 1);
+    } else { printf("\\\n"); }
+  }
+}
@@ -1,106 +1,702 @@
 /* The below implementation of MergeSort takes as input an array
-   of pointers to integers (int *array[]). 
+   of pointers to records (void *array[]).
 
-   This ability to use an array of pointers to our data rather 
-   than an array of data is important when you want to do some 
-   processing on the data w/o mutating the original array and 
+   This ability to use an array of pointers to our data rather
+   than an array of data is important when you want to do some
+   processing on the data w/o mutating the original array and
    you dont want to copy the array because memory considerations
-   (i.e. array of strings is very large; array of pointers to 
+   (i.e. array of strings is very large; array of pointers to
    strings is only size of the pointer (4 or 8 bytes) x num pointers).
 
    Here, the original array is left alone, and in the array of
    pointers, the pointers are shuffled around so that iterating
-   over this array returns pointers to increasingly larger ints
+   over this array returns pointers to increasingly larger records
    in the original array.
+
+   Merge sort is stable: records that compare equal keep the order
+   they had in the input, so sorting by one field and then by
+   another gives records ordered by the second field, ties by the
+   first.
+
+   One buffer:
+   Merging two sorted runs needs somewhere to write the result. The
+   textbook version copies both runs out to temporary arrays first,
+   on every call, which on the stack overflows for large arrays.
+   Here a single buffer the size of the input is allocated up front
+   and the runs are merged back and forth between it and the array
+   (ping-pong): each pass over the data reads from one and writes to
+   the other, and no element is copied except by a merge.
+
+   Natural runs:
+   Real input is rarely random: it is often sorted already, sorted in
+   reverse, or made of sorted stretches (new records appended to an
+   old sorted file). As in Timsort, the array is first scanned for runs
+   that are already ascending, or strictly descending, which are
+   reversed in place (strictly, so equal records are never swapped).
+   Sorted input is a single run and costs one scan. Runs shorter than
+   MIN_RUN are extended to MIN_RUN by binary insertion sort, which for
+   a few dozen elements beats recursing down to single elements. The
+   runs are then merged pairwise, pass after pass; a pair whose first
+   run already ends before the second starts is copied, not merged.
+
+   Threads:
+   With T threads the array is cut into T equal chunks, each sorted by
+   its own thread into the same range of the buffer. The sorted chunks
+   are then merged pairwise, level after level, by all threads at once:
+   the output of each level is cut into T equal ranges, and each thread
+   finds by binary search where its range begins in the two chunks it
+   merges (merge path partitioning) and merges just that part. Every
+   thread writes the same amount at every level, however the chunks
+   line up, and the threads never write to the same memory.
+
+   Sorting by key:
+   Every comparison of a comparator sort dereferences two record
+   pointers, and for records scattered over memory each one is likely
+   a cache miss. mergeSortPointersByKey instead reads each record once,
+   for its key, and sorts the keys alone, packed next to each other,
+   ending with a single pass that permutes the pointers. When the keys
+   span less than 2^32, key - min and the record's index are packed into
+   one 64 bit integer: distinct integers in key then index order, so any
+   sort of them is stable, and comparing two costs one instruction. They
+   are merged with AVX2 where the processor has it: sorting networks
+   order columns of 4 keys, and each step of a merge takes the smallest
+   4 of 8 keys through a bitonic merge network, without branches. Other
+   processors run the same merges in branch free scalar code.
+   Integer keys also allow radix sort: (key - min, index) pairs are
+   distributed by 8 bits of the key at a time, least significant first,
+   in up to 8 linear passes, skipping the bytes on which all keys agree.
+   That beats the log2(n) merge passes on one thread, and it is the only
+   choice for keys spanning 2^32 or more; merging is used when there are
+   threads to share it, as radix sort is sequential here.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../Headers/mergeSort.h"
+
+
+#define MIN_RUN 32
+#define MIN_PARALLEL 65536       // fewest elements per thread worth a thread
+
+
+typedef struct sortContext {
+  mergeSortCompare compare;
+  void *arg;
+} sortContext;
+
+
+static void* sortMalloc(size_t size)
+{
+  void *p = malloc(size);
+  if (!p) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  return p;
+}
+
+static inline bool before(const sortContext *ctx, const void *a, const void *b)
+{
+  return ctx->compare(a, b, ctx->arg) < 0;
+}
+
+
+/*                            */
+/*    RUNS                    */
+/*                            */
+
+// array[lo..sorted) is sorted; insert array[sorted..hi) each after the equal elements before it
+static void insertionSort(void **array, size_t lo, size_t sorted, size_t hi, const sortContext *ctx)
+{
+  for (size_t i = sorted; i < hi; i++) {
+    void *pivot = array[i];
+    size_t left = lo, right = i;
+    while (left < right) {
+      size_t mid = left + (right - left) / 2;
+      if (before(ctx, pivot, array[mid])) right = mid;
+      else left = mid + 1;
+    }
+    memmove(array + left + 1, array + left, (i - left) * sizeof(void*));
+    array[left] = pivot;
+  }
+}
+
+// end of the natural run starting at lo, after reversing it if descending
+static size_t runEnd(void **array, size_t lo, size_t hi, const sortContext *ctx)
+{
+  size_t end = lo + 1;
+  if (end == hi) return hi;
+
+  if (before(ctx, array[end], array[lo])) {
+    while (end < hi && before(ctx, array[end], array[end-1])) end++;
+    for (size_t i = lo, j = end - 1; i < j; i++, j--) {
+      void *tmp = array[i];
+      array[i] = array[j];
+      array[j] = tmp;
+    }
+  } else {
+    while (end < hi && !before(ctx, array[end], array[end-1])) end++;
+  }
+  return end;
+}
+
+// stable merge of a[0..na) and b[0..nb) into out
+static void merge(void **a, size_t na, void **b, size_t nb, void **out, const sortContext *ctx)
+{
+  size_t i = 0, j = 0, k = 0;
+
+  if (na && nb && !before(ctx, b[0], a[na-1])) {          // already in order
+    memcpy(out, a, na * sizeof(void*));
+    memcpy(out + na, b, nb * sizeof(void*));
+    return;
+  }
+  while (i < na && j < nb) {
+    if (before(ctx, b[j], a[i])) out[k++] = b[j++];
+    else                         out[k++] = a[i++];
+  }
+  memcpy(out + k, a + i, (na - i) * sizeof(void*));
+  memcpy(out + k + na - i, b + j, (nb - j) * sizeof(void*));
+}
+
+// sorts array[lo..hi), using buffer[lo..hi)
+static void sortRange(void **array, void **buffer, size_t lo, size_t hi, const sortContext *ctx)
+{
+  if (hi - lo < 2) return;
+
+  // every run but the last is at least MIN_RUN long
+  size_t *bounds = sortMalloc(sizeof(size_t) * ((hi - lo) / MIN_RUN + 2));
+  size_t runs = 0;
+  bounds[0] = lo;
+  for (size_t i = lo; i < hi; ) {
+    size_t end = runEnd(array, i, hi, ctx);
+    if (end - i < MIN_RUN) {
+      size_t extended = i + MIN_RUN < hi ? i + MIN_RUN : hi;
+      insertionSort(array, i, end, extended, ctx);
+      end = extended;
+    }
+    bounds[++runs] = end;
+    i = end;
+  }
+
+  void **src = array, **dst = buffer;
+  while (runs > 1) {
+    size_t merged = 0;
+    for (size_t r = 0; r < runs; r += 2) {
+      size_t start = bounds[r], mid = bounds[r+1];
+      size_t end = r + 1 < runs ? bounds[r+2] : mid;
+      merge(src + start, mid - start, src + mid, end - mid, dst + start, ctx);
+      bounds[++merged] = end;
+    }
+    runs = merged;
+    void **tmp = src;  src = dst;  dst = tmp;
+  }
+  if (src != array) memcpy(array + lo, src + lo, (hi - lo) * sizeof(void*));
+  free(bounds);
+}
+
+
+/*                            */
+/*    PACKED KEYS             */
+/*                            */
+
+// packed keys sort as signed 64 bit integers; this one never occurs (see packKeys)
+#define PACKED_PAD INT64_MAX
+
+// branch free stable merge of packed keys a[0..na) and b[0..nb) into out
+static void mergePacked(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out)
+{
+  size_t i = 0, j = 0, k = 0;
+
+  while (i < na && j < nb) {
+    int64_t x = a[i], y = b[j];
+    bool take_b = y < x;
+    out[k++] = take_b ? y : x;
+    j += take_b;
+    i += !take_b;
+  }
+  memcpy(out + k, a + i, (na - i) * sizeof(int64_t));
+  memcpy(out + k + na - i, b + j, (nb - j) * sizeof(int64_t));
+}
+
+#define SWAP_IF_GREATER(x, y) do { int64_t _lo = x < y ? x : y, _hi = x < y ? y : x; x = _lo; y = _hi; } while (0)
+
+#define PACKED_BLOCK 32768        // keys sorted in cache before runs merge through memory
+
+typedef void (*packedMerge)(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out);
+
+// sorts runs of 4: keys[0..4), keys[4..8), ...
+static void sortFours(int64_t *keys, size_t n)
+{
+  for (size_t i = 0; i < n; i += 4) {
+    int64_t *v = keys + i;
+    SWAP_IF_GREATER(v[0], v[1]);  SWAP_IF_GREATER(v[2], v[3]);
+    SWAP_IF_GREATER(v[0], v[2]);  SWAP_IF_GREATER(v[1], v[3]);
+    SWAP_IF_GREATER(v[1], v[2]);
+  }
+}
+
+// merges the sorted runs of width keys[0..n) holds into one, using buffer; result in keys
+static void mergePasses(int64_t *keys, int64_t *buffer, size_t n, size_t width, packedMerge merge)
+{
+  int64_t *src = keys, *dst = buffer;
+  for (; width < n; width *= 2) {
+    for (size_t start = 0; start < n; start += 2 * width) {
+      size_t mid = start + width < n ? start + width : n;
+      size_t end = mid + width < n ? mid + width : n;
+      merge(src + start, mid - start, src + mid, end - mid, dst + start);
+    }
+    int64_t *tmp = src;  src = dst;  dst = tmp;
+  }
+  if (src != keys) memcpy(keys, src, n * sizeof(int64_t));
+}
+
+// sorts keys[0..n), n a multiple of 4, whose runs of 4 are sorted
+static void mergeBlocks(int64_t *keys, int64_t *buffer, size_t n, packedMerge merge)
+{
+  for (size_t block = 0; block < n; block += PACKED_BLOCK) {
+    size_t size = n - block < PACKED_BLOCK ? n - block : PACKED_BLOCK;
+    mergePasses(keys + block, buffer + block, size, 4, merge);
+  }
+  mergePasses(keys, buffer, n, PACKED_BLOCK, merge);
+}
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SORT_AVX2
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+static inline AVX2 __m256i min64(__m256i a, __m256i b)
+{
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline AVX2 __m256i max64(__m256i a, __m256i b)
+{
+  return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+// sorts a bitonic vector of 4
+static inline AVX2 __m256i bitonicSort4(__m256i v)
+{
+  __m256i t = _mm256_permute4x64_epi64(v, 0x4E);               // distance 2: lanes 2 3 0 1
+  v = _mm256_blend_epi32(min64(v, t), max64(v, t), 0xF0);
+  t = _mm256_permute4x64_epi64(v, 0xB1);                       // distance 1: lanes 1 0 3 2
+  return _mm256_blend_epi32(min64(v, t), max64(v, t), 0xCC);
+}
+
+// merges the sorted vectors a and b: the smallest 4 into *lo, the largest 4 into *hi, sorted
+static inline AVX2 void bitonicMerge4x4(__m256i a, __m256i b, __m256i *lo, __m256i *hi)
+{
+  b = _mm256_permute4x64_epi64(b, 0x1B);                       // reversed: a then b is bitonic
+  *lo = bitonicSort4(min64(a, b));
+  *hi = bitonicSort4(max64(a, b));
+}
+
+// merge of a[0..na) and b[0..nb), both of lengths multiple of 4, into out
+static AVX2 void mergePackedAVX2(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out)
+{
+  if (na == 0 || nb == 0 || a[na-1] <= b[0]) {
+    memcpy(out, a, na * sizeof(int64_t));
+    memcpy(out + na, b, nb * sizeof(int64_t));
+    return;
+  }
+
+  const int64_t *a_end = a + na, *b_end = b + nb;
+  __m256i low, high = _mm256_loadu_si256((const __m256i*)b);
+  __m256i next = _mm256_loadu_si256((const __m256i*)a);
+  a += 4;  b += 4;
+  for (;;) {
+    // high keeps the largest 4 seen; low, all smaller than what is left, goes out
+    bitonicMerge4x4(next, high, &low, &high);
+    _mm256_storeu_si256((__m256i*)out, low);
+    out += 4;
+    if (a == a_end && b == b_end) break;
+    // next block from the run with the smaller head, chosen without a branch to mispredict
+    int64_t head_a = a < a_end ? *a : INT64_MAX, head_b = b < b_end ? *b : INT64_MAX;
+    bool take_a = (b == b_end) | ((a < a_end) & (head_a < head_b));
+    next = _mm256_loadu_si256((const __m256i*)(take_a ? a : b));
+    a += take_a * 4;
+    b += !take_a * 4;
+  }
+  _mm256_storeu_si256((__m256i*)out, high);
+}
 
+// sortFours by sorting networks on the columns of 4 vectors, transposed into rows
+static AVX2 void sortFoursAVX2(int64_t *keys, size_t n)
+{
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i r0 = _mm256_loadu_si256((const __m256i*)(keys + i));
+    __m256i r1 = _mm256_loadu_si256((const __m256i*)(keys + i + 4));
+    __m256i r2 = _mm256_loadu_si256((const __m256i*)(keys + i + 8));
+    __m256i r3 = _mm256_loadu_si256((const __m256i*)(keys + i + 12));
+    __m256i t;
+    t = min64(r0, r1);  r1 = max64(r0, r1);  r0 = t;
+    t = min64(r2, r3);  r3 = max64(r2, r3);  r2 = t;
+    t = min64(r0, r2);  r2 = max64(r0, r2);  r0 = t;
+    t = min64(r1, r3);  r3 = max64(r1, r3);  r1 = t;
+    t = min64(r1, r2);  r2 = max64(r1, r2);  r1 = t;
+    __m256i t0 = _mm256_unpacklo_epi64(r0, r1), t1 = _mm256_unpackhi_epi64(r0, r1);
+    __m256i t2 = _mm256_unpacklo_epi64(r2, r3), t3 = _mm256_unpackhi_epi64(r2, r3);
+    _mm256_storeu_si256((__m256i*)(keys + i),      _mm256_permute2x128_si256(t0, t2, 0x20));
+    _mm256_storeu_si256((__m256i*)(keys + i + 4),  _mm256_permute2x128_si256(t1, t3, 0x20));
+    _mm256_storeu_si256((__m256i*)(keys + i + 8),  _mm256_permute2x128_si256(t0, t2, 0x31));
+    _mm256_storeu_si256((__m256i*)(keys + i + 12), _mm256_permute2x128_si256(t1, t3, 0x31));
+  }
+  sortFours(keys + i, n - i);
+}
+#endif
 
-void merge(int **array, int start, int mid, int end) {
+// sorts keys[0..n), n a multiple of 4, using buffer[0..n); result in keys
+static void sortPacked(int64_t *keys, int64_t *buffer, size_t n)
+{
+#ifdef SORT_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    sortFoursAVX2(keys, n);
+    mergeBlocks(keys, buffer, n, mergePackedAVX2);
+    return;
+  }
+#endif
+  sortFours(keys, n);
+  mergeBlocks(keys, buffer, n, mergePacked);
+}
 
-  int L_len = mid - start + 1;
-  int R_len = end - mid;
 
-  int *L[L_len];
-  int *R[R_len];
+/*                            */
+/*    RADIX SORT              */
+/*                            */
 
-  int L_i = start;
-  int R_i = mid + 1;
-  int arr_i = start;
+typedef struct keyIndex {
+  uint64_t key;               // unsigned, so 8 bit digits sort it from least to most significant
+  size_t index;
+} keyIndex;
 
-  for (int i = 0; i < L_len; i++) {
-	L[i] = array[L_i];
-	L_i += 1;
+// stable LSD radix sort of pairs[0..n) by key, 8 bits a pass, using buffer; returns the sorted array
+static keyIndex* radixSort(keyIndex *pairs, keyIndex *buffer, size_t n)
+{
+  size_t (*counts)[256] = calloc(8, sizeof(*counts));
+  if (!counts) {
+    perror("malloc");
+    fprintf(stderr, "failed to allocate memory\n");
+    exit(EXIT_FAILURE);
   }
-  for (int i = 0; i < R_len; i++) {
-	R[i] = array[R_i];
-	R_i += 1;
+  for (size_t i = 0; i < n; i++) {
+    for (int d = 0; d < 8; d++) counts[d][(pairs[i].key >> (8 * d)) & 0xFF]++;
   }
-  
-  L_i = 0;
-  R_i = 0;
-  while ( L_i < L_len && R_i < R_len )
-  {
-  	if ( *L[L_i] < *R[R_i] ) {  // only line in function that would be different if not for array of pointers
-	  array[arr_i] = L[L_i];
-	  arr_i += 1; L_i += 1;
-	} else {
-	  array[arr_i] = R[R_i];
-	  arr_i += 1; R_i += 1;
-	}
+
+  for (int d = 0; d < 8; d++) {
+    if (counts[d][(pairs[0].key >> (8 * d)) & 0xFF] == n) continue;   // same digit everywhere
+    size_t offset = 0;
+    for (int b = 0; b < 256; b++) {
+      size_t c = counts[d][b];
+      counts[d][b] = offset;
+      offset += c;
+    }
+    for (size_t i = 0; i < n; i++) {
+      buffer[counts[d][(pairs[i].key >> (8 * d)) & 0xFF]++] = pairs[i];
+    }
+    keyIndex *tmp = pairs;  pairs = buffer;  buffer = tmp;
   }
-  while ( R_i < R_len ) {
-	array[arr_i] = R[R_i];
-	arr_i += 1; R_i += 1;
+  free(counts);
+  return pairs;
+}
+
+
+/*                            */
+/*    THREADS                 */
+/*                            */
+
+typedef struct sortShared sortShared;
+
+struct sortShared {
+  void *array;                // elements sorted: record pointers or packed keys
+  void *buffer;
+  size_t n;
+  size_t elementSize;
+  unsigned int threads;
+  sortContext ctx;
+  void *src, *dst;            // this level merges from src into dst
+  size_t *segs;               // sorted segments: src[segs[i]..segs[i+1])
+  size_t numSegs;
+  // sorts array[lo..hi) into array, using buffer[lo..hi)
+  void (*sortChunk)(sortShared *shared, size_t lo, size_t hi);
+  // merges of src[start..mid) and src[mid..end) the part landing in dst[from..to)
+  void (*mergePart)(sortShared *shared, size_t start, size_t mid, size_t end, size_t from, size_t to);
+  pthread_barrier_t barrier;
+};
+
+typedef struct sortWorker {
+  sortShared *shared;
+  unsigned int id;
+} sortWorker;
+
+// number of elements of a in the first diag elements of the stable merge of a and b
+static size_t mergePath(void **a, size_t na, void **b, size_t nb, size_t diag, const sortContext *ctx)
+{
+  size_t lo = diag > nb ? diag - nb : 0;
+  size_t hi = diag < na ? diag : na;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (before(ctx, b[diag - mid - 1], a[mid])) hi = mid;
+    else lo = mid + 1;
   }
-  while ( L_i < L_len ) {
-	array[arr_i] = L[L_i];
-	arr_i += 1; L_i += 1;
+  return lo;
+}
+
+static size_t mergePathPacked(const int64_t *a, size_t na, const int64_t *b, size_t nb, size_t diag)
+{
+  size_t lo = diag > nb ? diag - nb : 0;
+  size_t hi = diag < na ? diag : na;
+
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (b[diag - mid - 1] < a[mid]) hi = mid;
+    else lo = mid + 1;
   }
+  return lo;
 }
 
-void mergeSort(int **array, int start, int end) {
+static void sortChunkPointers(sortShared *shared, size_t lo, size_t hi)
+{
+  sortRange(shared->array, shared->buffer, lo, hi, &shared->ctx);
+}
+
+static void mergePartPointers(sortShared *shared, size_t start, size_t mid, size_t end, size_t from, size_t to)
+{
+  void **a = (void**)shared->src + start, **b = (void**)shared->src + mid;
+  size_t na = mid - start, nb = end - mid;
+  size_t i0 = mergePath(a, na, b, nb, from - start, &shared->ctx);
+  size_t i1 = mergePath(a, na, b, nb, to - start, &shared->ctx);
+  size_t j0 = from - start - i0, j1 = to - start - i1;
+  merge(a + i0, i1 - i0, b + j0, j1 - j0, (void**)shared->dst + from, &shared->ctx);
+}
+
+static void sortChunkPacked(sortShared *shared, size_t lo, size_t hi)
+{
+  sortPacked((int64_t*)shared->array + lo, (int64_t*)shared->buffer + lo, hi - lo);
+}
+
+static void mergePartPacked(sortShared *shared, size_t start, size_t mid, size_t end, size_t from, size_t to)
+{
+  const int64_t *a = (int64_t*)shared->src + start, *b = (int64_t*)shared->src + mid;
+  size_t na = mid - start, nb = end - mid;
+  size_t i0 = mergePathPacked(a, na, b, nb, from - start);
+  size_t i1 = mergePathPacked(a, na, b, nb, to - start);
+  size_t j0 = from - start - i0, j1 = to - start - i1;
+  mergePacked(a + i0, i1 - i0, b + j0, j1 - j0, (int64_t*)shared->dst + from);
+}
 
-  if (start >= end) {
-	return;
+// merges the part of the current level that lands in dst[lo..hi)
+static void mergeLevel(sortShared *shared, size_t lo, size_t hi)
+{
+  for (size_t s = 0; s < shared->numSegs; s += 2) {
+    size_t start = shared->segs[s], mid = shared->segs[s+1];
+    size_t end = s + 1 < shared->numSegs ? shared->segs[s+2] : mid;
+    size_t from = lo > start ? lo : start;
+    size_t to   = hi < end ? hi : end;
+    if (from < to) shared->mergePart(shared, start, mid, end, from, to);
   }
+}
 
-  int mid = (start + end) / 2;
+static void sortRun(sortShared *shared, unsigned int id)
+{
+  size_t lo = shared->n * id / shared->threads;
+  size_t hi = shared->n * (id + 1) / shared->threads;
 
-  mergeSort(array, start, mid);
-  mergeSort(array, mid+1, end);
-  merge(array, start, mid, end);
+  shared->sortChunk(shared, shared->segs[id], shared->segs[id+1]);
+  pthread_barrier_wait(&shared->barrier);         // chunks sorted
+
+  while (shared->numSegs > 1) {
+    mergeLevel(shared, lo, hi);
+    pthread_barrier_wait(&shared->barrier);       // level merged
+    if (id == 0) {
+      size_t merged = 0;
+      for (size_t s = 0; s < shared->numSegs; s += 2) {
+	shared->segs[++merged] = s + 1 < shared->numSegs ? shared->segs[s+2] : shared->segs[s+1];
+      }
+      shared->numSegs = merged;
+      void *tmp = shared->src;  shared->src = shared->dst;  shared->dst = tmp;
+    }
+    pthread_barrier_wait(&shared->barrier);       // next level ready
+  }
+  if (shared->src != shared->array) {
+    memcpy((char*)shared->array + lo * shared->elementSize, (char*)shared->src + lo * shared->elementSize,
+	   (hi - lo) * shared->elementSize);
+  }
 }
 
+static void* sortWorkerRun(void *worker)
+{
+  sortRun(((sortWorker*)worker)->shared, ((sortWorker*)worker)->id);
+  return NULL;
+}
 
+static unsigned int sortThreads(unsigned int threads, size_t n)
+{
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? online : 1;
+  }
+  if (threads > n / MIN_PARALLEL) threads = n / MIN_PARALLEL;
+  return threads ? threads : 1;
+}
 
-// take notice to how we instantiate the array of pointers.
-// if you declare this array and work with it you may be accessing
-// locations in memory that are unsafe.
-//
-int main(void) {
+// sorts shared->array with shared->threads threads; chunk bounds are multiples of align
+static void sortWithThreads(sortShared *shared, size_t align)
+{
+  unsigned int threads = shared->threads;
 
-  int arr[] = { -6, -24, 0, -8, 5, 22, 45, -17, 31, 36, 26, -26, 37, 0, 31, 36, 21, -26, -44, -21, -21, 12, -8, -25, 48 };
-  int arr_size = sizeof(arr) / sizeof(arr[0]);
-  
-  int *result[arr_size];
-  for (int i = 0; i < arr_size; i++) {
-	result[i] = &arr[i];
+  if (threads == 1) {
+    shared->sortChunk(shared, 0, shared->n);
+    return;
   }
 
-  mergeSort(result, 0, arr_size - 1);
+  shared->src  = shared->array;
+  shared->dst  = shared->buffer;
+  shared->segs = sortMalloc(sizeof(size_t) * (threads + 1));
+  for (unsigned int t = 0; t <= threads; t++) shared->segs[t] = shared->n / align * t / threads * align;
+  shared->segs[threads] = shared->n;
+  shared->numSegs = threads;
 
-  for (int i = 0; i < arr_size; i++) {
-	printf("%d, ", arr[i]);
+  pthread_barrier_init(&shared->barrier, NULL, threads);
+  pthread_t  *workers = sortMalloc(sizeof(pthread_t) * threads);
+  sortWorker *args    = sortMalloc(sizeof(sortWorker) * threads);
+  for (unsigned int t = 0; t < threads; t++) {
+    args[t].shared = shared;
+    args[t].id = t;
   }
+  for (unsigned int t = 1; t < threads; t++) {
+    if (pthread_create(&workers[t], NULL, sortWorkerRun, &args[t])) {
+      perror("pthread_create");  exit(EXIT_FAILURE);
+    }
+  }
+  sortRun(shared, 0);
+  for (unsigned int t = 1; t < threads; t++) { pthread_join(workers[t], NULL); }
+  pthread_barrier_destroy(&shared->barrier);
+
+  free(workers);
+  free(args);
+  free(shared->segs);
+}
+
+
+/*                            */
+/*    SORT FUNCTIONS          */
+/*                            */
+
+void mergeSortPointers(void **array, size_t n, mergeSortCompare compare, void *arg,
+		       unsigned int threads)
+{
+  if (n < 2) return;
+
+  sortShared shared;
+  shared.array       = array;
+  shared.buffer      = sortMalloc(sizeof(void*) * n);
+  shared.n           = n;
+  shared.elementSize = sizeof(void*);
+  shared.threads     = sortThreads(threads, n);
+  shared.ctx.compare = compare;
+  shared.ctx.arg     = arg;
+  shared.sortChunk   = sortChunkPointers;
+  shared.mergePart   = mergePartPointers;
+
+  sortWithThreads(&shared, 1);
+  free(shared.buffer);
+}
+
 
-  printf("\n");
+// (key - min, index) pairs sorted by radix sort, then the pointers in the order of the indices
+static void sortByRadix(void **array, size_t n, const int64_t *keys, int64_t min)
+{
+  keyIndex *pairs  = sortMalloc(sizeof(keyIndex) * n);
+  keyIndex *buffer = sortMalloc(sizeof(keyIndex) * n);
 
-  for (int i = 0; i < arr_size; i++) {
-	printf("%d, ", *result[i]);
+  for (size_t i = 0; i < n; i++) {
+    pairs[i].key = (uint64_t)keys[i] - (uint64_t)min;        // in key order, high bytes 0 if range small
+    pairs[i].index = i;
   }
+  keyIndex *sorted = radixSort(pairs, buffer, n);
 
-  return 0;
+  void **original = (void**)(sorted == pairs ? buffer : pairs);        // the other array is free
+  memcpy(original, array, n * sizeof(void*));
+  for (size_t i = 0; i < n; i++) array[i] = original[sorted[i].index];
+  free(pairs);
+  free(buffer);
 }
 
+void mergeSortPointersByKey(void **array, size_t n, mergeSortKey key, void *arg,
+			    unsigned int threads)
+{
+  if (n < 2) return;
+
+  // the only pass over the records: every later step reads the keys alone
+  size_t padded = (n + 3) & ~(size_t)3;
+  int64_t *keys = sortMalloc(sizeof(int64_t) * padded);
+  int64_t min = INT64_MAX, max = INT64_MIN;
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = key(array[i], arg);
+    if (keys[i] < min) min = keys[i];
+    if (keys[i] > max) max = keys[i];
+  }
+
+  threads = sortThreads(threads, padded);
+  if (threads == 1 || (uint64_t)max - (uint64_t)min > UINT32_MAX || n >= UINT32_MAX) {
+    sortByRadix(array, n, keys, min);
+    free(keys);
+    return;
+  }
+
+  // (key - min) in the high half, index in the low half: distinct, and in key then index order,
+  // so any sort of them is stable. Sign bit flipped to sort as int64; index < UINT32_MAX, so no
+  // packed key is PACKED_PAD.
+  for (size_t i = 0; i < n; i++) {
+    uint64_t packed = ((uint64_t)keys[i] - (uint64_t)min) << 32 | i;
+    keys[i] = (int64_t)(packed ^ (UINT64_C(1) << 63));
+  }
+  for (size_t i = n; i < padded; i++) keys[i] = PACKED_PAD;
+
+  sortShared shared;
+  shared.array       = keys;
+  shared.buffer      = sortMalloc(sizeof(int64_t) * padded);
+  shared.n           = padded;
+  shared.elementSize = sizeof(int64_t);
+  shared.threads     = threads;
+  shared.sortChunk   = sortChunkPacked;
+  shared.mergePart   = mergePartPacked;
+  sortWithThreads(&shared, 4);
+
+  void **original = shared.buffer;                           // done with: at least n pointers long
+  memcpy(original, array, n * sizeof(void*));
+  for (size_t i = 0; i < n; i++) array[i] = original[(uint32_t)keys[i]];
+  free(shared.buffer);
+  free(keys);
+}
+
+
+static int compareInts(const void *a, const void *b, void *arg)
+{
+  (void)arg;
+  return (*(const int*)a > *(const int*)b) - (*(const int*)a < *(const int*)b);
+}
+
+void mergeSort(int **array, int start, int end)
+{
+  if (start >= end) return;
+
+  // int* and void* may differ in representation: sort a copy of the pointers as void*
+  size_t n = end - start + 1;
+  void **pointers = sortMalloc(sizeof(void*) * n);
+  for (size_t i = 0; i < n; i++) pointers[i] = array[start + i];
+  mergeSortPointers(pointers, n, compareInts, NULL, 1);
+  for (size_t i = 0; i < n; i++) array[start + i] = pointers[i];
+  free(pointers);
+}